@@ -103,6 +103,7 @@ typedef struct in6_addr t_tun_in6_addr;
 #define TUNTAP_MODE_ETHERNET 0x0001
 #define TUNTAP_MODE_TUNNEL 0x0002
 #define TUNTAP_MODE_PERSIST 0x0004
+#define TUNTAP_MODE_MULTIQUEUE 0x0008
 
 #define TUNTAP_LOG_NONE 0x0000
 #define TUNTAP_LOG_DEBUG 0x0001
@@ -214,6 +215,12 @@ extern "C"
   tuntap_get_readable(struct device *);
   TUNTAP_EXPORT int
   tuntap_set_nonblocking(struct device *dev, int);
+#if defined(__linux__)
+  /* attach one more queue to a device started with TUNTAP_MODE_MULTIQUEUE,
+   * returns its non blocking fd or -1 */
+  TUNTAP_EXPORT int
+  tuntap_add_queue(struct device *dev);
+#endif
   TUNTAP_EXPORT int
   tuntap_set_debug(struct device *dev, int);
 
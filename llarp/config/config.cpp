@@ -161,6 +161,12 @@ namespace llarp
         LogDebug("set to use ", m_numNetThreads, " net threads");
       }
     }
+    if(key == "link-crypto-pipeline")
+    {
+      m_linkCryptoPipeline = IsTrueValue(val);
+      LogDebug("link crypto pipeline ",
+               m_linkCryptoPipeline ? "enabled" : "disabled");
+    }
     if(key == "block-bogons")
     {
       m_blockBogons = setOptBool(val);
@@ -554,6 +560,8 @@ llarp_generic_ensure_config(std::ofstream &f, std::string basepath,
   f << "[router]\n";
   f << "# number of crypto worker threads \n";
   f << "threads=4\n";
+  f << "# uncomment to do per packet link crypto on the worker threads\n";
+  f << "#link-crypto-pipeline=true\n";
   f << "# path to store signed RC\n";
   f << "contact-file=" << basepath << "self.signed\n";
   f << "# path to store transport private key\n";
@@ -121,6 +121,9 @@ namespace llarp
     int m_workerThreads = 1;
     int m_numNetThreads = 1;
 
+    /// do per packet link crypto on the worker threads
+    bool m_linkCryptoPipeline = false;
+
     std::string m_DefaultLinkProto = "iwp";
 
    public:
@@ -138,6 +141,7 @@ namespace llarp
     const AddressInfo& addrInfo() const        { return m_addrInfo; }
     int workerThreads() const                  { return fromEnv(m_workerThreads, "WORKER_THREADS"); }
     int numNetThreads() const                  { return fromEnv(m_numNetThreads, "NUM_NET_THREADS"); }
+    bool linkCryptoPipeline() const            { return fromEnv(m_linkCryptoPipeline, "LINK_CRYPTO_PIPELINE"); }
     std::string defaultLinkProto() const       { return fromEnv(m_DefaultLinkProto, "LINK_PROTO"); }
     absl::optional< bool > blockBogons() const { return fromEnv(m_blockBogons, "BLOCK_BOGONS"); }
     // clang-format on
@@ -19,6 +19,8 @@ namespace llarp
     constexpr llarp_time_t default_lifetime = 10 * 60 * 1000;
     /// after this many ms a path build times out
     constexpr llarp_time_t build_timeout = 30000;
+    /// ephemeral keys kept ready for builds, each hop takes two
+    constexpr std::size_t key_pool_size = 16 * 2 * default_len;
 
     /// measure latency every this interval ms
     constexpr llarp_time_t latency_interval = 5000;
@@ -264,7 +264,10 @@ __        ___    ____  _   _ ___ _   _  ____
 
     // run net io thread
     llarp::LogInfo("running mainloop");
+    // the log stream is configured by now, print lines off the hot threads
+    LogContext::Instance().StartWriter();
     llarp_ev_loop_run_single_process(mainloop, logic);
+    LogContext::Instance().StopWriter();
     // waits for router graceful stop
     return 0;
   }
@@ -20,6 +20,23 @@
 
 namespace llarp
 {
+  /// one layer of onion crypto: a path hop's shared key and the hash its
+  /// nonce gets mutated with
+  struct OnionLayer
+  {
+    const SharedSecret *key;
+    const ShortHash *nonceXOR;
+  };
+
+  /// a buffer run through the onion layers in place and the nonce the first
+  /// layer starts from
+  struct OnionPacket
+  {
+    byte_t *data;
+    size_t sz;
+    TunnelNonce nonce;
+  };
+
   /// library crypto configuration
   struct Crypto
   {
@@ -35,6 +52,13 @@ namespace llarp
     xchacha20_alt(const llarp_buffer_t &, const llarp_buffer_t &,
                   const SharedSecret &, const byte_t *) = 0;
 
+    /// xchacha20 every packet through every layer in order, the nonce is
+    /// xor'd with a layer's nonceXOR before that layer when xorFirst is set
+    /// and after it otherwise
+    virtual bool
+    onion_batch(OnionPacket *packets, size_t numPackets,
+                const OnionLayer *layers, size_t numLayers, bool xorFirst) = 0;
+
     /// path dh creator's side
     virtual bool
     dh_client(SharedSecret &, const PubKey &, const SecretKey &,
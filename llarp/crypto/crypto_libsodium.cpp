@@ -1,10 +1,15 @@
 #include <crypto/crypto_libsodium.hpp>
+#include <sodium/crypto_core_hchacha20.h>
 #include <sodium/crypto_generichash.h>
 #include <sodium/crypto_sign.h>
 #include <sodium/crypto_scalarmult.h>
+#include <sodium/crypto_stream_chacha20.h>
 #include <sodium/crypto_stream_xchacha20.h>
+#include <sodium/utils.h>
 #include <util/mem.hpp>
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 
 extern "C"
@@ -109,6 +114,62 @@ namespace llarp
           == 0;
     }
 
+    /// layers whose subkeys we hold at once, a full length path
+    static constexpr size_t OnionChunkLayers = 8;
+    /// bytes run through every layer before moving on, a multiple of the
+    /// chacha20 block size that stays in L1 across layers
+    static constexpr size_t OnionChunkSize = 1024;
+
+    bool
+    CryptoLibSodium::onion_batch(OnionPacket *packets, size_t numPackets,
+                                 const OnionLayer *layers, size_t numLayers,
+                                 bool xorFirst)
+    {
+      // the xchacha20 subkey depends on the nonce so it is derived per packet
+      // and layer, what we save is a pass over the whole buffer per layer
+      std::array< std::array< byte_t, crypto_core_hchacha20_OUTPUTBYTES >,
+                  OnionChunkLayers >
+          subkeys;
+      std::array< TunnelNonce, OnionChunkLayers > nonces;
+      bool ok = true;
+      for(size_t idx = 0; ok && idx < numPackets; ++idx)
+      {
+        auto &pkt     = packets[idx];
+        TunnelNonce n = pkt.nonce;
+        for(size_t first = 0; ok && first < numLayers;
+            first += OnionChunkLayers)
+        {
+          const size_t count = std::min(OnionChunkLayers, numLayers - first);
+          for(size_t layer = 0; layer < count; ++layer)
+          {
+            const auto &l = layers[first + layer];
+            if(xorFirst)
+              n ^= *l.nonceXOR;
+            nonces[layer] = n;
+            crypto_core_hchacha20(subkeys[layer].data(), n.data(),
+                                  l.key->data(), nullptr);
+            if(!xorFirst)
+              n ^= *l.nonceXOR;
+          }
+          for(size_t off = 0; ok && off < pkt.sz; off += OnionChunkSize)
+          {
+            const size_t len = std::min(OnionChunkSize, pkt.sz - off);
+            byte_t *ptr      = pkt.data + off;
+            for(size_t layer = 0; ok && layer < count; ++layer)
+            {
+              ok = crypto_stream_chacha20_xor_ic(
+                       ptr, ptr, len,
+                       nonces[layer].data() + crypto_core_hchacha20_INPUTBYTES,
+                       off / 64, subkeys[layer].data())
+                  == 0;
+            }
+          }
+        }
+      }
+      sodium_memzero(subkeys.data(), sizeof(subkeys));
+      return ok;
+    }
+
     bool
     CryptoLibSodium::dh_client(llarp::SharedSecret &shared, const PubKey &pk,
                                const SecretKey &sk, const TunnelNonce &n)
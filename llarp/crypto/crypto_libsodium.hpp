@@ -23,6 +23,12 @@ namespace llarp
       xchacha20_alt(const llarp_buffer_t &, const llarp_buffer_t &,
                     const SharedSecret &, const byte_t *) override;
 
+      /// onion crypto for many packets through many layers
+      bool
+      onion_batch(OnionPacket *packets, size_t numPackets,
+                  const OnionLayer *layers, size_t numLayers,
+                  bool xorFirst) override;
+
       /// path dh creator's side
       bool
       dh_client(SharedSecret &, const PubKey &, const SecretKey &,
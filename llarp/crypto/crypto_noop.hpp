@@ -29,6 +29,13 @@ namespace llarp
       return true;
     }
 
+    bool
+    onion_batch(OnionPacket *, size_t, const OnionLayer *, size_t,
+                bool) override
+    {
+      return true;
+    }
+
     bool
     xchacha20_alt(const llarp_buffer_t &out, const llarp_buffer_t &in,
                   const SharedSecret &, const byte_t *) override
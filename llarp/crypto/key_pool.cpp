@@ -0,0 +1,66 @@
+#include <crypto/key_pool.hpp>
+
+#include <crypto/crypto.hpp>
+#include <util/thread/thread_pool.hpp>
+
+namespace llarp
+{
+  EncryptionKeyPool::EncryptionKeyPool(
+      size_t capacity, std::shared_ptr< thread::ThreadPool > worker)
+      : m_Capacity(capacity), m_Worker(std::move(worker)), m_Refilling(false)
+  {
+    m_Keys.reserve(m_Capacity);
+  }
+
+  bool
+  EncryptionKeyPool::Take(SecretKey& key)
+  {
+    util::Lock lock(&m_Access);
+    if(m_Keys.empty())
+      return false;
+    key = m_Keys.back();
+    m_Keys.pop_back();
+    return true;
+  }
+
+  bool
+  EncryptionKeyPool::ScheduleRefill()
+  {
+    if(m_Worker == nullptr || Size() >= m_Capacity / 2
+       || m_Refilling.exchange(true))
+      return false;
+    auto self = shared_from_this();
+    if(m_Worker->tryAddJob([self]() { self->Refill(); }))
+      return true;
+    m_Refilling.store(false);
+    return false;
+  }
+
+  void
+  EncryptionKeyPool::Refill()
+  {
+    size_t want = m_Capacity - Size();
+    auto crypto = CryptoManager::instance();
+    // generate outside the lock so builds can keep taking keys
+    std::vector< SecretKey > fresh(want);
+    for(auto& key : fresh)
+      crypto->encryption_keygen(key);
+    {
+      util::Lock lock(&m_Access);
+      for(auto& key : fresh)
+      {
+        if(m_Keys.size() == m_Capacity)
+          break;
+        m_Keys.emplace_back(std::move(key));
+      }
+    }
+    m_Refilling.store(false);
+  }
+
+  size_t
+  EncryptionKeyPool::Size() const
+  {
+    util::Lock lock(&m_Access);
+    return m_Keys.size();
+  }
+}  // namespace llarp
@@ -0,0 +1,62 @@
+#ifndef LLARP_CRYPTO_KEY_POOL_HPP
+#define LLARP_CRYPTO_KEY_POOL_HPP
+
+#include <crypto/types.hpp>
+#include <util/thread/threading.hpp>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace llarp
+{
+  namespace thread
+  {
+    class ThreadPool;
+  }
+
+  /// ephemeral x25519 keypairs generated ahead of time so path builds can
+  /// take them without waiting on keygen, topped back up on the worker once
+  /// it drops below half full.
+  struct EncryptionKeyPool
+      : public std::enable_shared_from_this< EncryptionKeyPool >
+  {
+    EncryptionKeyPool(size_t capacity,
+                      std::shared_ptr< thread::ThreadPool > worker);
+
+    /// take a precomputed keypair, returns false if we ran dry in which case
+    /// the caller generates its own
+    bool
+    Take(SecretKey& key);
+
+    /// queue a refill on the worker if we are below half full and one is not
+    /// already queued, returns false if nothing was queued. builds call this
+    /// after queueing their own jobs so the refill runs behind them.
+    bool
+    ScheduleRefill();
+
+    /// generate keypairs until full, blocking
+    void
+    Refill();
+
+    size_t
+    Size() const;
+
+    size_t
+    Capacity() const
+    {
+      return m_Capacity;
+    }
+
+   private:
+    const size_t m_Capacity;
+    std::shared_ptr< thread::ThreadPool > m_Worker;
+    std::atomic< bool > m_Refilling;
+    mutable util::Mutex m_Access;
+    std::vector< SecretKey > m_Keys GUARDED_BY(m_Access);
+  };
+
+  using EncryptionKeyPool_ptr = std::shared_ptr< EncryptionKeyPool >;
+}  // namespace llarp
+
+#endif
@@ -0,0 +1,114 @@
+#include <crypto/verify_cache.hpp>
+
+#include <crypto/crypto.hpp>
+
+#include <algorithm>
+
+namespace llarp
+{
+  constexpr size_t VerifyCache::Shards;
+  constexpr size_t VerifyCache::DefaultCapacity;
+  constexpr llarp_time_t VerifyCache::DefaultLifetime;
+
+  VerifyCache::VerifyCache(size_t capacity, llarp_time_t lifetime)
+      : m_ShardCapacity(std::max(capacity / Shards, size_t(1)))
+      , m_Lifetime(lifetime)
+      , m_Hits(0)
+      , m_Misses(0)
+  {
+  }
+
+  VerifyCache &
+  VerifyCache::Default()
+  {
+    static VerifyCache cache;
+    return cache;
+  }
+
+  VerifyCache::Shard &
+  VerifyCache::ShardFor(const Key &k)
+  {
+    return m_Shards[k.digest[0] % Shards];
+  }
+
+  bool
+  VerifyCache::Verify(const PubKey &signer, const llarp_buffer_t &signed_buf,
+                      const Signature &sig, llarp_time_t now)
+  {
+    auto crypto = CryptoManager::instance();
+    Key k;
+    k.signer = signer;
+    k.sig    = sig;
+    if(!crypto->shorthash(k.digest, signed_buf))
+      return crypto->verify(signer, signed_buf, sig);
+
+    Shard &shard = ShardFor(k);
+    {
+      util::Lock lock(&shard.access);
+      auto itr = shard.entries.find(k);
+      if(itr != shard.entries.end() && now < itr->second)
+      {
+        ++m_Hits;
+        return true;
+      }
+    }
+    ++m_Misses;
+    // verify outside the lock so other lookups on this shard are not held up
+    if(!crypto->verify(signer, signed_buf, sig))
+      return false;
+
+    util::Lock lock(&shard.access);
+    auto inserted = shard.entries.emplace(k, now + m_Lifetime);
+    if(!inserted.second)
+    {
+      // expired or raced with another verify, keep its place in order
+      inserted.first->second = now + m_Lifetime;
+      return true;
+    }
+    shard.order.emplace_back(k);
+    while(shard.order.size() > m_ShardCapacity)
+    {
+      shard.entries.erase(shard.order.front());
+      shard.order.pop_front();
+    }
+    return true;
+  }
+
+  size_t
+  VerifyCache::size() const
+  {
+    size_t sz = 0;
+    for(const auto &shard : m_Shards)
+    {
+      util::Lock lock(&shard.access);
+      sz += shard.entries.size();
+    }
+    return sz;
+  }
+
+  void
+  VerifyCache::Clear()
+  {
+    for(auto &shard : m_Shards)
+    {
+      util::Lock lock(&shard.access);
+      shard.entries.clear();
+      shard.order.clear();
+    }
+    m_Hits   = 0;
+    m_Misses = 0;
+  }
+
+  util::StatusObject
+  VerifyCache::ExtractStatus() const
+  {
+    const uint64_t hits   = Hits();
+    const uint64_t misses = Misses();
+    const uint64_t total  = hits + misses;
+    return util::StatusObject{
+        {"size", uint64_t(size())},
+        {"hits", hits},
+        {"misses", misses},
+        {"hitRate", total ? double(hits) / double(total) : 0.0}};
+  }
+}  // namespace llarp
@@ -0,0 +1,106 @@
+#ifndef LLARP_CRYPTO_VERIFY_CACHE_HPP
+#define LLARP_CRYPTO_VERIFY_CACHE_HPP
+
+#include <crypto/types.hpp>
+#include <util/buffer.hpp>
+#include <util/status.hpp>
+#include <util/thread/threading.hpp>
+#include <util/types.hpp>
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <unordered_map>
+
+namespace llarp
+{
+  /// signatures we already checked, keyed by signer, signature and a digest
+  /// of what was signed, so an rc or introset we see again on gossip, dht
+  /// replies or link intros skips ed25519. only good signatures are kept.
+  struct VerifyCache
+  {
+    /// how many independently locked parts the cache is split into
+    static constexpr size_t Shards = 16;
+    static constexpr size_t DefaultCapacity = 8192;
+    /// how long a good signature stays good before we check it again
+    static constexpr llarp_time_t DefaultLifetime = 10 * 60 * 1000;
+
+    explicit VerifyCache(size_t capacity    = DefaultCapacity,
+                         llarp_time_t lifetime = DefaultLifetime);
+
+    /// the cache shared by everything we decode off the network
+    static VerifyCache &
+    Default();
+
+    /// ed25519 verify sig by signer over signed unless we already did
+    bool
+    Verify(const PubKey &signer, const llarp_buffer_t &signed_buf,
+           const Signature &sig, llarp_time_t now);
+
+    size_t
+    size() const;
+
+    uint64_t
+    Hits() const
+    {
+      return m_Hits.load();
+    }
+
+    uint64_t
+    Misses() const
+    {
+      return m_Misses.load();
+    }
+
+    void
+    Clear();
+
+    util::StatusObject
+    ExtractStatus() const;
+
+   private:
+    struct Key
+    {
+      PubKey signer;
+      Signature sig;
+      ShortHash digest;
+
+      bool
+      operator==(const Key &other) const
+      {
+        return digest == other.digest && sig == other.sig
+            && signer == other.signer;
+      }
+
+      struct Hash
+      {
+        size_t
+        operator()(const Key &k) const
+        {
+          return ShortHash::Hash()(k.digest);
+        }
+      };
+    };
+
+    struct Shard
+    {
+      mutable util::Mutex access;
+      /// verified until
+      std::unordered_map< Key, llarp_time_t, Key::Hash > entries
+          GUARDED_BY(access);
+      /// keys of entries oldest first
+      std::deque< Key > order GUARDED_BY(access);
+    };
+
+    Shard &
+    ShardFor(const Key &k);
+
+    const size_t m_ShardCapacity;
+    const llarp_time_t m_Lifetime;
+    std::array< Shard, Shards > m_Shards;
+    std::atomic< uint64_t > m_Hits;
+    std::atomic< uint64_t > m_Misses;
+  };
+}  // namespace llarp
+
+#endif
@@ -1 +1,73 @@
 #include <dht/bucket.hpp>
+
+#include <util/endian.hpp>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+namespace llarp
+{
+  namespace dht
+  {
+    constexpr size_t KeyTable::ScanBlock;
+
+    /// there is no unsigned 64 bit compare so we flip the sign bits and
+    /// compare signed, target brings its flip along with the xor
+    static constexpr uint64_t SignBit = uint64_t(1) << 63;
+
+    uint64_t
+    KeyTable::Prefix(const Key_t& key)
+    {
+      return bufbe64toh(key.data());
+    }
+
+    size_t
+    KeyTable::ScanPrefixes(const uint64_t* prefixes, size_t begin, size_t end,
+                           uint64_t target, uint64_t bound, uint32_t* hits)
+    {
+      size_t num = 0;
+      size_t idx = begin;
+#if defined(__AVX2__)
+      const __m256i t = _mm256_set1_epi64x(int64_t(target ^ SignBit));
+      const __m256i b = _mm256_set1_epi64x(int64_t(bound ^ SignBit));
+      for(; idx + 4 <= end; idx += 4)
+      {
+        const __m256i p = _mm256_loadu_si256(
+            reinterpret_cast< const __m256i* >(prefixes + idx));
+        const __m256i far = _mm256_cmpgt_epi64(_mm256_xor_si256(p, t), b);
+        const int near =
+            ~_mm256_movemask_pd(_mm256_castsi256_pd(far)) & 0xf;
+        for(int bit = 0; bit < 4; ++bit)
+        {
+          if(near & (1 << bit))
+            hits[num++] = uint32_t(idx + bit);
+        }
+      }
+#elif defined(__SSE4_2__)
+      const __m128i t = _mm_set1_epi64x(int64_t(target ^ SignBit));
+      const __m128i b = _mm_set1_epi64x(int64_t(bound ^ SignBit));
+      for(; idx + 2 <= end; idx += 2)
+      {
+        const __m128i p =
+            _mm_loadu_si128(reinterpret_cast< const __m128i* >(prefixes + idx));
+        const __m128i far = _mm_cmpgt_epi64(_mm_xor_si128(p, t), b);
+        const int near    = ~_mm_movemask_pd(_mm_castsi128_pd(far)) & 0x3;
+        for(int bit = 0; bit < 2; ++bit)
+        {
+          if(near & (1 << bit))
+            hits[num++] = uint32_t(idx + bit);
+        }
+      }
+#endif
+      for(; idx < end; ++idx)
+      {
+        if((prefixes[idx] ^ target) <= bound)
+          hits[num++] = uint32_t(idx);
+      }
+      return num;
+    }
+  }  // namespace dht
+}  // namespace llarp
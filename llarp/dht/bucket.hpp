@@ -1,26 +1,133 @@
 #ifndef LLARP_DHT_BUCKET_HPP
 #define LLARP_DHT_BUCKET_HPP
 
-#include <dht/kademlia.hpp>
 #include <dht/key.hpp>
+#include <util/logging/logger.hpp>
 #include <util/status.hpp>
 
-#include <map>
+#include <algorithm>
+#include <functional>
 #include <set>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace llarp
 {
   namespace dht
   {
+    /// keys laid out flat for closest by xor distance scans, the first 8
+    /// bytes of every key also sit in their own array so the scan can throw
+    /// out most keys 4 at a time without touching the rest of them
+    struct KeyTable
+    {
+      /// how many keys we filter before looking at what got through
+      static constexpr size_t ScanBlock = 256;
+
+      void
+      Add(const Key_t& key)
+      {
+        m_Keys.emplace_back(key);
+        m_Prefixes.emplace_back(Prefix(key));
+      }
+
+      /// remove the key at idx by moving the last key into its place
+      void
+      RemoveAt(size_t idx)
+      {
+        m_Keys[idx]     = m_Keys.back();
+        m_Prefixes[idx] = m_Prefixes.back();
+        m_Keys.pop_back();
+        m_Prefixes.pop_back();
+      }
+
+      void
+      Clear()
+      {
+        m_Keys.clear();
+        m_Prefixes.clear();
+      }
+
+      size_t
+      size() const
+      {
+        return m_Keys.size();
+      }
+
+      const Key_t& operator[](size_t idx) const
+      {
+        return m_Keys[idx];
+      }
+
+      /// put the indexes of the k keys closest to target into result,
+      /// closest first, skipping every index skip returns true for
+      template < typename Skip_t >
+      void
+      Closest(const Key_t& target, size_t k, Skip_t skip,
+              std::vector< size_t >& result) const
+      {
+        result.clear();
+        if(k == 0)
+          return;
+        const uint64_t prefix = Prefix(target);
+        // max heap of the closest so far, its front is what we beat next
+        std::vector< std::pair< Key_t, size_t > > best;
+        uint64_t bound = ~uint64_t(0);
+        uint32_t hits[ScanBlock];
+        for(size_t begin = 0; begin < size(); begin += ScanBlock)
+        {
+          const size_t end = std::min(size(), begin + ScanBlock);
+          const size_t num = ScanPrefixes(m_Prefixes.data(), begin, end,
+                                          prefix, bound, hits);
+          for(size_t idx = 0; idx < num; ++idx)
+          {
+            const size_t hit = hits[idx];
+            if(skip(hit))
+              continue;
+            Key_t dist = m_Keys[hit] ^ target;
+            if(best.size() == k)
+            {
+              if(not(dist < best.front().first))
+                continue;
+              std::pop_heap(best.begin(), best.end());
+              best.back() = {std::move(dist), hit};
+            }
+            else
+              best.emplace_back(std::move(dist), hit);
+            std::push_heap(best.begin(), best.end());
+            if(best.size() == k)
+              bound = Prefix(best.front().first);
+          }
+        }
+        std::sort_heap(best.begin(), best.end());
+        for(const auto& item : best)
+          result.emplace_back(item.second);
+      }
+
+      /// the first 8 bytes of key as a big endian integer so they order
+      /// like the key does
+      static uint64_t
+      Prefix(const Key_t& key);
+
+      /// put the indexes in [begin, end) whose prefix xor target is at most
+      /// bound into hits and return how many
+      static size_t
+      ScanPrefixes(const uint64_t* prefixes, size_t begin, size_t end,
+                   uint64_t target, uint64_t bound, uint32_t* hits);
+
+     private:
+      std::vector< Key_t > m_Keys;
+      std::vector< uint64_t > m_Prefixes;
+    };
+
+    /// our routing table, values are kept next to a flat KeyTable so
+    /// closest k lookups are a single scan instead of k walks of a tree
     template < typename Val_t >
     struct Bucket
     {
-      using BucketStorage_t = std::map< Key_t, Val_t, XorMetric >;
-      using Random_t        = std::function< uint64_t() >;
+      using Random_t = std::function< uint64_t() >;
 
-      Bucket(const Key_t& us, Random_t r)
-          : nodes(XorMetric(us)), random(std::move(r))
+      explicit Bucket(Random_t r) : random(std::move(r))
       {
       }
 
@@ -28,9 +135,9 @@ namespace llarp
       ExtractStatus() const
       {
         util::StatusObject obj{};
-        for(const auto& item : nodes)
+        for(size_t idx = 0; idx < m_Vals.size(); ++idx)
         {
-          obj[item.first.ToString()] = item.second.ExtractStatus();
+          obj[m_Keys[idx].ToString()] = m_Vals[idx].ExtractStatus();
         }
         return obj;
       }
@@ -38,84 +145,59 @@ namespace llarp
       size_t
       size() const
       {
-        return nodes.size();
+        return m_Vals.size();
       }
 
-      struct SetIntersector
-      {
-        bool
-        operator()(const typename BucketStorage_t::value_type& lhs,
-                   const Key_t& rhs)
-        {
-          return lhs.first < rhs;
-        }
-
-        bool
-        operator()(const Key_t& lhs,
-                   const typename BucketStorage_t::value_type& rhs)
-        {
-          return lhs < rhs.first;
-        }
-      };
-
       bool
       GetRandomNodeExcluding(Key_t& result,
                              const std::set< Key_t >& exclude) const
       {
-        std::vector< typename BucketStorage_t::value_type > candidates;
-        std::set_difference(nodes.begin(), nodes.end(), exclude.begin(),
-                            exclude.end(), std::back_inserter(candidates),
-                            SetIntersector());
+        std::vector< size_t > candidates;
+        for(size_t idx = 0; idx < m_Keys.size(); ++idx)
+        {
+          if(exclude.count(m_Keys[idx]) == 0)
+            candidates.emplace_back(idx);
+        }
 
         if(candidates.empty())
         {
           return false;
         }
-        result = candidates[random() % candidates.size()].first;
+        result = m_Keys[candidates[random() % candidates.size()]];
         return true;
       }
 
       bool
       FindClosest(const Key_t& target, Key_t& result) const
       {
-        Key_t mindist;
-        mindist.Fill(0xff);
-        for(const auto& item : nodes)
-        {
-          auto curDist = item.first ^ target;
-          if(curDist < mindist)
-          {
-            mindist = curDist;
-            result  = item.first;
-          }
-        }
-        return nodes.size() > 0;
+        std::vector< size_t > found;
+        m_Keys.Closest(target, 1, [](size_t) { return false; }, found);
+        if(found.empty())
+          return false;
+        result = m_Keys[found[0]];
+        return true;
       }
 
       bool
       GetManyRandom(std::set< Key_t >& result, size_t N) const
       {
-        if(nodes.size() < N || nodes.empty())
+        if(m_Keys.size() < N || m_Keys.size() == 0)
         {
-          llarp::LogWarn("Not enough dht nodes, have ", nodes.size(), " want ",
-                         N);
+          llarp::LogWarn("Not enough dht nodes, have ", m_Keys.size(),
+                         " want ", N);
           return false;
         }
-        if(nodes.size() == N)
+        if(m_Keys.size() == N)
         {
-          std::transform(nodes.begin(), nodes.end(),
-                         std::inserter(result, result.end()),
-                         [](const auto& a) { return a.first; });
-
+          for(size_t idx = 0; idx < m_Keys.size(); ++idx)
+            result.insert(m_Keys[idx]);
           return true;
         }
         size_t expecting = N;
-        size_t sz        = nodes.size();
+        size_t sz        = m_Keys.size();
         while(N)
         {
-          auto itr = nodes.begin();
-          std::advance(itr, random() % sz);
-          if(result.insert(itr->first).second)
+          if(result.insert(m_Keys[random() % sz]).second)
           {
             --N;
           }
@@ -127,70 +209,65 @@ namespace llarp
       FindCloseExcluding(const Key_t& target, Key_t& result,
                          const std::set< Key_t >& exclude) const
       {
+        std::vector< size_t > found;
+        m_Keys.Closest(
+            target, 1,
+            [&](size_t idx) { return exclude.count(m_Keys[idx]) != 0; },
+            found);
+        if(found.empty())
+          return false;
         Key_t maxdist;
         maxdist.Fill(0xff);
-        Key_t mindist;
-        mindist.Fill(0xff);
-        for(const auto& item : nodes)
-        {
-          if(exclude.count(item.first))
-          {
-            continue;
-          }
-
-          auto curDist = item.first ^ target;
-          if(curDist < mindist)
-          {
-            mindist = curDist;
-            result  = item.first;
-          }
-        }
-        return mindist < maxdist;
+        if(not((m_Keys[found[0]] ^ target) < maxdist))
+          return false;
+        result = m_Keys[found[0]];
+        return true;
       }
 
       bool
       GetManyNearExcluding(const Key_t& target, std::set< Key_t >& result,
                            size_t N, const std::set< Key_t >& exclude) const
       {
-        std::set< Key_t > s(exclude.begin(), exclude.end());
-
-        Key_t peer;
-        while(N--)
-        {
-          if(!FindCloseExcluding(target, peer, s))
-          {
-            return false;
-          }
-          s.insert(peer);
-          result.insert(peer);
-        }
-        return true;
+        std::vector< size_t > found;
+        m_Keys.Closest(
+            target, N,
+            [&](size_t idx) { return exclude.count(m_Keys[idx]) != 0; },
+            found);
+        for(const auto idx : found)
+          result.insert(m_Keys[idx]);
+        return found.size() == N;
       }
 
       void
       PutNode(const Val_t& val)
       {
-        auto itr = nodes.find(val.ID);
-        if(itr == nodes.end() || itr->second < val)
+        auto itr = m_Index.find(val.ID);
+        if(itr == m_Index.end())
         {
-          nodes[val.ID] = val;
+          m_Index.emplace(val.ID, m_Vals.size());
+          m_Keys.Add(val.ID);
+          m_Vals.emplace_back(val);
+        }
+        else if(m_Vals[itr->second] < val)
+        {
+          m_Vals[itr->second] = val;
         }
       }
 
       void
       DelNode(const Key_t& key)
       {
-        auto itr = nodes.find(key);
-        if(itr != nodes.end())
+        auto itr = m_Index.find(key);
+        if(itr != m_Index.end())
         {
-          nodes.erase(itr);
+          RemoveAt(itr->second);
         }
       }
 
       bool
       HasNode(const Key_t& key) const
       {
-        return nodes.find(key) != nodes.end();
+        return m_Index.find(key) != m_Index.end();
       }
 
       // remove all nodes who's key matches a predicate
@@ -198,24 +275,46 @@ namespace llarp
       void
       RemoveIf(Predicate pred)
       {
-        auto itr = nodes.begin();
-        while(itr != nodes.end())
+        size_t idx = 0;
+        while(idx < m_Keys.size())
         {
-          if(pred(itr->first))
-            itr = nodes.erase(itr);
+          if(pred(m_Keys[idx]))
+            RemoveAt(idx);
           else
-            ++itr;
+            ++idx;
         }
       }
 
       void
       Clear()
       {
-        nodes.clear();
+        m_Keys.Clear();
+        m_Vals.clear();
+        m_Index.clear();
       }
 
-      BucketStorage_t nodes;
       Random_t random;
+
+     private:
+      /// remove the node at idx, the last node takes its place
+      void
+      RemoveAt(size_t idx)
+      {
+        m_Index.erase(m_Keys[idx]);
+        if(idx + 1 != m_Vals.size())
+        {
+          m_Index[m_Keys[m_Keys.size() - 1]] = idx;
+          m_Vals[idx]                        = std::move(m_Vals.back());
+        }
+        m_Keys.RemoveAt(idx);
+        m_Vals.pop_back();
+      }
+
+      KeyTable m_Keys;
+      /// value for the key at the same index in m_Keys
+      std::vector< Val_t > m_Vals;
+      /// where each key is in m_Keys
+      std::unordered_map< Key_t, size_t, Key_t::Hash > m_Index;
     };
   }  // namespace dht
 }  // namespace llarp
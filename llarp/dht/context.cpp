@@ -168,9 +168,9 @@ namespace llarp
       std::unique_ptr< Bucket< RCNode > > _nodes;
 
       // for introduction sets
-      std::unique_ptr< Bucket< ISNode > > _services;
+      std::unique_ptr< IntroSetStore > _services;
 
-      Bucket< ISNode >*
+      IntroSetStore*
       services() override
       {
         return _services.get();
@@ -361,23 +361,9 @@ namespace llarp
       // clean up transactions
       ctx->CleanupTX();
 
+      // expire intro sets
       if(ctx->_services)
-      {
-        // expire intro sets
-        auto now    = ctx->Now();
-        auto& nodes = ctx->_services->nodes;
-        auto itr    = nodes.begin();
-        while(itr != nodes.end())
-        {
-          if(itr->second.introset.IsExpired(now))
-          {
-            llarp::LogDebug("introset expired ", itr->second.introset.A.Addr());
-            itr = nodes.erase(itr);
-          }
-          else
-            ++itr;
-        }
-      }
+        ctx->_services->RemoveExpired(ctx->Now());
       ctx->ScheduleCleanupTimer();
     }
 
@@ -386,46 +372,7 @@ namespace llarp
         const service::Tag& tag, size_t max,
         const std::set< service::IntroSet >& exclude)
     {
-      std::set< service::IntroSet > found;
-      auto& nodes = _services->nodes;
-      if(nodes.size() == 0)
-      {
-        return found;
-      }
-      auto itr = nodes.begin();
-      // start at random middle point
-      auto start = llarp::randint() % nodes.size();
-      std::advance(itr, start);
-      auto end            = itr;
-      std::string tagname = tag.ToString();
-      while(itr != nodes.end())
-      {
-        if(itr->second.introset.topic.ToString() == tagname)
-        {
-          if(exclude.count(itr->second.introset) == 0)
-          {
-            found.insert(itr->second.introset);
-            if(found.size() == max)
-              return found;
-          }
-        }
-        ++itr;
-      }
-      itr = nodes.begin();
-      while(itr != end)
-      {
-        if(itr->second.introset.topic.ToString() == tagname)
-        {
-          if(exclude.count(itr->second.introset) == 0)
-          {
-            found.insert(itr->second.introset);
-            if(found.size() == max)
-              return found;
-          }
-        }
-        ++itr;
-      }
-      return found;
+      return _services->FindRandomWithTagExcluding(tag, max, exclude);
     }
 
     void
@@ -483,11 +430,7 @@ namespace llarp
     Context::GetIntroSetByServiceAddress(
         const llarp::service::Address& addr) const
     {
-      auto key = addr.ToKey();
-      auto itr = _services->nodes.find(key);
-      if(itr == _services->nodes.end())
-        return nullptr;
-      return &itr->second.introset;
+      return _services->GetIntroSet(addr.ToKey());
     }
 
     void
@@ -522,8 +465,8 @@ namespace llarp
     {
       router    = r;
       ourKey    = us;
-      _nodes    = std::make_unique< Bucket< RCNode > >(ourKey, llarp::randint);
-      _services = std::make_unique< Bucket< ISNode > >(ourKey, llarp::randint);
+      _nodes    = std::make_unique< Bucket< RCNode > >(llarp::randint);
+      _services = std::make_unique< IntroSetStore >(llarp::randint);
       llarp::LogDebug("initialize dht with key ", ourKey);
       // start exploring
 
@@ -3,6 +3,7 @@
 
 #include <dht/bucket.hpp>
 #include <dht/dht.h>
+#include <dht/introset_store.hpp>
 #include <dht/key.hpp>
 #include <dht/message.hpp>
 #include <dht/messages/findintro.hpp>
@@ -162,7 +163,7 @@ namespace llarp
       virtual const PendingExploreLookups&
       pendingExploreLookups() const = 0;
 
-      virtual Bucket< ISNode >*
+      virtual IntroSetStore*
       services() = 0;
 
       virtual bool&
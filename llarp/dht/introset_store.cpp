@@ -0,0 +1,133 @@
+#include <dht/introset_store.hpp>
+
+#include <util/logging/logger.hpp>
+
+namespace llarp
+{
+  namespace dht
+  {
+    void
+    IntroSetStore::PutNode(const ISNode& node)
+    {
+      auto itr = m_Nodes.find(node.ID);
+      if(itr == m_Nodes.end())
+      {
+        itr = m_Nodes.emplace(node.ID, Entry{node, 0}).first;
+        Index(itr->first, itr->second);
+        return;
+      }
+      if(not(itr->second.node < node))
+        return;
+      Unlink(itr->first, itr->second);
+      itr->second.node = node;
+      Index(itr->first, itr->second);
+    }
+
+    void
+    IntroSetStore::DelNode(const Key_t& key)
+    {
+      auto itr = m_Nodes.find(key);
+      if(itr == m_Nodes.end())
+        return;
+      Unlink(itr->first, itr->second);
+      m_Nodes.erase(itr);
+    }
+
+    const service::IntroSet*
+    IntroSetStore::GetIntroSet(const Key_t& key) const
+    {
+      auto itr = m_Nodes.find(key);
+      if(itr == m_Nodes.end())
+        return nullptr;
+      return &itr->second.node.introset;
+    }
+
+    std::set< service::IntroSet >
+    IntroSetStore::FindRandomWithTagExcluding(
+        const service::Tag& tag, size_t max,
+        const std::set< service::IntroSet >& exclude) const
+    {
+      std::set< service::IntroSet > found;
+      auto itr = m_ByTag.find(tag);
+      if(itr == m_ByTag.end() || max == 0)
+        return found;
+      const auto& keys = itr->second;
+      // start at random middle point
+      const size_t start = random() % keys.size();
+      for(size_t idx = 0; idx < keys.size(); ++idx)
+      {
+        const auto& introset =
+            m_Nodes.at(keys[(start + idx) % keys.size()]).node.introset;
+        if(exclude.count(introset))
+          continue;
+        found.insert(introset);
+        if(found.size() == max)
+          break;
+      }
+      return found;
+    }
+
+    size_t
+    IntroSetStore::RemoveExpired(llarp_time_t now)
+    {
+      size_t removed = 0;
+      while(not m_ByExpiry.empty() && m_ByExpiry.begin()->first < now)
+      {
+        const Key_t key = m_ByExpiry.begin()->second;
+        LogDebug("introset expired ", m_Nodes.at(key).node.introset.A.Addr());
+        DelNode(key);
+        ++removed;
+      }
+      return removed;
+    }
+
+    void
+    IntroSetStore::Clear()
+    {
+      m_Nodes.clear();
+      m_ByTag.clear();
+      m_ByExpiry.clear();
+    }
+
+    util::StatusObject
+    IntroSetStore::ExtractStatus() const
+    {
+      util::StatusObject obj{};
+      for(const auto& item : m_Nodes)
+      {
+        obj[item.first.ToString()] = item.second.node.ExtractStatus();
+      }
+      return obj;
+    }
+
+    void
+    IntroSetStore::Index(const Key_t& key, Entry& entry)
+    {
+      const auto& introset = entry.node.introset;
+      auto& keys           = m_ByTag[introset.topic];
+      entry.tagIdx         = keys.size();
+      keys.emplace_back(key);
+      m_ByExpiry.emplace(introset.GetNewestIntroExpiration(), key);
+    }
+
+    void
+    IntroSetStore::Unlink(const Key_t& key, const Entry& entry)
+    {
+      const auto& introset = entry.node.introset;
+      m_ByExpiry.erase({introset.GetNewestIntroExpiration(), key});
+      auto itr = m_ByTag.find(introset.topic);
+      if(itr == m_ByTag.end())
+        return;
+      auto& keys = itr->second;
+      if(entry.tagIdx + 1 != keys.size())
+      {
+        // move the back into our slot
+        keys[entry.tagIdx]             = keys.back();
+        m_Nodes.at(keys.back()).tagIdx = entry.tagIdx;
+      }
+      keys.pop_back();
+      if(keys.empty())
+        m_ByTag.erase(itr);
+    }
+  }  // namespace dht
+}  // namespace llarp
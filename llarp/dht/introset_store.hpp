@@ -0,0 +1,100 @@
+#ifndef LLARP_DHT_INTROSET_STORE_HPP
+#define LLARP_DHT_INTROSET_STORE_HPP
+
+#include <dht/key.hpp>
+#include <dht/node.hpp>
+#include <service/intro_set.hpp>
+#include <service/tag.hpp>
+#include <util/status.hpp>
+
+#include <functional>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace llarp
+{
+  namespace dht
+  {
+    /// introsets we store for the dht by address, indexed by tag and by when
+    /// they expire so tag lookups cost what they find and expiry costs what
+    /// it removes
+    struct IntroSetStore
+    {
+      using Random_t = std::function< uint64_t() >;
+
+      explicit IntroSetStore(Random_t r) : random(std::move(r))
+      {
+      }
+
+      /// store node unless we have a newer introset for its address
+      void
+      PutNode(const ISNode& node);
+
+      void
+      DelNode(const Key_t& key);
+
+      bool
+      HasNode(const Key_t& key) const
+      {
+        return m_Nodes.find(key) != m_Nodes.end();
+      }
+
+      /// introset stored under key or nullptr
+      const service::IntroSet*
+      GetIntroSet(const Key_t& key) const;
+
+      /// up to max introsets with tag not in exclude starting from a random
+      /// one
+      std::set< service::IntroSet >
+      FindRandomWithTagExcluding(
+          const service::Tag& tag, size_t max,
+          const std::set< service::IntroSet >& exclude) const;
+
+      /// remove every introset expired at now, returns how many went
+      size_t
+      RemoveExpired(llarp_time_t now);
+
+      size_t
+      size() const
+      {
+        return m_Nodes.size();
+      }
+
+      void
+      Clear();
+
+      util::StatusObject
+      ExtractStatus() const;
+
+      Random_t random;
+
+     private:
+      struct Entry
+      {
+        ISNode node;
+        /// where we are in m_ByTag[node.introset.topic]
+        size_t tagIdx;
+      };
+
+      /// put key into the indexes
+      void
+      Index(const Key_t& key, Entry& entry);
+
+      /// take key out of the indexes
+      void
+      Unlink(const Key_t& key, const Entry& entry);
+
+      std::unordered_map< Key_t, Entry, Key_t::Hash > m_Nodes;
+      /// addresses by topic, unordered so removal is a swap with the back
+      std::unordered_map< service::Tag, std::vector< Key_t >,
+                          service::Tag::Hash >
+          m_ByTag;
+      /// addresses by when their newest intro expires
+      std::set< std::pair< llarp_time_t, Key_t > > m_ByExpiry;
+    };
+  }  // namespace dht
+}  // namespace llarp
+
+#endif
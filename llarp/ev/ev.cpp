@@ -46,7 +46,7 @@ llarp_ev_loop_run_single_process(llarp_ev_loop_ptr ev,
       logic->tick_async(ev->time_now());
       llarp_threadpool_tick(logic->thread);
     }
-    llarp::LogContext::Instance().logStream->Tick(ev->time_now());
+    llarp::LogContext::Instance().Tick(ev->time_now());
   }
   ev->stopped();
 }
@@ -90,6 +90,22 @@ llarp_ev_udp_sendto(struct llarp_udp_io *udp, const sockaddr *to,
   return udp->sendto(udp, to, buf.base, buf.sz);
 }
 
+int
+llarp_ev_udp_queue_sendto(struct llarp_udp_io *udp, const sockaddr *to,
+                          const llarp_buffer_t &buf)
+{
+  if(udp->queue_sendto)
+    return udp->queue_sendto(udp, to, buf.base, buf.sz);
+  return udp->sendto(udp, to, buf.base, buf.sz);
+}
+
+void
+llarp_ev_udp_flush(struct llarp_udp_io *udp)
+{
+  if(udp->flush)
+    udp->flush(udp);
+}
+
 bool
 llarp_ev_add_tun(struct llarp_ev_loop *loop, struct llarp_tun_io *tun)
 {
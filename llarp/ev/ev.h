@@ -69,6 +69,15 @@ llarp_ev_loop_time_now_ms(const llarp_ev_loop_ptr &ev);
 void
 llarp_ev_loop_stop(const llarp_ev_loop_ptr &ev);
 
+/// a single datagram handed over in a batch read
+/// only valid for the duration of the callback
+struct llarp_udp_pkt
+{
+  const struct sockaddr *from;
+  const byte_t *data;
+  size_t sz;
+};
+
 /// UDP handling configuration
 struct llarp_udp_io
 {
@@ -86,6 +95,20 @@ struct llarp_udp_io
   /// set by parent
   int (*sendto)(struct llarp_udp_io *, const struct sockaddr *, const byte_t *,
                 size_t);
+  /// optional, if set the event loop may read datagrams in batches and hand
+  /// them over all at once instead of calling recvfrom for each
+  void (*recvbatch)(struct llarp_udp_io *, const llarp_udp_pkt *,
+                    size_t) = nullptr;
+  /// set by parent if it supports batched sends
+  /// queues a packet to be sent on the next flush
+  int (*queue_sendto)(struct llarp_udp_io *, const struct sockaddr *,
+                      const byte_t *, size_t) = nullptr;
+  /// set by parent if it supports batched sends
+  /// sends all queued packets
+  void (*flush)(struct llarp_udp_io *) = nullptr;
+  /// bind with SO_REUSEPORT so more sockets can share the address and the
+  /// kernel spreads remotes across them
+  bool reuseport = false;
 };
 
 /// add UDP handler
@@ -98,6 +121,16 @@ int
 llarp_ev_udp_sendto(struct llarp_udp_io *udp, const struct sockaddr *to,
                     const llarp_buffer_t &pkt);
 
+/// queue a UDP packet to be sent on the next call to llarp_ev_udp_flush
+/// sends right away if the event loop does not batch sends
+int
+llarp_ev_udp_queue_sendto(struct llarp_udp_io *udp, const struct sockaddr *to,
+                          const llarp_buffer_t &pkt);
+
+/// send all queued UDP packets
+void
+llarp_ev_udp_flush(struct llarp_udp_io *udp);
+
 /// close UDP handler
 int
 llarp_ev_close_udp(struct llarp_udp_io *udp);
@@ -224,6 +257,9 @@ struct llarp_tun_io
   void (*recvpkt)(struct llarp_tun_io *, const llarp_buffer_t &);
   /// set by parent
   bool (*writepkt)(struct llarp_tun_io *, const byte_t *, size_t);
+  /// how many queues to read the device with, linux only. each queue past
+  /// the first is read on its own thread so recvpkt must be thread safe
+  int queues = 1;
 };
 
 /// create tun interface with network interface name ifname
@@ -747,6 +747,13 @@ struct llarp_ev_loop
   virtual void
   stop() = 0;
 
+  /// wake up a blocking tick from another thread so work queued on the
+  /// logic thread does not wait out the tick interval
+  virtual void
+  wakeup()
+  {
+  }
+
   virtual bool
   udp_listen(llarp_udp_io* l, const sockaddr* src) = 0;
 
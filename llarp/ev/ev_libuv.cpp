@@ -1,8 +1,18 @@
 #include <ev/ev_libuv.hpp>
 #include <net/net_addr.hpp>
+#include <util/thread/threading.hpp>
 
+#include <array>
 #include <cstring>
 
+#ifdef __linux__
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+#include <thread>
+#endif
+
 namespace libuv
 {
   struct glue
@@ -319,6 +329,9 @@ namespace libuv
     llarp_udp_io* const m_UDP;
     llarp::Addr m_Addr;
     bool gotpkts;
+    /// libuv hands each datagram to OnRecv before reading the next one so a
+    /// single buffer is enough
+    char m_Buffer[64 * 1024];
 
     udp_glue(uv_loop_t* loop, llarp_udp_io* udp, const sockaddr* src)
         : m_UDP(udp), m_Addr(*src)
@@ -326,15 +339,18 @@ namespace libuv
       m_Handle.data = this;
       m_Ticker.data = this;
       gotpkts       = false;
-      uv_udp_init(loop, &m_Handle);
+      // a shared port needs its socket before bind to set SO_REUSEPORT on
+      uv_udp_init_ex(loop, &m_Handle,
+                     udp->reuseport ? src->sa_family : AF_UNSPEC);
       uv_check_init(loop, &m_Ticker);
     }
 
     static void
-    Alloc(uv_handle_t*, size_t suggested_size, uv_buf_t* buf)
+    Alloc(uv_handle_t* h, size_t, uv_buf_t* buf)
     {
-      buf->base = new char[suggested_size];
-      buf->len  = suggested_size;
+      auto* self = static_cast< udp_glue* >(h->data);
+      buf->base  = self->m_Buffer;
+      buf->len   = sizeof(self->m_Buffer);
     }
 
     static void
@@ -343,7 +359,6 @@ namespace libuv
     {
       if(addr)
         static_cast< udp_glue* >(handle->data)->RecvFrom(nread, buf, addr);
-      delete[] buf->base;
     }
 
     void
@@ -385,6 +400,20 @@ namespace libuv
     bool
     Bind()
     {
+      // UV_UDP_REUSEADDR is SO_REUSEADDR on linux, which hands every
+      // datagram to one socket of the group, so set SO_REUSEPORT ourselves
+      if(m_UDP->reuseport)
+      {
+        uv_os_fd_t fd;
+        const int one = 1;
+        if(uv_fileno((const uv_handle_t*)&m_Handle, &fd)
+           || ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one))
+               == -1)
+        {
+          llarp::LogError("failed to set SO_REUSEPORT on ", m_Addr);
+          return false;
+        }
+      }
       auto ret = uv_udp_bind(&m_Handle, m_Addr, 0);
       if(ret)
       {
@@ -427,6 +456,319 @@ namespace libuv
     }
   };
 
+#ifdef __linux__
+  /// udp glue that reads and writes datagrams in batches using
+  /// recvmmsg/sendmmsg, used for udp handlers that take batched reads
+  struct udp_mmsg_glue : public glue
+  {
+    /// how many datagrams we read or write per syscall
+    static constexpr size_t BatchSize = 64;
+    /// largest datagram we batch, bigger reads are dropped and bigger writes
+    /// are sent on their own
+    static constexpr size_t SlotSize = 2048;
+    /// how many full batches we read per wakeup before yielding to the loop
+    static constexpr size_t MaxReadsPerWakeup = 8;
+
+    uv_poll_t m_Handle;
+    uv_check_t m_Ticker;
+    uv_prepare_t m_Flusher;
+    llarp_udp_io* const m_UDP;
+    llarp::Addr m_Addr;
+    int m_FD = -1;
+
+    struct Batch
+    {
+      std::array< mmsghdr, BatchSize > hdrs;
+      std::array< iovec, BatchSize > iovs;
+      std::array< sockaddr_in6, BatchSize > addrs;
+      std::array< std::array< byte_t, SlotSize >, BatchSize > slots;
+    };
+
+    /// preallocated read ring, reused for every batch
+    Batch m_RX;
+    /// preallocated write queue, flushed by Flush
+    Batch m_TX;
+    size_t m_TXCount = 0;
+    std::array< llarp_udp_pkt, BatchSize > m_Pkts;
+
+    /// number of our uv handles that are inited and not yet closed
+    int m_OpenHandles = 0;
+
+    udp_mmsg_glue(llarp_udp_io* udp, const sockaddr* src)
+        : m_UDP(udp), m_Addr(*src)
+    {
+      m_Handle.data  = this;
+      m_Ticker.data  = this;
+      m_Flusher.data = this;
+      for(size_t idx = 0; idx < BatchSize; ++idx)
+      {
+        m_RX.iovs[idx].iov_base = m_RX.slots[idx].data();
+        m_RX.iovs[idx].iov_len  = SlotSize;
+        m_TX.iovs[idx].iov_base = m_TX.slots[idx].data();
+      }
+    }
+
+    ~udp_mmsg_glue() override
+    {
+      if(m_FD != -1)
+        ::close(m_FD);
+    }
+
+    static void
+    OnPoll(uv_poll_t* h, int status, int events)
+    {
+      if(status == 0 && (events & UV_READABLE))
+        static_cast< udp_mmsg_glue* >(h->data)->Read();
+    }
+
+    void
+    Read()
+    {
+      for(size_t reads = 0; reads < MaxReadsPerWakeup; ++reads)
+      {
+        for(size_t idx = 0; idx < BatchSize; ++idx)
+        {
+          auto& hdr              = m_RX.hdrs[idx].msg_hdr;
+          hdr.msg_name           = &m_RX.addrs[idx];
+          hdr.msg_namelen        = sizeof(sockaddr_in6);
+          hdr.msg_iov            = &m_RX.iovs[idx];
+          hdr.msg_iovlen         = 1;
+          hdr.msg_control        = nullptr;
+          hdr.msg_controllen     = 0;
+          hdr.msg_flags          = 0;
+          m_RX.hdrs[idx].msg_len = 0;
+        }
+        const int got =
+            ::recvmmsg(m_FD, m_RX.hdrs.data(), BatchSize, MSG_DONTWAIT, nullptr);
+        if(got <= 0)
+          return;
+        size_t num = 0;
+        for(int idx = 0; idx < got; ++idx)
+        {
+          // drop truncated datagrams
+          if(m_RX.hdrs[idx].msg_hdr.msg_flags & MSG_TRUNC)
+            continue;
+          m_Pkts[num].from = (const sockaddr*)&m_RX.addrs[idx];
+          m_Pkts[num].data = m_RX.slots[idx].data();
+          m_Pkts[num].sz   = m_RX.hdrs[idx].msg_len;
+          ++num;
+        }
+        if(num && m_UDP && m_UDP->recvbatch)
+          m_UDP->recvbatch(m_UDP, m_Pkts.data(), num);
+        if(size_t(got) < BatchSize)
+          return;
+      }
+    }
+
+    static void
+    OnTick(uv_check_t* t)
+    {
+      static_cast< udp_mmsg_glue* >(t->data)->Tick();
+    }
+
+    void
+    Tick()
+    {
+      if(m_UDP && m_UDP->tick)
+        m_UDP->tick(m_UDP);
+    }
+
+    /// flush anything queued outside of the udp tick before we block on io
+    static void
+    OnPrepare(uv_prepare_t* p)
+    {
+      static_cast< udp_mmsg_glue* >(p->data)->Flush();
+    }
+
+    static socklen_t
+    SockLen(const sockaddr* addr)
+    {
+      return addr->sa_family == AF_INET ? sizeof(sockaddr_in)
+                                        : sizeof(sockaddr_in6);
+    }
+
+    static int
+    SendTo(llarp_udp_io* udp, const sockaddr* to, const byte_t* ptr, size_t sz)
+    {
+      auto* self = static_cast< udp_mmsg_glue* >(udp->impl);
+      if(self == nullptr)
+        return -1;
+      return ::sendto(self->m_FD, ptr, sz, MSG_DONTWAIT, to, SockLen(to));
+    }
+
+    static int
+    QueueSendTo(llarp_udp_io* udp, const sockaddr* to, const byte_t* ptr,
+                size_t sz)
+    {
+      auto* self = static_cast< udp_mmsg_glue* >(udp->impl);
+      if(self == nullptr)
+        return -1;
+      if(sz > SlotSize)
+      {
+        // keep ordering with what we already queued
+        self->Flush();
+        return SendTo(udp, to, ptr, sz);
+      }
+      if(self->m_TXCount == BatchSize)
+        self->Flush();
+      // the kernel would not take any of it, drop like a full socket would
+      if(self->m_TXCount == BatchSize)
+        return -1;
+      const size_t idx     = self->m_TXCount++;
+      const socklen_t slen = SockLen(to);
+      std::memcpy(&self->m_TX.addrs[idx], to, slen);
+      std::copy_n(ptr, sz, self->m_TX.slots[idx].data());
+      self->m_TX.iovs[idx].iov_len = sz;
+      auto& hdr                    = self->m_TX.hdrs[idx].msg_hdr;
+      hdr.msg_name                 = &self->m_TX.addrs[idx];
+      hdr.msg_namelen              = slen;
+      hdr.msg_iov                  = &self->m_TX.iovs[idx];
+      hdr.msg_iovlen               = 1;
+      hdr.msg_control              = nullptr;
+      hdr.msg_controllen           = 0;
+      hdr.msg_flags                = 0;
+      return sz;
+    }
+
+    static void
+    ExplicitFlush(llarp_udp_io* udp)
+    {
+      auto* self = static_cast< udp_mmsg_glue* >(udp->impl);
+      if(self)
+        self->Flush();
+    }
+
+    void
+    Flush()
+    {
+      size_t sent = 0;
+      while(sent < m_TXCount)
+      {
+        const int res = ::sendmmsg(m_FD, m_TX.hdrs.data() + sent,
+                                   m_TXCount - sent, MSG_DONTWAIT);
+        if(res > 0)
+          sent += res;
+        else if(errno == EINTR)
+          continue;
+        else if(errno == EAGAIN || errno == EWOULDBLOCK)
+          break;
+        else
+        {
+          // only the first one failed, skip it and send the rest
+          llarp::LogDebug("dropped udp packet: ", strerror(errno));
+          ++sent;
+        }
+      }
+      Consume(sent);
+    }
+
+    /// drop the first n queued datagrams, the rest wait for the next flush
+    void
+    Consume(size_t n)
+    {
+      const size_t left = m_TXCount - n;
+      for(size_t idx = 0; idx < left; ++idx)
+      {
+        const size_t from = n + idx;
+        const size_t sz   = m_TX.iovs[from].iov_len;
+        m_TX.addrs[idx]   = m_TX.addrs[from];
+        std::copy_n(m_TX.slots[from].data(), sz, m_TX.slots[idx].data());
+        m_TX.iovs[idx].iov_len = sz;
+        m_TX.hdrs[idx].msg_hdr.msg_namelen =
+            m_TX.hdrs[from].msg_hdr.msg_namelen;
+      }
+      m_TXCount = left;
+    }
+
+    bool
+    Bind(uv_loop_t* loop)
+    {
+      const sockaddr* addr = m_Addr;
+      m_FD = ::socket(addr->sa_family,
+                      SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      if(m_FD == -1)
+      {
+        llarp::LogError("failed to create udp socket: ", strerror(errno));
+        return false;
+      }
+      const int one = 1;
+      if(m_UDP->reuseport
+         && ::setsockopt(m_FD, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one))
+             == -1)
+      {
+        llarp::LogError("failed to set SO_REUSEPORT: ", strerror(errno));
+        return false;
+      }
+      if(::bind(m_FD, addr, m_Addr.SockLen()) == -1)
+      {
+        llarp::LogError("failed to bind to ", m_Addr, " ", strerror(errno));
+        return false;
+      }
+      if(uv_poll_init(loop, &m_Handle, m_FD) != 0)
+      {
+        llarp::LogError("failed to poll udp socket for ", m_Addr);
+        return false;
+      }
+      uv_check_init(loop, &m_Ticker);
+      uv_prepare_init(loop, &m_Flusher);
+      m_OpenHandles = 3;
+      if(uv_poll_start(&m_Handle, UV_READABLE, &OnPoll) != 0)
+      {
+        llarp::LogError("failed to start recving packets via ", m_Addr);
+        return false;
+      }
+      if(uv_check_start(&m_Ticker, &OnTick) != 0
+         || uv_prepare_start(&m_Flusher, &OnPrepare) != 0)
+      {
+        llarp::LogError("failed to start ticker");
+        return false;
+      }
+      m_UDP->fd           = m_FD;
+      m_UDP->sendto       = &SendTo;
+      m_UDP->queue_sendto = &QueueSendTo;
+      m_UDP->flush        = &ExplicitFlush;
+      return true;
+    }
+
+    /// close or free ourself after a failed Bind
+    void
+    Abort()
+    {
+      if(m_OpenHandles)
+        Close();
+      else
+        delete this;
+    }
+
+    static void
+    OnClosed(uv_handle_t* h)
+    {
+      auto* glue = static_cast< udp_mmsg_glue* >(h->data);
+      h->data    = nullptr;
+      if(glue && --glue->m_OpenHandles == 0)
+      {
+        glue->m_UDP->impl         = nullptr;
+        glue->m_UDP->queue_sendto = nullptr;
+        glue->m_UDP->flush        = nullptr;
+        delete glue;
+      }
+    }
+
+    void
+    Close() override
+    {
+      if(uv_is_closing((uv_handle_t*)&m_Handle))
+        return;
+      Flush();
+      uv_check_stop(&m_Ticker);
+      uv_prepare_stop(&m_Flusher);
+      uv_close((uv_handle_t*)&m_Handle, &OnClosed);
+      uv_close((uv_handle_t*)&m_Ticker, &OnClosed);
+      uv_close((uv_handle_t*)&m_Flusher, &OnClosed);
+    }
+  };
+#endif
+
   struct pipe_glue : public glue
   {
     byte_t m_Buffer[1024 * 8];
@@ -498,6 +840,119 @@ namespace libuv
     uv_check_t m_Ticker;
   };
 
+#ifdef __linux__
+  /// most packets read from a tun queue per wakeup so one busy queue cannot
+  /// starve the rest of its loop
+  static constexpr size_t TunReadBurst = 128;
+
+  /// read a non blocking tun fd until it would block or the burst is used up
+  static void
+  DrainTunQueue(int fd, byte_t* buf, size_t bufsz, llarp_tun_io* tun)
+  {
+    for(size_t idx = 0; idx < TunReadBurst; ++idx)
+    {
+      const auto sz = ::read(fd, buf, bufsz);
+      if(sz <= 0)
+      {
+        if(sz == -1 && errno != EAGAIN && errno != EWOULDBLOCK
+           && errno != EINTR)
+          llarp::LogWarn("tun read failed: ", strerror(errno));
+        return;
+      }
+      if(tun->recvpkt)
+        tun->recvpkt(tun, llarp_buffer_t(buf, sz));
+    }
+  }
+
+  /// an extra queue of a multi queue tun device, read on its own loop and
+  /// thread. writes still all go out of the main queue.
+  struct tun_queue
+  {
+    llarp_tun_io* const m_Tun;
+    const int m_FD;
+    uv_loop_t m_Loop;
+    uv_poll_t m_Poll;
+    uv_async_t m_Stop;
+    std::thread m_Thread;
+    byte_t m_Buffer[1500];
+
+    tun_queue(llarp_tun_io* tun, int fd) : m_Tun(tun), m_FD(fd)
+    {
+      m_Poll.data = this;
+      m_Stop.data = this;
+    }
+
+    ~tun_queue()
+    {
+      Stop();
+      ::close(m_FD);
+    }
+
+    tun_queue(const tun_queue&) = delete;
+
+    tun_queue&
+    operator=(const tun_queue&) = delete;
+
+    static void
+    OnPoll(uv_poll_t* h, int, int events)
+    {
+      if(events & UV_READABLE)
+      {
+        auto* self = static_cast< tun_queue* >(h->data);
+        DrainTunQueue(self->m_FD, self->m_Buffer, sizeof(self->m_Buffer),
+                      self->m_Tun);
+      }
+    }
+
+    static void
+    OnStop(uv_async_t* h)
+    {
+      auto* self = static_cast< tun_queue* >(h->data);
+      uv_poll_stop(&self->m_Poll);
+      uv_close((uv_handle_t*)&self->m_Poll, nullptr);
+      uv_close((uv_handle_t*)&self->m_Stop, nullptr);
+    }
+
+    bool
+    Start(const std::string& name)
+    {
+      if(uv_loop_init(&m_Loop) != 0)
+        return false;
+      if(uv_async_init(&m_Loop, &m_Stop, &OnStop) != 0
+         || uv_poll_init(&m_Loop, &m_Poll, m_FD) != 0
+         || uv_poll_start(&m_Poll, UV_READABLE, &OnPoll) != 0)
+      {
+        uv_walk(
+            &m_Loop,
+            [](uv_handle_t* h, void*) {
+              if(!uv_is_closing(h))
+                uv_close(h, nullptr);
+            },
+            nullptr);
+        uv_run(&m_Loop, UV_RUN_DEFAULT);
+        uv_loop_close(&m_Loop);
+        return false;
+      }
+      m_Thread = std::thread([this, name]() {
+        llarp::util::SetThreadName(name);
+        uv_run(&m_Loop, UV_RUN_DEFAULT);
+        uv_loop_close(&m_Loop);
+      });
+      return true;
+    }
+
+    /// close our handles and wait for the thread
+    void
+    Stop()
+    {
+      if(!m_Thread.joinable())
+        return;
+      uv_async_send(&m_Stop);
+      m_Thread.join();
+    }
+  };
+#endif
+
   struct tun_glue : public glue
   {
     uv_poll_t m_Handle;
@@ -506,6 +961,9 @@ namespace libuv
     device* const m_Device;
     byte_t m_Buffer[1500];
     bool readpkt;
+#ifdef __linux__
+    std::vector< std::unique_ptr< tun_queue > > m_Queues;
+#endif
 
     tun_glue(llarp_tun_io* tun) : m_Tun(tun), m_Device(tuntap_init())
     {
@@ -537,6 +995,9 @@ namespace libuv
     void
     Read()
     {
+#ifdef __linux__
+      DrainTunQueue(m_Device->tun_fd, m_Buffer, sizeof(m_Buffer), m_Tun);
+#else
       auto sz = tuntap_read(m_Device, m_Buffer, sizeof(m_Buffer));
       if(sz > 0)
       {
@@ -545,6 +1006,7 @@ namespace libuv
         if(m_Tun && m_Tun->recvpkt)
           m_Tun->recvpkt(m_Tun, pkt);
       }
+#endif
     }
 
     void
@@ -571,6 +1033,9 @@ namespace libuv
     void
     Close() override
     {
+#ifdef __linux__
+      m_Queues.clear();
+#endif
       uv_check_stop(&m_Ticker);
       uv_close((uv_handle_t*)&m_Handle, &OnClosed);
     }
@@ -587,11 +1052,53 @@ namespace libuv
       return static_cast< tun_glue* >(tun->impl)->Write(pkt, sz);
     }
 
+#ifdef __linux__
+    /// open and start reading the queues past the first, the device still
+    /// works with however many we got
+    void
+    AddQueues()
+    {
+      while(m_Queues.size() + 1 < size_t(m_Tun->queues))
+      {
+        const int fd = tuntap_add_queue(m_Device);
+        if(fd == -1)
+          break;
+        m_Queues.emplace_back(std::make_unique< tun_queue >(m_Tun, fd));
+        const std::string name = std::string(m_Tun->ifname) + "-q"
+            + std::to_string(m_Queues.size());
+        if(!m_Queues.back()->Start(name))
+        {
+          m_Queues.pop_back();
+          break;
+        }
+      }
+      if(m_Queues.size() + 1 < size_t(m_Tun->queues))
+        llarp::LogWarn("only opened ", m_Queues.size() + 1, " of ",
+                       m_Tun->queues, " queues on ", m_Tun->ifname);
+      else
+        llarp::LogInfo(m_Tun->ifname, " reading ", m_Queues.size() + 1,
+                       " queues");
+    }
+#endif
+
     bool
     Init(uv_loop_t* loop)
     {
       memcpy(m_Device->if_name, m_Tun->ifname, sizeof(m_Device->if_name));
-      if(tuntap_start(m_Device, TUNTAP_MODE_TUNNEL, 0) == -1)
+      bool multiqueue = false;
+#ifdef __linux__
+      if(m_Tun->queues > 1)
+      {
+        multiqueue =
+            tuntap_start(m_Device, TUNTAP_MODE_TUNNEL | TUNTAP_MODE_MULTIQUEUE,
+                         0)
+            != -1;
+        if(!multiqueue)
+          llarp::LogWarn("failed to start ", m_Tun->ifname,
+                         " with multiple queues, using one");
+      }
+#endif
+      if(!multiqueue && tuntap_start(m_Device, TUNTAP_MODE_TUNNEL, 0) == -1)
       {
         llarp::LogError("failed to start up ", m_Tun->ifname);
         return false;
@@ -630,6 +1137,10 @@ namespace libuv
                         m_Tun->ifname);
         return false;
       }
+#ifdef __linux__
+      if(multiqueue)
+        AddQueues();
+#endif
       m_Tun->writepkt = &WritePkt;
       return true;
     }
@@ -643,6 +1154,14 @@ namespace libuv
       return false;
     uv_loop_configure(m_Impl.get(), UV_LOOP_BLOCK_SIGNAL, SIGPIPE);
     m_TickTimer.data = this;
+    if(uv_async_init(m_Impl.get(), &m_WakeUp, [](uv_async_t*) {}) != 0)
+      return false;
+    // not a glue, CloseAll must skip it
+    m_WakeUp.data = nullptr;
+    {
+      llarp::util::Lock lock(&m_WakeUpAccess);
+      m_WakeUpOpen = true;
+    }
     m_Run.store(true);
     return uv_timer_init(m_Impl.get(), &m_TickTimer) != -1;
   }
@@ -687,19 +1206,32 @@ namespace libuv
   Loop::tick(int ms)
   {
     uv_timer_start(&m_TickTimer, &OnTickTimeout, ms, 0);
+    m_Ticking = true;
     uv_run(m_Impl.get(), UV_RUN_ONCE);
+    m_Ticking = false;
     return 0;
   }
 
   void
   Loop::stop()
   {
-    uv_stop(m_Impl.get());
+    // uv_stop left pending makes the next run return without doing
+    // anything, so only use it to break out of a run in progress
+    if(m_Ticking)
+      uv_stop(m_Impl.get());
     llarp::LogInfo("stopping event loop");
     m_Run.store(false);
     CloseAll();
   }
 
+  void
+  Loop::wakeup()
+  {
+    llarp::util::Lock lock(&m_WakeUpAccess);
+    if(m_WakeUpOpen && m_Run.load())
+      uv_async_send(&m_WakeUp);
+  }
+
   void
   Loop::CloseAll()
   {
@@ -720,6 +1252,13 @@ namespace libuv
   void
   Loop::stopped()
   {
+    {
+      llarp::util::Lock lock(&m_WakeUpAccess);
+      if(m_WakeUpOpen)
+        uv_close((uv_handle_t*)&m_WakeUp, nullptr);
+      m_WakeUpOpen = false;
+    }
+    // go round once more so the handles CloseAll closed are really closed
     tick(50);
     llarp::LogInfo("we have stopped");
   }
@@ -727,6 +1266,20 @@ namespace libuv
   bool
   Loop::udp_listen(llarp_udp_io* udp, const sockaddr* src)
   {
+#ifdef __linux__
+    if(udp->recvbatch)
+    {
+      auto* impl = new udp_mmsg_glue(udp, src);
+      udp->impl  = impl;
+      if(impl->Bind(m_Impl.get()))
+      {
+        return true;
+      }
+      udp->impl = nullptr;
+      impl->Abort();
+      return false;
+    }
+#endif
     auto* impl = new udp_glue(m_Impl.get(), udp, src);
     udp->impl  = impl;
     if(impl->Bind())
@@ -742,7 +1295,7 @@ namespace libuv
   {
     if(udp == nullptr)
       return false;
-    auto* glue = static_cast< udp_glue* >(udp->impl);
+    auto* glue = static_cast< libuv::glue* >(udp->impl);
     if(glue == nullptr)
       return false;
     glue->Close();
@@ -2,6 +2,7 @@
 #define LLARP_EV_LIBUV_HPP
 #include <ev/ev.hpp>
 #include <ev/pipe.hpp>
+#include <util/thread/threading.hpp>
 #include <uv.h>
 #include <vector>
 #include <functional>
@@ -38,6 +39,9 @@ namespace libuv
     void
     stop() override;
 
+    void
+    wakeup() override;
+
     void
     stopped() override;
 
@@ -97,7 +101,14 @@ namespace libuv
 
     std::unique_ptr< uv_loop_t, DestructLoop > m_Impl;
     uv_timer_t m_TickTimer;
+    /// held while sending on m_WakeUp so stopped cannot close it under a
+    /// worker thread
+    llarp::util::Mutex m_WakeUpAccess;
+    uv_async_t m_WakeUp;
+    bool m_WakeUpOpen GUARDED_BY(m_WakeUpAccess) = false;
     std::atomic< bool > m_Run;
+    /// inside uv_run on the loop thread
+    bool m_Ticking = false;
   };
 
 }  // namespace libuv
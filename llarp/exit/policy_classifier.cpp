@@ -0,0 +1,385 @@
+#include <exit/policy_classifier.hpp>
+
+#include <net/ip.hpp>
+#include <util/endian.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+
+namespace llarp
+{
+  namespace exit
+  {
+    constexpr uint32_t PolicyClassifier::Leaf;
+
+    static constexpr uint8_t ProtoICMP   = 1;
+    static constexpr uint8_t ProtoTCP    = 6;
+    static constexpr uint8_t ProtoUDP    = 17;
+    static constexpr uint8_t ProtoICMPv6 = 58;
+
+    /// ipv6 extension headers we step over to reach the upper layer
+    static constexpr uint8_t ProtoHopByHop  = 0;
+    static constexpr uint8_t ProtoRouting   = 43;
+    static constexpr uint8_t ProtoFragment  = 44;
+    static constexpr uint8_t ProtoAuth      = 51;
+    static constexpr uint8_t ProtoDestOpts  = 60;
+    static constexpr uint8_t ProtoMobility  = 135;
+    static constexpr uint8_t ProtoHIP       = 139;
+    static constexpr uint8_t ProtoShim6     = 140;
+    /// most extension headers we walk before giving up on a packet
+    static constexpr size_t MaxExtensionHeaders = 8;
+
+    /// a rule's range as leading bytes of an address in network order
+    struct Prefix
+    {
+      std::array< byte_t, 16 > bytes;
+      size_t bits;
+      size_t rule;
+    };
+
+    /// rules by the class they make up
+    using Classes_t = std::map< std::vector< size_t >, uint32_t >;
+
+    static void
+    ToBytes(huint128_t x, byte_t* out)
+    {
+      for(size_t idx = 0; idx < 16; ++idx)
+        out[idx] = byte_t(absl::Uint128Low64(x.h >> (120 - (8 * idx))));
+    }
+
+    static size_t
+    NumBits(huint128_t mask)
+    {
+      return __builtin_popcountll(absl::Uint128High64(mask.h))
+          + __builtin_popcountll(absl::Uint128Low64(mask.h));
+    }
+
+    static bool
+    ParseNumber(const std::string& str, uint64_t max, uint64_t& num)
+    {
+      if(str.empty())
+        return false;
+      char* end = nullptr;
+      num       = std::strtoull(str.c_str(), &end, 10);
+      return *end == 0 && num <= max;
+    }
+
+    static bool
+    IsExtensionHeader(uint8_t proto)
+    {
+      switch(proto)
+      {
+        case ProtoHopByHop:
+        case ProtoRouting:
+        case ProtoFragment:
+        case ProtoAuth:
+        case ProtoDestOpts:
+        case ProtoMobility:
+        case ProtoHIP:
+        case ProtoShim6:
+          return true;
+        default:
+          return false;
+      }
+    }
+
+    static uint32_t
+    Intern(std::vector< size_t > rules, Classes_t& classes)
+    {
+      std::sort(rules.begin(), rules.end());
+      const uint32_t cls = classes.size();
+      return classes.emplace(std::move(rules), cls).first->second;
+    }
+
+    /// does the byte at depth agree with the prefix as far as it goes
+    static bool
+    MatchesByte(const Prefix& prefix, size_t depth, byte_t b)
+    {
+      const size_t bits  = std::min(size_t(8), prefix.bits - (depth * 8));
+      const byte_t mask = byte_t(0xff << (8 - bits));
+      return (b & mask) == (prefix.bytes[depth] & mask);
+    }
+
+    /// add a node at depth for rules covering it and rules reaching deeper,
+    /// returns its index
+    static uint32_t
+    BuildNode(std::vector< PolicyClassifier::Node_t >& trie,
+              const std::vector< size_t >& covering,
+              const std::vector< const Prefix* >& pending, size_t depth,
+              Classes_t& classes)
+    {
+      const uint32_t idx = trie.size();
+      trie.emplace_back();
+      for(size_t b = 0; b < 256; ++b)
+      {
+        std::vector< size_t > cover = covering;
+        std::vector< const Prefix* > deeper;
+        for(const auto* prefix : pending)
+        {
+          if(!MatchesByte(*prefix, depth, b))
+            continue;
+          if(prefix->bits <= (depth + 1) * 8)
+            cover.emplace_back(prefix->rule);
+          else
+            deeper.emplace_back(prefix);
+        }
+        // trie may move under us so index it again once built
+        const uint32_t entry = deeper.empty()
+            ? (PolicyClassifier::Leaf | Intern(std::move(cover), classes))
+            : BuildNode(trie, cover, deeper, depth + 1, classes);
+        trie[idx][b] = entry;
+      }
+      return idx;
+    }
+
+    static void
+    BuildTrie(std::vector< PolicyClassifier::Node_t >& trie,
+              const std::vector< Prefix >& prefixes, Classes_t& classes)
+    {
+      std::vector< size_t > covering;
+      std::vector< const Prefix* > pending;
+      for(const auto& prefix : prefixes)
+      {
+        if(prefix.bits == 0)
+          covering.emplace_back(prefix.rule);
+        else
+          pending.emplace_back(&prefix);
+      }
+      BuildNode(trie, covering, pending, 0, classes);
+    }
+
+    void
+    PolicyClassifier::Add(const Policy& policy, const IPRange& range)
+    {
+      m_Rules.emplace_back(Rule{policy, range});
+    }
+
+    void
+    PolicyClassifier::Add(const Policy& policy)
+    {
+      Add(policy, IPRange{huint128_t{0}, huint128_t{0}});
+    }
+
+    bool
+    PolicyClassifier::ParseRule(const std::string& str, Policy& policy,
+                                IPRange& range)
+    {
+      policy = Policy{};
+      range  = IPRange{huint128_t{0}, huint128_t{0}};
+      std::istringstream in(str);
+      std::string part;
+      bool any = false;
+      while(in >> part)
+      {
+        any             = true;
+        const auto pos = part.find('/');
+        if(pos != std::string::npos)
+        {
+          const std::string host = part.substr(0, pos);
+          uint64_t bits          = 0;
+          huint32_t ip4;
+          huint128_t ip6;
+          if(ip4.FromString(host)
+             && ParseNumber(part.substr(pos + 1), 32, bits))
+          {
+            range.addr         = net::IPPacket::ExpandV4(ip4);
+            range.netmask_bits = netmask_ipv6_bits(bits + 96);
+          }
+          else if(ip6.FromString(host)
+                  && ParseNumber(part.substr(pos + 1), 128, bits))
+          {
+            range.addr         = ip6;
+            range.netmask_bits = netmask_ipv6_bits(bits);
+          }
+          else
+            return false;
+          range.addr = range.addr & range.netmask_bits;
+          continue;
+        }
+        const auto colon      = part.find(':');
+        const std::string name = part.substr(0, colon);
+        if(name == "tcp")
+          policy.proto = ProtoTCP;
+        else if(name == "udp")
+          policy.proto = ProtoUDP;
+        else if(name == "icmp")
+          policy.proto = ProtoICMP;
+        else if(name == "icmpv6")
+          policy.proto = ProtoICMPv6;
+        else if(name == "*")
+          policy.proto = 0;
+        else if(!ParseNumber(name, 255, policy.proto))
+          return false;
+        if(colon == std::string::npos)
+          continue;
+        const std::string port = part.substr(colon + 1);
+        if(port != "*" && !ParseNumber(port, 65535, policy.port))
+          return false;
+      }
+      return any;
+    }
+
+    void
+    PolicyClassifier::Compile()
+    {
+      m_V4.clear();
+      m_V6.clear();
+      m_Classes.clear();
+      m_Ports.clear();
+      m_AllPorts.clear();
+      if(m_Rules.empty())
+        return;
+
+      const huint128_t v4Mapped = net::IPPacket::ExpandV4(huint32_t{0});
+      std::vector< Prefix > v4, v6;
+      bool whitelist = false;
+      std::vector< uint8_t > protos;
+      for(size_t idx = 0; idx < m_Rules.size(); ++idx)
+      {
+        const auto& rule = m_Rules[idx];
+        whitelist        = whitelist || rule.policy.drop == 0;
+        if(rule.policy.proto)
+          protos.emplace_back(rule.policy.proto);
+
+        Prefix prefix;
+        prefix.rule = idx;
+        prefix.bits = NumBits(rule.range.netmask_bits);
+        ToBytes(rule.range.addr, prefix.bytes.data());
+        v6.emplace_back(prefix);
+        // ipv4 packets look up their own trie, so ranges inside ::ffff:0/96
+        // and ranges holding all of it go there as well
+        if(prefix.bits > 96
+           && (rule.range.addr & netmask_ipv6_bits(96)) == v4Mapped)
+        {
+          std::copy_n(prefix.bytes.begin() + 12, 4, prefix.bytes.begin());
+          prefix.bits -= 96;
+          v4.emplace_back(prefix);
+        }
+        else if(rule.range.Contains(v4Mapped))
+        {
+          prefix.bits = 0;
+          v4.emplace_back(prefix);
+        }
+      }
+      std::sort(protos.begin(), protos.end());
+      protos.erase(std::unique(protos.begin(), protos.end()), protos.end());
+
+      Classes_t classes;
+      BuildTrie(m_V4, v4, classes);
+      BuildTrie(m_V6, v6, classes);
+
+      // bitmap of passing ports for proto, 0 for any proto not named by a
+      // rule
+      const auto portsFor = [&](const std::vector< size_t >& rules,
+                                uint8_t proto) {
+        PortMap_t allowed, dropped;
+        for(const auto idx : rules)
+        {
+          const Policy& policy = m_Rules[idx].policy;
+          if(policy.proto != 0 && policy.proto != proto)
+            continue;
+          PortMap_t& ports = policy.drop ? dropped : allowed;
+          if(policy.port)
+            ports.set(policy.port);
+          else
+            ports.set();
+        }
+        if(!whitelist)
+          allowed.set();
+        return allowed & ~dropped;
+      };
+
+      m_Classes.resize(classes.size());
+      for(const auto& item : classes)
+      {
+        auto& index = m_Classes[item.second];
+        index.fill(m_Ports.size());
+        m_Ports.emplace_back(portsFor(item.first, 0));
+        for(const auto proto : protos)
+        {
+          index[proto] = m_Ports.size();
+          m_Ports.emplace_back(portsFor(item.first, proto));
+        }
+      }
+      for(const auto& ports : m_Ports)
+        m_AllPorts.emplace_back(ports.all());
+    }
+
+    bool
+    PolicyClassifier::Allow(huint128_t remote, uint8_t proto,
+                            uint16_t port) const
+    {
+      if(Empty())
+        return true;
+      std::array< byte_t, 16 > addr;
+      ToBytes(remote, addr.data());
+      const huint128_t v4Mapped = net::IPPacket::ExpandV4(huint32_t{0});
+      if((remote & netmask_ipv6_bits(96)) == v4Mapped)
+        return Pass(Lookup(m_V4, addr.data() + 12), proto, port);
+      return Pass(Lookup(m_V6, addr.data()), proto, port);
+    }
+
+    bool
+    PolicyClassifier::Classify(const llarp_buffer_t& pkt, bool outbound) const
+    {
+      const byte_t* ptr = pkt.base;
+      uint32_t cls;
+      uint8_t proto;
+      size_t hdr;
+      // only the first fragment has ports
+      bool first = true;
+      if(pkt.sz >= 20 && (ptr[0] >> 4) == 4)
+      {
+        hdr = (ptr[0] & 0x0f) * 4;
+        if(hdr < 20 || hdr > pkt.sz)
+          return false;
+        proto = ptr[9];
+        cls   = Lookup(m_V4, ptr + (outbound ? 16 : 12));
+        first = (bufbe16toh(ptr + 6) & 0x1fff) == 0;
+      }
+      else if(pkt.sz >= 40 && (ptr[0] >> 4) == 6)
+      {
+        hdr   = 40;
+        proto = ptr[6];
+        cls   = Lookup(m_V6, ptr + (outbound ? 24 : 8));
+        // step over extension headers to the upper layer protocol, a later
+        // fragment holds payload after its fragment header
+        for(size_t n = 0; first && IsExtensionHeader(proto); ++n)
+        {
+          if(n == MaxExtensionHeaders || pkt.sz < hdr + 8)
+            return false;
+          const byte_t* ext = ptr + hdr;
+          if(proto == ProtoFragment)
+          {
+            first = (bufbe16toh(ext + 2) & 0xfff8) == 0;
+            hdr += 8;
+          }
+          else if(proto == ProtoAuth)
+            hdr += (size_t(ext[1]) + 2) * 4;
+          else
+            hdr += (size_t(ext[1]) + 1) * 8;
+          proto = ext[0];
+        }
+        if(hdr > pkt.sz)
+          return false;
+      }
+      else
+        return false;
+      if(proto != ProtoTCP && proto != ProtoUDP)
+        return Pass(cls, proto, 0);
+      // without a port to check only pass what passes on every port
+      if(!first || pkt.sz < hdr + 4)
+        return PassAnyPort(cls, proto);
+      return Pass(cls, proto, bufbe16toh(ptr + hdr + (outbound ? 2 : 0)));
+    }
+
+    util::StatusObject
+    PolicyClassifier::ExtractStatus() const
+    {
+      return util::StatusObject{{"rules", uint64_t(m_Rules.size())},
+                                {"classes", uint64_t(m_Classes.size())}};
+    }
+  }  // namespace exit
+}  // namespace llarp
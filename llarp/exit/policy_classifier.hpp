@@ -0,0 +1,136 @@
+#ifndef LLARP_EXIT_POLICY_CLASSIFIER_HPP
+#define LLARP_EXIT_POLICY_CLASSIFIER_HPP
+
+#include <exit/policy.hpp>
+#include <net/net.hpp>
+#include <util/buffer.hpp>
+#include <util/status.hpp>
+
+#include <array>
+#include <bitset>
+#include <string>
+#include <vector>
+
+namespace llarp
+{
+  namespace exit
+  {
+    /// exit policies compiled into lookup tables so every packet through an
+    /// exit can be checked against them. the remote address picks a class of
+    /// rules out of a stride 8 trie and the class has a bitmap of passing
+    /// ports for each protocol. if there is any whitelist rule traffic must
+    /// match one, and traffic matching a blacklist rule is always dropped.
+    /// tcp and udp packets whose port we cannot read, like later fragments,
+    /// only pass if their protocol passes on every port.
+    struct PolicyClassifier
+    {
+      /// bitmap of passing ports, non port protocols are checked as port 0
+      using PortMap_t = std::bitset< 65536 >;
+
+      /// trie entries with this bit set are a class and not another node
+      static constexpr uint32_t Leaf = 1u << 31;
+
+      using Node_t = std::array< uint32_t, 256 >;
+
+      /// add a rule for remotes in range, policy.drop makes it a blacklist
+      /// rule and 0 for proto or port matches any. takes effect on Compile.
+      void
+      Add(const Policy& policy, const IPRange& range);
+
+      /// add a rule for any remote
+      void
+      Add(const Policy& policy);
+
+      /// parse a rule like "tcp:25", "udp:* 10.0.0.0/8" or "fc00::/7", proto
+      /// is tcp, udp, icmp, icmpv6, * or a number. a missing proto, port or
+      /// range matches any.
+      static bool
+      ParseRule(const std::string& str, Policy& policy, IPRange& range);
+
+      /// build lookup tables from every rule added so far
+      void
+      Compile();
+
+      /// no rules, everything passes
+      bool
+      Empty() const
+      {
+        return m_Classes.empty();
+      }
+
+      /// does an ip packet we are sending to the internet pass
+      bool
+      AllowOutbound(const llarp_buffer_t& pkt) const
+      {
+        return Empty() || Classify(pkt, true);
+      }
+
+      /// does an ip packet from the internet pass
+      bool
+      AllowInbound(const llarp_buffer_t& pkt) const
+      {
+        return Empty() || Classify(pkt, false);
+      }
+
+      /// does traffic with remote over proto to or from port pass
+      bool
+      Allow(huint128_t remote, uint8_t proto, uint16_t port) const;
+
+      size_t
+      NumRules() const
+      {
+        return m_Rules.size();
+      }
+
+      util::StatusObject
+      ExtractStatus() const;
+
+     private:
+      struct Rule
+      {
+        Policy policy;
+        IPRange range;
+      };
+
+      bool
+      Classify(const llarp_buffer_t& pkt, bool outbound) const;
+
+      /// class of rules for remote, addr holds width bytes in network order
+      uint32_t
+      Lookup(const std::vector< Node_t >& trie, const byte_t* addr) const
+      {
+        uint32_t entry = 0;
+        for(size_t depth = 0;; ++depth)
+        {
+          entry = trie[entry][addr[depth]];
+          if(entry & Leaf)
+            return entry & ~Leaf;
+        }
+      }
+
+      bool
+      Pass(uint32_t cls, uint8_t proto, uint16_t port) const
+      {
+        return m_Ports[m_Classes[cls][proto]][port];
+      }
+
+      bool
+      PassAnyPort(uint32_t cls, uint8_t proto) const
+      {
+        return m_AllPorts[m_Classes[cls][proto]];
+      }
+
+      std::vector< Rule > m_Rules;
+      /// tries for ipv4 and ipv6 remotes
+      std::vector< Node_t > m_V4;
+      std::vector< Node_t > m_V6;
+      /// index into m_Ports by protocol for each class
+      std::vector< std::array< uint16_t, 256 > > m_Classes;
+      std::vector< PortMap_t > m_Ports;
+      /// which of m_Ports pass every port
+      std::vector< bool > m_AllPorts;
+    };
+  }  // namespace exit
+}  // namespace llarp
+
+#endif
@@ -47,7 +47,9 @@ namespace llarp
     ExitEndpoint::ExtractStatus() const
     {
       util::StatusObject obj{{"permitExit", m_PermitExit},
-                             {"ip", m_IfAddr.ToString()}};
+                             {"ip", m_IfAddr.ToString()},
+                             {"policy", m_Policy.ExtractStatus()},
+                             {"policyDropped", m_PolicyDropped.load()}};
       util::StatusObject exitsObj{};
       for(const auto &item : m_ActiveExits)
       {
@@ -318,7 +320,6 @@ namespace llarp
       const huint128_t ip = GetIfAddr();
       m_KeyToIP[us]       = ip;
       m_IPToKey[ip]       = us;
-      m_IPActivity[ip]    = std::numeric_limits< llarp_time_t >::max();
       m_SNodeKeys.insert(us);
       if(m_ShouldInitTun)
       {
@@ -405,33 +406,38 @@ namespace llarp
     huint128_t
     ExitEndpoint::AllocateNewAddress()
     {
-      if(m_NextAddr < m_HigestAddr)
-        return ++m_NextAddr;
-
-      // find oldest activity ip address
       huint128_t found = {0};
-      llarp_time_t min = std::numeric_limits< llarp_time_t >::max();
-      auto itr         = m_IPActivity.begin();
-      while(itr != m_IPActivity.end())
+      bool evicted     = false;
+      if(!m_IPPool.Allocate(found, evicted, GetRouter()->Now()))
       {
-        if(itr->second < min)
-        {
-          found.h = itr->first.h;
-          min     = itr->second;
-        }
-        ++itr;
+        LogError(Name(), " no address left to allocate");
+        return found;
       }
       // kick old ident off exit
       // TODO: DoS
-      PubKey pk = m_IPToKey[found];
-      KickIdentOffExit(pk);
-
+      if(evicted)
+      {
+        auto itr = m_IPToKey.find(found);
+        if(itr != m_IPToKey.end())
+        {
+          const PubKey pk = itr->second;
+          KickIdentOffExit(pk);
+          // kicking released it and nothing else was free or we would not
+          // have evicted, so this takes it right back
+          m_IPPool.Allocate(found, evicted, GetRouter()->Now());
+        }
+      }
       return found;
     }
 
     bool
     ExitEndpoint::QueueOutboundTraffic(const llarp_buffer_t &buf)
     {
+      if(!m_Policy.AllowOutbound(buf))
+      {
+        ++m_PolicyDropped;
+        return false;
+      }
       return llarp_ev_tun_async_write(&m_Tun, buf);
     }
 
@@ -442,6 +448,7 @@ namespace llarp
       huint128_t ip = m_KeyToIP[pk];
       m_KeyToIP.erase(pk);
       m_IPToKey.erase(ip);
+      m_IPPool.Release(ip);
       auto range    = m_ActiveExits.equal_range(pk);
       auto exit_itr = range.first;
       while(exit_itr != range.second)
@@ -451,12 +458,17 @@ namespace llarp
     void
     ExitEndpoint::MarkIPActive(huint128_t ip)
     {
-      m_IPActivity[ip] = GetRouter()->Now();
+      m_IPPool.Touch(ip, GetRouter()->Now());
     }
 
     void
     ExitEndpoint::OnInetPacket(const llarp_buffer_t &buf)
     {
+      if(!m_Policy.AllowInbound(buf))
+      {
+        ++m_PolicyDropped;
+        return;
+      }
       m_InetToNetwork.EmplaceIf(
           [b = ManagedBuffer(buf)](Pkt_t &pkt) -> bool { return pkt.Load(b); });
     }
@@ -576,8 +588,8 @@ namespace llarp
           return false;
         }
         m_OurRange.addr = m_IfAddr;
-        m_NextAddr      = m_IfAddr;
         m_HigestAddr    = m_IfAddr | (~m_OurRange.netmask_bits);
+        m_IPPool.Init(m_IfAddr, m_HigestAddr);
         LogInfo(Name(), " set ifaddr range to ", m_Tun.ifaddr, "/",
                 m_Tun.netmask, " lo=", m_IfAddr, " hi=", m_HigestAddr);
       }
@@ -591,16 +603,30 @@ namespace llarp
         strncpy(m_Tun.ifname, v.c_str(), sizeof(m_Tun.ifname) - 1);
         LogInfo(Name(), " set ifname to ", m_Tun.ifname);
       }
-      if(k == "exit-whitelist")
+      if(k == "tun-queues")
       {
-        // add exit policy whitelist rule
-        // TODO: implement me
-        return true;
+        const auto num = atoi(v.c_str());
+        if(num < 1)
+        {
+          LogError(Name(), " invalid tun-queues: ", v);
+          return false;
+        }
+        m_Tun.queues = num;
+        LogInfo(Name(), " reading tun with ", num, " queues");
       }
-      if(k == "exit-blacklist")
+      if(k == "exit-whitelist" || k == "exit-blacklist")
       {
-        // add exit policy blacklist rule
-        // TODO: implement me
+        exit::Policy policy;
+        IPRange range;
+        if(!exit::PolicyClassifier::ParseRule(v, policy, range))
+        {
+          LogError(Name(), " invalid ", k, " rule: ", v);
+          return false;
+        }
+        policy.drop = k == "exit-blacklist";
+        m_Policy.Add(policy, range);
+        m_Policy.Compile();
+        LogInfo(Name(), " added ", k, " rule: ", v);
         return true;
       }
 
@@ -2,8 +2,12 @@
 #define LLARP_HANDLERS_EXIT_HPP
 
 #include <exit/endpoint.hpp>
+#include <exit/policy_classifier.hpp>
 #include <handlers/tun.hpp>
 #include <dns/server.hpp>
+#include <net/ip_pool.hpp>
+
+#include <atomic>
 #include <unordered_map>
 
 namespace llarp
@@ -55,7 +59,8 @@ namespace llarp
       bool
       UpdateEndpointPath(const PubKey& remote, const PathID_t& next);
 
-      /// handle ip packet from outside
+      /// handle ip packet from outside, called on the net thread and on the
+      /// thread of every extra tun queue at once
       void
       OnInetPacket(const llarp_buffer_t& buf);
 
@@ -166,11 +171,11 @@ namespace llarp
       huint128_t m_IfAddr;
       huint128_t m_HigestAddr;
 
-      huint128_t m_NextAddr;
       IPRange m_OurRange;
 
-      std::unordered_map< huint128_t, llarp_time_t, huint128_t::Hash >
-          m_IPActivity;
+      /// hands out the addresses in our range and tracks when they were
+      /// last active
+      net::IPPool m_IPPool;
 
       llarp_tun_io m_Tun;
 
@@ -178,14 +183,21 @@ namespace llarp
       std::vector< Addr > m_UpstreamResolvers;
 
       using Pkt_t = net::IPPacket;
-      using PacketQueue_t =
-          util::CoDelQueue< Pkt_t, Pkt_t::GetTime, Pkt_t::PutTime,
-                            Pkt_t::CompareOrder, Pkt_t::GetNow, util::NullMutex,
-                            util::NullLock, 5, 100, 1024 >;
+      using PacketQueue_t = util::CoDelRing< Pkt_t, Pkt_t::GetTime,
+                                             Pkt_t::PutTime, Pkt_t::GetNow >;
+      static_assert(PacketQueue_t::MultiProducer,
+                    "every tun queue thread pushes inet packets into this");
 
-      /// internet to llarp packet queue
+      /// internet to llarp packet queue, pushed from every tun queue thread
+      /// and drained by Flush on the net thread
       PacketQueue_t m_InetToNetwork;
       bool m_UseV6;
+
+      /// exit-whitelist and exit-blacklist rules checked on every packet
+      exit::PolicyClassifier m_Policy;
+      /// packets dropped by m_Policy, counted on the logic thread and on
+      /// every tun queue thread
+      std::atomic< uint64_t > m_PolicyDropped{0};
     };
   }  // namespace handlers
 }  // namespace llarp
@@ -75,11 +75,11 @@ namespace llarp
       obj["ustreamResolvers"] = resolvers;
       obj["localResolver"]    = m_LocalResolverAddr.ToString();
       util::StatusObject ips{};
-      for(const auto &item : m_IPActivity)
+      for(const auto &item : m_IPToAddr)
       {
-        util::StatusObject ipObj{{"lastActive", item.second}};
+        util::StatusObject ipObj{{"lastActive", LastActive(item.first)}};
         std::string remoteStr;
-        AlignedBuffer< 32 > addr = m_IPToAddr.at(item.first);
+        const AlignedBuffer< 32 > &addr = item.second;
         if(m_SNodes.at(addr))
           remoteStr = RouterID(addr.as_array()).ToString();
         else
@@ -90,7 +90,7 @@ namespace llarp
       }
       obj["addrs"]  = ips;
       obj["ourIP"]  = m_OurIP.ToString();
-      obj["nextIP"] = m_NextIP.ToString();
+      obj["nextIP"] = m_IPPool.NextUnused().ToString();
       obj["maxIP"]  = m_MaxIP.ToString();
       return obj;
     }
@@ -229,6 +229,18 @@ namespace llarp
         llarp::LogInfo(Name() + " setting ifname to ", tunif.ifname);
         return true;
       }
+      if(k == "tun-queues")
+      {
+        const auto num = atoi(v.c_str());
+        if(num < 1)
+        {
+          llarp::LogError(Name() + " invalid tun-queues: ", v);
+          return false;
+        }
+        tunif.queues = num;
+        llarp::LogInfo(Name() + " reading tun with ", num, " queues");
+        return true;
+      }
       if(k == "ifaddr")
       {
         std::string addr;
@@ -637,9 +649,12 @@ namespace llarp
         m_OurRange.netmask_bits = netmask_ipv6_bits(tunif.netmask);
       }
 
-      m_NextIP        = m_OurIP;
       m_OurRange.addr = m_OurIP;
       m_MaxIP         = m_OurIP | (~m_OurRange.netmask_bits);
+      m_IPPool.Init(m_OurIP, m_MaxIP);
+      // keep what the config mapped before we knew our range
+      for(const auto &item : m_IPToAddr)
+        m_IPPool.Pin(item.first);
       llarp::LogInfo(Name(), " set ", tunif.ifname, " to have address ",
                      m_OurIP);
       llarp::LogInfo(Name(), " allocated up to ", m_MaxIP, " on range ",
@@ -812,8 +827,6 @@ namespace llarp
     huint128_t
     TunEndpoint::ObtainIPForAddr(const AlignedBuffer< 32 > &addr, bool snode)
     {
-      llarp_time_t now  = Now();
-      huint128_t nextIP = {0};
       AlignedBuffer< 32 > ident(addr);
       {
         // previously allocated address
@@ -825,53 +838,29 @@ namespace llarp
           return itr->second;
         }
       }
-      // allocate new address
-      if(m_NextIP < m_MaxIP)
+      // allocate new address, taking the least active one if we are full
+      // TODO: prevent DoS
+      huint128_t nextIP = {0};
+      bool evicted      = false;
+      if(!m_IPPool.Allocate(nextIP, evicted, Now()))
       {
-        do
-        {
-          nextIP = ++m_NextIP;
-        } while(m_IPToAddr.find(nextIP) != m_IPToAddr.end()
-                && m_NextIP < m_MaxIP);
-        if(nextIP < m_MaxIP)
-        {
-          m_AddrToIP[ident]  = nextIP;
-          m_IPToAddr[nextIP] = ident;
-          m_SNodes[ident]    = snode;
-          llarp::LogInfo(Name(), " mapped ", ident, " to ", nextIP);
-          MarkIPActive(nextIP);
-          return nextIP;
-        }
+        llarp::LogError(Name(), " no address left to map ", ident);
+        return nextIP;
       }
-
-      // we are full
-      // expire least active ip
-      // TODO: prevent DoS
-      std::pair< huint128_t, llarp_time_t > oldest = {huint128_t{0}, 0};
-
-      // find oldest entry
-      auto itr = m_IPActivity.begin();
-      while(itr != m_IPActivity.end())
+      if(evicted)
       {
-        if(itr->second <= now)
+        auto itr = m_IPToAddr.find(nextIP);
+        if(itr != m_IPToAddr.end())
         {
-          if((now - itr->second) > oldest.second)
-          {
-            oldest.first  = itr->first;
-            oldest.second = itr->second;
-          }
+          llarp::LogInfo(Name(), " unmapped ", itr->second, " from ", nextIP);
+          m_AddrToIP.erase(itr->second);
+          m_SNodes.erase(itr->second);
         }
-        ++itr;
       }
-      // remap address
-      m_IPToAddr[oldest.first] = ident;
-      m_AddrToIP[ident]        = oldest.first;
-      m_SNodes[ident]          = snode;
-      nextIP                   = oldest.first;
-
-      // mark ip active
-      m_IPActivity[nextIP] = std::max(m_IPActivity[nextIP], now);
-
+      m_AddrToIP[ident]  = nextIP;
+      m_IPToAddr[nextIP] = ident;
+      m_SNodes[ident]    = snode;
+      llarp::LogInfo(Name(), " mapped ", ident, " to ", nextIP);
       return nextIP;
     }
 
@@ -884,14 +873,22 @@ namespace llarp
     void
     TunEndpoint::MarkIPActive(huint128_t ip)
     {
-      llarp::LogDebug(Name(), " address ", ip, " is active");
-      m_IPActivity[ip] = std::max(Now(), m_IPActivity[ip]);
+      m_IPPool.Touch(ip, Now());
     }
 
     void
     TunEndpoint::MarkIPActiveForever(huint128_t ip)
     {
-      m_IPActivity[ip] = std::numeric_limits< uint64_t >::max();
+      m_IPPool.Pin(ip);
+    }
+
+    llarp_time_t
+    TunEndpoint::LastActive(huint128_t ip) const
+    {
+      // outside the pool is only us
+      if(!m_IPPool.Contains(ip))
+        return std::numeric_limits< llarp_time_t >::max();
+      return m_IPPool.LastActive(ip);
     }
 
     void
@@ -922,7 +919,8 @@ namespace llarp
     void
     TunEndpoint::tunifRecvPkt(llarp_tun_io *tun, const llarp_buffer_t &b)
     {
-      // called for every packet read from user in isolated network thread
+      // called for every packet read from user, on the net thread and on
+      // the thread of every extra tun queue at once
       auto *self = static_cast< TunEndpoint * >(tun->user);
       const ManagedBuffer buf(b);
       self->m_UserToNetworkPktQueue.EmplaceIf(
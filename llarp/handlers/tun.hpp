@@ -4,6 +4,7 @@
 #include <dns/server.hpp>
 #include <ev/ev.h>
 #include <net/ip.hpp>
+#include <net/ip_pool.hpp>
 #include <net/net.hpp>
 #include <service/endpoint.hpp>
 #include <util/codel.hpp>
@@ -169,9 +170,12 @@ namespace llarp
       ResetInternalState() override;
 
      protected:
-      using PacketQueue_t = llarp::util::CoDelQueue<
-          net::IPPacket, net::IPPacket::GetTime, net::IPPacket::PutTime,
-          net::IPPacket::CompareOrder, net::IPPacket::GetNow >;
+      using PacketQueue_t =
+          llarp::util::CoDelRing< net::IPPacket, net::IPPacket::GetTime,
+                                  net::IPPacket::PutTime,
+                                  net::IPPacket::GetNow >;
+      static_assert(PacketQueue_t::MultiProducer,
+                    "every tun queue thread pushes user packets into this");
       /// queue for sending packets over the network from us
       PacketQueue_t m_UserToNetworkPktQueue;
       /// queue for sending packets to user from network
@@ -188,6 +192,10 @@ namespace llarp
       void
       MarkIPActiveForever(huint128_t ip);
 
+      /// when this mapped address was last active
+      llarp_time_t
+      LastActive(huint128_t ip) const;
+
       /// flush ip packets
       virtual void
       FlushSend();
@@ -264,14 +272,12 @@ namespace llarp
       /// our dns resolver
       std::shared_ptr< dns::Proxy > m_Resolver;
 
-      /// maps ip address to timestamp last active
-      std::unordered_map< huint128_t, llarp_time_t, huint128_t::Hash >
-          m_IPActivity;
+      /// hands out the addresses in our range and tracks when they were
+      /// last active
+      net::IPPool m_IPPool;
       /// our ip address (host byte order)
       huint128_t m_OurIP;
-      /// next ip address to allocate (host byte order)
-      huint128_t m_NextIP;
-      /// highest ip address to allocate (host byte order)
+      /// highest ip address in our range (host byte order)
       huint128_t m_MaxIP;
       /// our ip range we are using
       llarp::IPRange m_OurRange;
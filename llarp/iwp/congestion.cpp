@@ -0,0 +1,159 @@
+#include <iwp/congestion.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace llarp
+{
+  namespace iwp
+  {
+    constexpr size_t CongestionControl::InitialWindow;
+    constexpr size_t CongestionControl::MinWindow;
+    constexpr size_t CongestionControl::MaxWindow;
+    constexpr llarp_time_t CongestionControl::InitialRTO;
+    constexpr llarp_time_t CongestionControl::MinRTO;
+    constexpr llarp_time_t CongestionControl::MaxRTO;
+    constexpr llarp_time_t CongestionControl::MaxAckDelay;
+    constexpr uint64_t CongestionControl::ReorderThreshold;
+    constexpr size_t CongestionControl::MinBurst;
+
+    void
+    CongestionControl::OnRTTSample(llarp_time_t rtt)
+    {
+      // a zero sample would look like no sample at all
+      rtt = std::max(rtt, llarp_time_t(1));
+      if(m_SRTT == 0)
+      {
+        m_SRTT   = rtt;
+        m_RTTVar = rtt / 2;
+      }
+      else
+      {
+        const llarp_time_t delta = m_SRTT > rtt ? m_SRTT - rtt : rtt - m_SRTT;
+        m_RTTVar                 = ((m_RTTVar * 3) + delta) / 4;
+        m_SRTT                   = ((m_SRTT * 7) + rtt) / 8;
+      }
+      // only the last fragment of a message is acked right away, the rest
+      // wait on the receiver's ack timer
+      const llarp_time_t rto =
+          m_SRTT + std::max(m_RTTVar * 4, MaxAckDelay);
+      m_RTO = std::max(MinRTO, std::min(MaxRTO, rto));
+    }
+
+    void
+    CongestionControl::OnAcked(size_t n)
+    {
+      if(m_Window < m_SSThresh)
+      {
+        // slow start
+        m_Window += n;
+      }
+      else
+      {
+        // congestion avoidance, one more fragment per window acked
+        m_AckedInWindow += n;
+        while(m_AckedInWindow >= m_Window)
+        {
+          m_AckedInWindow -= m_Window;
+          ++m_Window;
+        }
+      }
+      m_Window = std::min(m_Window, MaxWindow);
+    }
+
+    void
+    CongestionControl::OnFastRetransmit(uint64_t seqno, size_t lost)
+    {
+      m_Losses += lost;
+      // only back off once per window of data
+      if(seqno < m_RecoverySeqno)
+        return;
+      m_SSThresh      = std::max(m_Window / 2, MinWindow);
+      m_Window        = m_SSThresh;
+      m_AckedInWindow = 0;
+      m_RecoverySeqno = m_NextSeqno;
+    }
+
+    void
+    CongestionControl::OnTimeout(size_t lost)
+    {
+      m_Losses += lost;
+      ++m_Timeouts;
+      m_SSThresh      = std::max(m_Window / 2, MinWindow);
+      m_Window        = MinWindow;
+      m_AckedInWindow = 0;
+      m_RecoverySeqno = m_NextSeqno;
+      m_RTO           = std::min(m_RTO * 2, MaxRTO);
+    }
+
+    uint64_t
+    CongestionControl::OnSent(bool retransmit)
+    {
+      ++m_FragsSent;
+      if(retransmit)
+        ++m_Retransmits;
+      m_Tokens -= 1.0;
+      return m_NextSeqno++;
+    }
+
+    bool
+    CongestionControl::CanSend(size_t inflight, llarp_time_t now)
+    {
+      if(inflight >= m_Window)
+        return false;
+      Refill(now);
+      return m_Tokens >= 1.0;
+    }
+
+    llarp_time_t
+    CongestionControl::NextSendAt(llarp_time_t now) const
+    {
+      const double rate = Rate();
+      double tokens     = m_Tokens;
+      if(m_LastRefill && now > m_LastRefill)
+        tokens += double(now - m_LastRefill) * rate;
+      if(tokens >= 1.0)
+        return now + 1;
+      const auto wait = llarp_time_t(std::ceil((1.0 - tokens) / rate));
+      return now + std::max(wait, llarp_time_t(1));
+    }
+
+    double
+    CongestionControl::Rate() const
+    {
+      const llarp_time_t rtt = m_SRTT ? m_SRTT : InitialRTO;
+      // spread one window over one round trip
+      return double(m_Window) / double(rtt);
+    }
+
+    void
+    CongestionControl::Refill(llarp_time_t now)
+    {
+      if(now <= m_LastRefill)
+        return;
+      const double rate = Rate();
+      const double burst = double(std::max(m_Window / 2, MinBurst));
+      if(m_LastRefill)
+        m_Tokens += double(now - m_LastRefill) * rate;
+      m_Tokens     = std::min(m_Tokens, std::max(burst, 1.0));
+      m_LastRefill = now;
+    }
+
+    util::StatusObject
+    CongestionControl::ExtractStatus() const
+    {
+      const double loss =
+          m_FragsSent ? double(m_Losses) / double(m_FragsSent) : 0.0;
+      return {{"cwnd", m_Window},
+              {"ssthresh", m_SSThresh},
+              {"srtt", m_SRTT},
+              {"rttvar", m_RTTVar},
+              {"rto", m_RTO},
+              {"sent", m_FragsSent},
+              {"retransmits", m_Retransmits},
+              {"lost", m_Losses},
+              {"timeouts", m_Timeouts},
+              {"loss", loss}};
+    }
+  }  // namespace iwp
+}  // namespace llarp
@@ -0,0 +1,117 @@
+#ifndef LLARP_IWP_CONGESTION_HPP
+#define LLARP_IWP_CONGESTION_HPP
+
+#include <util/status.hpp>
+#include <util/types.hpp>
+
+namespace llarp
+{
+  namespace iwp
+  {
+    /// per session NewReno style congestion window with an RFC 6298
+    /// retransmit timer and a token bucket pacer, all counted in fragments
+    struct CongestionControl
+    {
+      /// window we start with, one full sized link message
+      static constexpr size_t InitialWindow = 8;
+      /// smallest window we shrink down to
+      static constexpr size_t MinWindow = 2;
+      /// biggest window we grow up to
+      static constexpr size_t MaxWindow = 1024;
+      /// retransmit timeout before we have any rtt sample
+      static constexpr llarp_time_t InitialRTO = 750;
+      /// lower bound on the retransmit timeout
+      static constexpr llarp_time_t MinRTO = 200;
+      /// upper bound on the retransmit timeout
+      static constexpr llarp_time_t MaxRTO = 3000;
+      /// longest a receiver holds back acks for a partial message, the
+      /// retransmit timeout never fires sooner than this after a round trip
+      static constexpr llarp_time_t MaxAckDelay = 500;
+      /// how many later sent fragments must be acked before we declare an
+      /// unacked fragment lost without waiting on the retransmit timer
+      static constexpr uint64_t ReorderThreshold = 3;
+      /// smallest burst the pacer lets out at once
+      static constexpr size_t MinBurst = 4;
+
+      /// feed a round trip time sample
+      void
+      OnRTTSample(llarp_time_t rtt);
+
+      /// n fragments were acknowledged
+      void
+      OnAcked(size_t n);
+
+      /// a later ack showed lost fragments, the oldest sent at seqno
+      void
+      OnFastRetransmit(uint64_t seqno, size_t lost);
+
+      /// the retransmit timer fired on lost fragments
+      void
+      OnTimeout(size_t lost);
+
+      /// a fragment went out on the wire, returns its send seqno
+      uint64_t
+      OnSent(bool retransmit);
+
+      /// return true if we may put another fragment on the wire
+      bool
+      CanSend(size_t inflight, llarp_time_t now);
+
+      /// when the pacer has a token for the next fragment, always after now
+      llarp_time_t
+      NextSendAt(llarp_time_t now) const;
+
+      llarp_time_t
+      RTO() const
+      {
+        return m_RTO;
+      }
+
+      llarp_time_t
+      SRTT() const
+      {
+        return m_SRTT;
+      }
+
+      size_t
+      Window() const
+      {
+        return m_Window;
+      }
+
+      util::StatusObject
+      ExtractStatus() const;
+
+     private:
+      /// fragments per ms the pacer lets out
+      double
+      Rate() const;
+
+      void
+      Refill(llarp_time_t now);
+
+      size_t m_Window        = InitialWindow;
+      size_t m_SSThresh      = MaxWindow;
+      size_t m_AckedInWindow = 0;
+
+      llarp_time_t m_SRTT   = 0;
+      llarp_time_t m_RTTVar = 0;
+      llarp_time_t m_RTO    = InitialRTO;
+
+      /// send seqno of the next fragment we put on the wire
+      uint64_t m_NextSeqno = 0;
+      /// fragments sent before this seqno belong to the last recovery
+      uint64_t m_RecoverySeqno = 0;
+
+      double m_Tokens           = InitialWindow;
+      llarp_time_t m_LastRefill = 0;
+
+      uint64_t m_FragsSent   = 0;
+      uint64_t m_Retransmits = 0;
+      uint64_t m_Losses      = 0;
+      uint64_t m_Timeouts    = 0;
+    };
+  }  // namespace iwp
+}  // namespace llarp
+
+#endif
@@ -19,33 +19,6 @@ namespace llarp
 
     LinkLayer::~LinkLayer() = default;
 
-    void
-    LinkLayer::Pump()
-    {
-      std::set< RouterID > sessions;
-      {
-        Lock l(&m_AuthedLinksMutex);
-        auto itr = m_AuthedLinks.begin();
-        while(itr != m_AuthedLinks.end())
-        {
-          sessions.insert(itr->first);
-          ++itr;
-        }
-      }
-      ILinkLayer::Pump();
-      {
-        Lock l(&m_AuthedLinksMutex);
-        for(const auto& pk : sessions)
-        {
-          if(m_AuthedLinks.count(pk) == 0)
-          {
-            // all sessions were removed
-            SessionClosed(pk);
-          }
-        }
-      }
-    }
-
     const char*
     LinkLayer::Name() const
     {
@@ -84,7 +57,9 @@ namespace llarp
         {
           if(not permitInbound)
             return;
-          m_Pending.insert({from, std::make_shared< Session >(this, from)});
+          auto inbound = std::make_shared< Session >(this, from);
+          m_Pending.insert({from, inbound});
+          SchedulePump(inbound.get(), 0);
         }
         session = m_Pending.find(from)->second;
       }
@@ -97,6 +72,7 @@ namespace llarp
       {
         const llarp_buffer_t buf{pkt, sz};
         session->Recv_LL(buf);
+        WakeSession(session.get());
       }
     }
 
@@ -5,6 +5,7 @@
 #include <crypto/crypto.hpp>
 #include <crypto/encrypted.hpp>
 #include <crypto/types.hpp>
+#include <iwp/message_buffer.hpp>
 #include <link/server.hpp>
 
 namespace llarp
@@ -28,9 +29,6 @@ namespace llarp
       NewOutboundSession(const RouterContact &rc,
                          const AddressInfo &ai) override;
 
-      void
-      Pump() override;
-
       bool
       KeyGen(SecretKey &k) override;
 
@@ -49,7 +47,16 @@ namespace llarp
       void
       UnmapAddr(const Addr &addr);
 
+      /// packet buffers used by the session crypto pipeline
+      PacketPool &
+      Packets()
+      {
+        return *m_Packets;
+      }
+
      private:
+      const std::shared_ptr< PacketPool > m_Packets =
+          std::make_shared< PacketPool >();
       std::unordered_map< Addr, RouterID, Addr::Hash > m_AuthedAddrs;
       const bool permitInbound;
     };
@@ -6,6 +6,76 @@ namespace llarp
 {
   namespace iwp
   {
+    bool
+    PacketBuffer::Resize(size_t sz)
+    {
+      if(sz > m_Data.size())
+        return false;
+      m_Size = sz;
+      return true;
+    }
+
+    bool
+    PacketBuffer::Append(const byte_t *ptr, size_t sz)
+    {
+      if(m_Size + sz > m_Data.size())
+        return false;
+      std::copy_n(ptr, sz, m_Data.begin() + m_Size);
+      m_Size += sz;
+      return true;
+    }
+
+    PacketPool::~PacketPool()
+    {
+      util::Lock lock(&m_Access);
+      for(auto pkt : m_Idle)
+        delete pkt;
+      m_Idle.clear();
+    }
+
+    PacketPool::Packet_ptr
+    PacketPool::Get()
+    {
+      PacketBuffer *pkt = nullptr;
+      {
+        util::Lock lock(&m_Access);
+        if(not m_Idle.empty())
+        {
+          pkt = m_Idle.back();
+          m_Idle.pop_back();
+        }
+      }
+      if(pkt == nullptr)
+        pkt = new PacketBuffer();
+      pkt->Resize(0);
+      return Packet_ptr(pkt, Release{shared_from_this()});
+    }
+
+    void
+    PacketPool::Put(PacketBuffer *pkt)
+    {
+      {
+        util::Lock lock(&m_Access);
+        if(m_Idle.size() < MaxIdle)
+        {
+          m_Idle.push_back(pkt);
+          return;
+        }
+      }
+      delete pkt;
+    }
+
+    bool
+    AddRandomPadding(PacketBuffer &pkt, size_t min, size_t variance)
+    {
+      const auto sz        = pkt.size();
+      const size_t randpad = min + randint() % variance;
+      if(not pkt.Resize(sz + randpad))
+        return false;
+      CryptoManager::instance()->randbytes(pkt.data() + sz, randpad);
+      return true;
+    }
+
     OutboundMessage::OutboundMessage(uint64_t msgid, const llarp_buffer_t &pkt,
                                      llarp_time_t now,
                                      ILinkSession::CompletionHandler handler)
@@ -20,15 +90,14 @@ namespace llarp
       CryptoManager::instance()->shorthash(digest, buf);
     }
 
-    std::vector< byte_t >
-    OutboundMessage::XMIT() const
+    bool
+    OutboundMessage::XMIT(PacketBuffer &xmit) const
     {
-      std::vector< byte_t > xmit{
+      xmit = PacketBuffer{
           LLARP_PROTO_VERSION, Command::eXMIT, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
       htobe16buf(xmit.data() + 2, m_Size);
       htobe64buf(xmit.data() + 4, m_MsgID);
-      std::copy(digest.begin(), digest.end(), std::back_inserter(xmit));
-      return xmit;
+      return xmit.Append(digest.data(), digest.size());
     }
 
     void
@@ -41,53 +110,114 @@ namespace llarp
       m_Completed = nullptr;
     }
 
+    AckInfo
+    OutboundMessage::Ack(byte_t bitmask)
+    {
+      AckInfo info;
+      const std::bitset< MaxFragments > acks(bitmask);
+      for(size_t idx = 0; idx < NumFragments(); ++idx)
+      {
+        if(m_Acks.test(idx) or not acks.test(idx))
+          continue;
+        m_Acks.set(idx);
+        m_InFlight.reset(idx);
+        if(not m_Sent.test(idx))
+          continue;
+        ++info.acked;
+        info.highestSeqno = std::max(info.highestSeqno, m_SentSeqno[idx]);
+        if(not m_Retransmitted.test(idx))
+          info.sampleSentAt = std::max(info.sampleSentAt, m_SentAt[idx]);
+      }
+      return info;
+    }
+
+    size_t
+    OutboundMessage::NumFragments() const
+    {
+      return (m_Size + FragmentSize - 1) / FragmentSize;
+    }
+
     bool
-    OutboundMessage::ShouldFlush(llarp_time_t now) const
+    OutboundMessage::NextFragment(size_t &idx) const
     {
-      return now - m_LastFlush >= Session::TXFlushInterval;
+      for(idx = 0; idx < NumFragments(); ++idx)
+      {
+        if(not(m_Acks.test(idx) or m_InFlight.test(idx)))
+          return true;
+      }
+      return false;
     }
 
-    void
-    OutboundMessage::Ack(byte_t bitmask)
+    bool
+    OutboundMessage::SendFragment(
+        size_t idx, uint64_t seqno, llarp_time_t now,
+        std::function< void(const llarp_buffer_t &) > sendpkt)
     {
-      m_Acks = std::bitset< 8 >(bitmask);
+      const size_t offset = idx * FragmentSize;
+      PacketBuffer frag{
+          LLARP_PROTO_VERSION, Command::eDATA, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+      htobe16buf(frag.data() + 2, offset);
+      htobe64buf(frag.data() + 4, m_MsgID);
+      const size_t fragsz = std::min(FragmentSize, m_Size - offset);
+      if(not frag.Append(m_Data.data() + offset, fragsz))
+        return false;
+      if(m_Sent.test(idx))
+        m_Retransmitted.set(idx);
+      m_Sent.set(idx);
+      m_InFlight.set(idx);
+      m_SentAt[idx]    = now;
+      m_SentSeqno[idx] = seqno;
+      const llarp_buffer_t pkt(frag);
+      sendpkt(pkt);
+      return true;
     }
 
-    void
-    OutboundMessage::FlushUnAcked(
-        std::function< void(const llarp_buffer_t &) > sendpkt, llarp_time_t now)
+    size_t
+    OutboundMessage::DetectLoss(uint64_t highestAcked, uint64_t threshold,
+                                uint64_t &oldestLost)
     {
-      uint16_t idx = 0;
-      while(idx < m_Size)
+      size_t lost = 0;
+      for(size_t idx = 0; idx < NumFragments(); ++idx)
       {
-        if(not m_Acks[idx / FragmentSize])
+        if(not m_InFlight.test(idx))
+          continue;
+        if(m_SentSeqno[idx] + threshold > highestAcked)
+          continue;
+        m_InFlight.reset(idx);
+        oldestLost = lost ? std::min(oldestLost, m_SentSeqno[idx])
+                          : m_SentSeqno[idx];
+        ++lost;
+      }
+      return lost;
+    }
+
+    size_t
+    OutboundMessage::ExpireInFlight(llarp_time_t now, llarp_time_t rto)
+    {
+      size_t lost = 0;
+      for(size_t idx = 0; idx < NumFragments(); ++idx)
+      {
+        if(m_InFlight.test(idx) and now - m_SentAt[idx] >= rto)
         {
-          std::vector< byte_t > frag{LLARP_PROTO_VERSION,
-                                     Command::eDATA,
-                                     0,
-                                     0,
-                                     0,
-                                     0,
-                                     0,
-                                     0,
-                                     0,
-                                     0,
-                                     0,
-                                     0};
-          htobe16buf(frag.data() + 2, idx);
-          htobe64buf(frag.data() + 4, m_MsgID);
-          const size_t fragsz =
-              idx + FragmentSize < m_Size ? FragmentSize : m_Size - idx;
-          const auto sz = frag.size();
-          frag.resize(sz + fragsz);
-          std::copy(m_Data.begin() + idx, m_Data.begin() + idx + fragsz,
-                    frag.begin() + sz);
-          const llarp_buffer_t pkt(frag);
-          sendpkt(pkt);
+          m_InFlight.reset(idx);
+          ++lost;
         }
-        idx += FragmentSize;
       }
-      m_LastFlush = now;
+      return lost;
+    }
+
+    llarp_time_t
+    OutboundMessage::NextExpiryAt(llarp_time_t rto) const
+    {
+      llarp_time_t next = 0;
+      for(size_t idx = 0; idx < NumFragments(); ++idx)
+      {
+        if(not m_InFlight.test(idx))
+          continue;
+        const llarp_time_t at = m_SentAt[idx] + rto;
+        next                  = next ? std::min(next, at) : at;
+      }
+      return next;
     }
 
     bool
@@ -140,20 +270,20 @@ namespace llarp
       m_LastActiveAt = now;
     }
 
-    std::vector< byte_t >
+    PacketBuffer
     InboundMessage::ACKS() const
     {
-      std::vector< byte_t > acks{LLARP_PROTO_VERSION,
-                                 Command::eACKS,
-                                 0,
-                                 0,
-                                 0,
-                                 0,
-                                 0,
-                                 0,
-                                 0,
-                                 0,
-                                 uint8_t{(uint8_t)m_Acks.to_ulong()}};
+      PacketBuffer acks{LLARP_PROTO_VERSION,
+                        Command::eACKS,
+                        0,
+                        0,
+                        0,
+                        0,
+                        0,
+                        0,
+                        0,
+                        0,
+                        uint8_t{(uint8_t)m_Acks.to_ulong()}};
 
       htobe64buf(acks.data() + 2, m_MsgID);
       return acks;
@@ -173,7 +303,7 @@ namespace llarp
     bool
     InboundMessage::ShouldSendACKS(llarp_time_t now) const
     {
-      return now - m_LastACKSent > 1000 || IsCompleted();
+      return now - m_LastACKSent > Session::ACKResendInterval || IsCompleted();
     }
 
     bool
@@ -183,15 +313,17 @@ namespace llarp
           && now - m_LastActiveAt > Session::DeliveryTimeout;
     }
 
-    void
+    bool
     InboundMessage::SendACKS(
         std::function< void(const llarp_buffer_t &) > sendpkt, llarp_time_t now)
     {
       auto acks = ACKS();
-      AddRandomPadding(acks);
+      if(not AddRandomPadding(acks))
+        return false;
       const llarp_buffer_t pkt(acks);
       sendpkt(pkt);
       m_LastACKSent = now;
+      return true;
     }
 
     bool
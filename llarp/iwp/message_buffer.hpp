@@ -1,12 +1,18 @@
 #ifndef LLARP_IWP_MESSAGE_BUFFER_HPP
 #define LLARP_IWP_MESSAGE_BUFFER_HPP
 #include <vector>
+#include <array>
+#include <initializer_list>
 #include <constants/link_layer.hpp>
+#include <crypto/constants.hpp>
 #include <link/session.hpp>
 #include <util/aligned.hpp>
 #include <util/buffer.hpp>
+#include <util/thread/threading.hpp>
 #include <util/types.hpp>
 
+#include <memory>
+
 namespace llarp
 {
   namespace iwp
@@ -28,6 +34,123 @@ namespace llarp
     };
 
     static constexpr size_t FragmentSize = 1024;
+    /// most fragments a link message is split into
+    static constexpr size_t MaxFragments = MAX_LINK_MSG_SIZE / FragmentSize;
+    /// command, offset and msgid in front of each fragment
+    static constexpr size_t FragmentHeaderSize = 12;
+    /// least random padding we add to a control packet
+    static constexpr size_t PaddingMin = 16;
+    /// how much random padding we add on top of PaddingMin
+    static constexpr size_t PaddingVariance = 16;
+    /// keyed hash and nonce in front of each encrypted packet
+    static constexpr size_t PacketOverhead = HMACSIZE + TUNNONCESIZE;
+    /// biggest packet we send or accept
+    static constexpr size_t MaxPacketSize = PacketOverhead + FragmentHeaderSize
+        + FragmentSize + PaddingMin + PaddingVariance;
+
+    /// fixed capacity packet buffer so the session data path can build and
+    /// parse packets without a heap allocation per packet
+    struct PacketBuffer
+    {
+      PacketBuffer() = default;
+
+      PacketBuffer(std::initializer_list< byte_t > init)
+      {
+        Append(init.begin(), init.size());
+      }
+
+      byte_t *
+      data()
+      {
+        return m_Data.data();
+      }
+
+      const byte_t *
+      data() const
+      {
+        return m_Data.data();
+      }
+
+      size_t
+      size() const
+      {
+        return m_Size;
+      }
+
+      byte_t &operator[](size_t idx)
+      {
+        return m_Data[idx];
+      }
+
+      byte_t operator[](size_t idx) const
+      {
+        return m_Data[idx];
+      }
+
+      /// return false if sz does not fit
+      bool
+      Resize(size_t sz);
+
+      /// return false if sz more bytes do not fit
+      bool
+      Append(const byte_t *ptr, size_t sz);
+
+     private:
+      std::array< byte_t, MaxPacketSize > m_Data;
+      size_t m_Size = 0;
+    };
+
+    /// bounded free list of packet buffers shared by the logic thread and the
+    /// link crypto workers
+    struct PacketPool : public std::enable_shared_from_this< PacketPool >
+    {
+      /// most idle buffers we keep around
+      static constexpr size_t MaxIdle = 4096;
+
+      /// hands the buffer back to the pool it came from
+      struct Release
+      {
+        std::shared_ptr< PacketPool > pool;
+
+        void
+        operator()(PacketBuffer *pkt) const
+        {
+          pool->Put(pkt);
+        }
+      };
+
+      using Packet_ptr = std::unique_ptr< PacketBuffer, Release >;
+
+      ~PacketPool();
+
+      /// get an empty packet buffer, allocates if there is no idle one
+      Packet_ptr
+      Get();
+
+     private:
+      void
+      Put(PacketBuffer *pkt);
+
+      util::Mutex m_Access;
+      std::vector< PacketBuffer * > m_Idle GUARDED_BY(m_Access);
+    };
+
+    /// return false if the padding does not fit
+    bool
+    AddRandomPadding(PacketBuffer &pkt, size_t min = PaddingMin,
+                     size_t variance = PaddingVariance);
+
+    /// what a selective ack told us about an outbound message
+    struct AckInfo
+    {
+      /// how many fragments were newly acked
+      size_t acked = 0;
+      /// highest send seqno among the newly acked fragments
+      uint64_t highestSeqno = 0;
+      /// newest send time among newly acked fragments that were only sent
+      /// once, 0 if there is no usable rtt sample
+      llarp_time_t sampleSentAt = 0;
+    };
 
     struct OutboundMessage
     {
@@ -39,24 +162,65 @@ namespace llarp
       AlignedBuffer< MAX_LINK_MSG_SIZE > m_Data;
       uint16_t m_Size  = 0;
       uint64_t m_MsgID = 0;
-      std::bitset< MAX_LINK_MSG_SIZE / FragmentSize > m_Acks;
+      std::bitset< MaxFragments > m_Acks;
+      /// fragments we sent at least once
+      std::bitset< MaxFragments > m_Sent;
+      /// fragments on the wire that are neither acked nor declared lost
+      std::bitset< MaxFragments > m_InFlight;
+      /// fragments sent more than once, we take no rtt samples from these
+      std::bitset< MaxFragments > m_Retransmitted;
+      std::array< llarp_time_t, MaxFragments > m_SentAt;
+      std::array< uint64_t, MaxFragments > m_SentSeqno;
       ILinkSession::CompletionHandler m_Completed;
-      llarp_time_t m_LastFlush = 0;
       ShortHash digest;
       llarp_time_t m_StartedAt = 0;
 
-      std::vector< byte_t >
-      XMIT() const;
+      /// return false if the xmit does not fit in xmit
+      bool
+      XMIT(PacketBuffer &xmit) const;
 
-      void
+      /// apply a selective ack bitmask
+      AckInfo
       Ack(byte_t bitmask);
 
-      void
-      FlushUnAcked(std::function< void(const llarp_buffer_t &) > sendpkt,
-                   llarp_time_t now);
+      size_t
+      NumFragments() const;
 
+      /// find the first fragment that is neither acked nor in flight
       bool
-      ShouldFlush(llarp_time_t now) const;
+      NextFragment(size_t &idx) const;
+
+      bool
+      WasSent(size_t idx) const
+      {
+        return m_Sent.test(idx);
+      }
+
+      /// put fragment idx on the wire with send seqno, return false and
+      /// leave the fragment unsent if it does not fit in a packet
+      bool
+      SendFragment(size_t idx, uint64_t seqno, llarp_time_t now,
+                   std::function< void(const llarp_buffer_t &) > sendpkt);
+
+      size_t
+      InFlight() const
+      {
+        return m_InFlight.count();
+      }
+
+      /// declare in flight fragments sent at least threshold seqnos before
+      /// highestAcked lost, return how many and the oldest seqno among them
+      size_t
+      DetectLoss(uint64_t highestAcked, uint64_t threshold,
+                 uint64_t &oldestLost);
+
+      /// declare in flight fragments older than rto lost, return how many
+      size_t
+      ExpireInFlight(llarp_time_t now, llarp_time_t rto);
+
+      /// when ExpireInFlight next has something to expire, 0 for never
+      llarp_time_t
+      NextExpiryAt(llarp_time_t rto) const;
 
       void
       Completed();
@@ -83,7 +247,7 @@ namespace llarp
       uint64_t m_MsgID            = 0;
       llarp_time_t m_LastACKSent  = 0;
       llarp_time_t m_LastActiveAt = 0;
-      std::bitset< MAX_LINK_MSG_SIZE / FragmentSize > m_Acks;
+      std::bitset< MaxFragments > m_Acks;
 
       void
       HandleData(uint16_t idx, const llarp_buffer_t &buf, llarp_time_t now);
@@ -100,11 +264,11 @@ namespace llarp
       bool
       ShouldSendACKS(llarp_time_t now) const;
 
-      void
+      bool
       SendACKS(std::function< void(const llarp_buffer_t &) > sendpkt,
                llarp_time_t now);
 
-      std::vector< byte_t >
+      PacketBuffer
       ACKS() const;
     };
 
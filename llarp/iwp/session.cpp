@@ -1,24 +1,16 @@
 #include <iwp/session.hpp>
 
+#include <ev/ev.hpp>
 #include <messages/link_intro.hpp>
 #include <messages/discard.hpp>
 #include <util/meta/memfn.hpp>
 
+#include <algorithm>
+
 namespace llarp
 {
   namespace iwp
   {
-    static constexpr size_t PacketOverhead = HMACSIZE + TUNNONCESIZE;
-
-    void
-    AddRandomPadding(std::vector< byte_t >& pkt, size_t min, size_t variance)
-    {
-      const auto sz        = pkt.size();
-      const size_t randpad = min + randint() % variance;
-      pkt.resize(sz + randpad);
-      CryptoManager::instance()->randbytes(pkt.data() + sz, randpad);
-    }
-
     Session::Session(LinkLayer* p, RouterContact rc, AddressInfo ai)
         : m_State{State::Initial}
         , m_Inbound{false}
@@ -115,29 +107,166 @@ namespace llarp
       LogDebug("sent LIM to ", m_RemoteAddr);
     }
 
+    bool
+    Session::EncryptInPlace(PacketBuffer& pkt, const SharedSecret& key)
+    {
+      if(pkt.size() < PacketOverhead)
+        return false;
+      byte_t* nonce_ptr = pkt.data() + HMACSIZE;
+      CryptoManager::instance()->randbytes(nonce_ptr, TUNNONCESIZE);
+      llarp_buffer_t pktbuf(pkt.data() + PacketOverhead,
+                            pkt.size() - PacketOverhead);
+      if(not CryptoManager::instance()->xchacha20_alt(pktbuf, pktbuf, key,
+                                                      nonce_ptr))
+        return false;
+      pktbuf.base = nonce_ptr;
+      pktbuf.sz   = pkt.size() - HMACSIZE;
+      return CryptoManager::instance()->hmac(pkt.data(), pktbuf, key);
+    }
+
+    bool
+    Session::DecryptInPlace(PacketBuffer& pkt, const SharedSecret& key)
+    {
+      if(pkt.size() <= PacketOverhead)
+        return false;
+      ShortHash H;
+      llarp_buffer_t curbuf(pkt.data() + HMACSIZE, pkt.size() - HMACSIZE);
+      if(not CryptoManager::instance()->hmac(H.data(), curbuf, key))
+        return false;
+      if(H != ShortHash{pkt.data()})
+        return false;
+      const byte_t* nonce_ptr = curbuf.base;
+      curbuf.base += TUNNONCESIZE;
+      curbuf.sz -= TUNNONCESIZE;
+      if(not CryptoManager::instance()->xchacha20_alt(curbuf, curbuf, key,
+                                                      nonce_ptr))
+        return false;
+      std::copy_n(curbuf.base, curbuf.sz, pkt.data());
+      return pkt.Resize(curbuf.sz);
+    }
+
     void
     Session::EncryptAndSend(const llarp_buffer_t& data)
     {
-      std::vector< byte_t > pkt;
-      pkt.resize(data.sz + PacketOverhead);
-      CryptoManager::instance()->randbytes(pkt.data(), pkt.size());
-      llarp_buffer_t pktbuf(pkt);
-      pktbuf.base += PacketOverhead;
-      pktbuf.cur = pktbuf.base;
-      pktbuf.sz -= PacketOverhead;
-      byte_t* nonce_ptr = pkt.data() + HMACSIZE;
+      if(m_Parent->CryptoWorker())
+      {
+        auto pkt = m_Parent->Packets().Get();
+        if(not(pkt->Resize(PacketOverhead) && pkt->Append(data.base, data.sz)))
+        {
+          LogError("cannot send ", data.sz, " byte packet to ", m_RemoteAddr);
+          return;
+        }
+        QueueCrypto(m_EncryptQueue, std::move(pkt), true);
+        return;
+      }
+      EncryptAndSendNow(data);
+    }
 
-      CryptoManager::instance()->xchacha20_alt(pktbuf, data, m_SessionKey,
-                                               nonce_ptr);
+    void
+    Session::EncryptAndSendNow(const llarp_buffer_t& data)
+    {
+      PacketBuffer pkt;
+      if(not(pkt.Resize(PacketOverhead) && pkt.Append(data.base, data.sz)))
+      {
+        LogError("cannot send ", data.sz, " byte packet to ", m_RemoteAddr);
+        return;
+      }
+      if(not EncryptInPlace(pkt, m_SessionKey))
+      {
+        LogError("failed to encrypt packet for ", m_RemoteAddr);
+        return;
+      }
+      const llarp_buffer_t sendbuf(pkt);
+      Send_LL(sendbuf);
+    }
 
-      pktbuf.base = nonce_ptr;
-      pktbuf.sz   = data.sz + 32;
-      CryptoManager::instance()->hmac(pkt.data(), pktbuf, m_SessionKey);
+    void
+    Session::QueueCrypto(CryptoQueue& q, Packet_ptr pkt, bool encrypt)
+    {
+      q.pending.emplace_back(std::move(pkt));
+      if(q.pending.size() >= CryptoBatchSize)
+      {
+        DispatchCrypto(q, encrypt);
+        return;
+      }
+      if(m_CryptoFlushQueued)
+        return;
+      m_CryptoFlushQueued = true;
+      auto self           = shared_from_this();
+      m_Parent->logic()->queue_func([self]() {
+        self->m_CryptoFlushQueued = false;
+        self->FlushCrypto();
+      });
+    }
+
+    void
+    Session::FlushCrypto()
+    {
+      if(not m_EncryptQueue.pending.empty())
+        DispatchCrypto(m_EncryptQueue, true);
+      if(not m_DecryptQueue.pending.empty())
+        DispatchCrypto(m_DecryptQueue, false);
+    }
 
-      pktbuf.base = pkt.data();
-      pktbuf.cur  = pkt.data();
-      pktbuf.sz   = pkt.size();
-      Send_LL(pktbuf);
+    void
+    Session::DispatchCrypto(CryptoQueue& q, bool encrypt)
+    {
+      auto self  = shared_from_this();
+      auto batch = std::make_shared< CryptoBatch >(std::move(q.pending));
+      q.pending.clear();
+      const auto seqno = q.dispatchSeqno++;
+      const auto key   = m_SessionKey;
+      auto logic       = m_Parent->logic();
+      auto loop        = m_Parent->evloop();
+      auto job = [self, batch, seqno, key, logic, loop, encrypt]() {
+        for(auto& pkt : *batch)
+        {
+          const bool ok = encrypt ? EncryptInPlace(*pkt, key)
+                                  : DecryptInPlace(*pkt, key);
+          // an empty packet tells the logic thread it failed
+          if(not ok)
+            pkt->Resize(0);
+        }
+        logic->queue_func([self, batch, seqno, encrypt]() {
+          self->DeliverCrypto(seqno, std::move(*batch), encrypt);
+        });
+        if(loop)
+          loop->wakeup();
+      };
+      // do not block the logic thread on a full worker queue
+      if(not m_Parent->CryptoWorker()->tryAddJob(job))
+        job();
+    }
+
+    void
+    Session::DeliverCrypto(uint64_t seqno, CryptoBatch batch, bool encrypted)
+    {
+      auto& q = encrypted ? m_EncryptQueue : m_DecryptQueue;
+      q.done.emplace(seqno, std::move(batch));
+      while(not q.done.empty() && q.done.begin()->first == q.deliverSeqno)
+      {
+        for(const auto& pkt : q.done.begin()->second)
+        {
+          // drop whatever is in flight once we are closed
+          if(m_State == State::Closed)
+            break;
+          if(pkt->size() == 0)
+          {
+            LogError("failed to ", encrypted ? "encrypt" : "decrypt",
+                     " packet for ", m_RemoteAddr);
+            continue;
+          }
+          const llarp_buffer_t buf(*pkt);
+          if(encrypted)
+            Send_LL(buf);
+          else
+            HandlePlaintext(*pkt);
+        }
+        q.done.erase(q.done.begin());
+        ++q.deliverSeqno;
+      }
+      if(not encrypted)
+        m_Parent->WakeSession(this);
     }
 
     void
@@ -145,10 +274,15 @@ namespace llarp
     {
       if(m_State == State::Closed)
         return;
-      std::vector< byte_t > close_msg = {LLARP_PROTO_VERSION, Command::eCLOS};
-      AddRandomPadding(close_msg);
-      const llarp_buffer_t buf(close_msg);
-      EncryptAndSend(buf);
+      PacketBuffer close_msg{LLARP_PROTO_VERSION, Command::eCLOS};
+      if(AddRandomPadding(close_msg))
+      {
+        const llarp_buffer_t buf(close_msg);
+        // skip the crypto pipeline, it drops everything once we are closed
+        EncryptAndSendNow(buf);
+      }
+      else
+        LogError("cannot pad close message to ", m_RemoteAddr);
       if(m_State == State::Ready)
         m_Parent->UnmapAddr(m_RemoteAddr);
       m_State = State::Closed;
@@ -164,11 +298,19 @@ namespace llarp
       auto& msg =
           m_TXMsgs.emplace(msgid, OutboundMessage{msgid, buf, now, completed})
               .first->second;
-      auto xmit = msg.XMIT();
-      AddRandomPadding(xmit);
+      PacketBuffer xmit;
+      if(not(msg.XMIT(xmit) && AddRandomPadding(xmit)))
+      {
+        LogError("cannot build xmit for message ", msgid, " to ",
+                 m_RemoteAddr);
+        m_TXMsgs.erase(msgid);
+        return false;
+      }
       const llarp_buffer_t pkt(xmit);
       EncryptAndSend(pkt);
-      msg.FlushUnAcked(util::memFn(&Session::EncryptAndSend, this), now);
+      FlushTX(now);
+      // so Pump picks up the retransmit timer
+      m_Parent->WakeSession(this);
       LogDebug("send message ", msgid);
       return true;
     }
@@ -177,25 +319,76 @@ namespace llarp
     Session::Pump()
     {
       const auto now = m_Parent->Now();
-      if(m_State == State::Ready || m_State == State::LinkIntro)
+      const bool running =
+          m_State == State::Ready || m_State == State::LinkIntro;
+      // we always come back to time out
+      m_NextPumpAt =
+          (running ? m_LastRX : m_CreatedAt) + SessionAliveTimeout + 1;
+      const auto pumpBy = [&](llarp_time_t at) {
+        if(at)
+          m_NextPumpAt = std::min(m_NextPumpAt, at);
+      };
+      if(not running)
+        return;
+      if(ShouldPing())
+        SendKeepAlive();
+      if(m_State == State::Ready)
+        pumpBy(m_LastTX + PingInterval + 1);
+      for(auto& item : m_RXMsgs)
       {
-        if(ShouldPing())
-          SendKeepAlive();
-        for(auto& item : m_RXMsgs)
-        {
-          if(item.second.ShouldSendACKS(now))
-          {
-            item.second.SendACKS(util::memFn(&Session::EncryptAndSend, this),
-                                 now);
-          }
-        }
-        for(auto& item : m_TXMsgs)
+        if(item.second.ShouldSendACKS(now)
+           && not item.second.SendACKS(
+                  util::memFn(&Session::EncryptAndSend, this), now))
+          LogError("cannot send acks to ", m_RemoteAddr);
+        pumpBy(item.second.m_LastACKSent + ACKResendInterval + 1);
+      }
+      size_t lost = 0;
+      for(auto& item : m_TXMsgs)
+        lost += item.second.ExpireInFlight(now, m_CC.RTO());
+      if(lost)
+      {
+        LogDebug(lost, " fragments timed out to ", m_RemoteAddr);
+        m_CC.OnTimeout(lost);
+      }
+      FlushTX(now);
+      size_t inflight = 0;
+      bool unsent     = false;
+      for(const auto& item : m_TXMsgs)
+      {
+        inflight += item.second.InFlight();
+        pumpBy(item.second.NextExpiryAt(m_CC.RTO()));
+        size_t idx = 0;
+        unsent     = unsent || item.second.NextFragment(idx);
+      }
+      // held back by the pacer, a full window waits on acks or the rto
+      if(unsent && inflight < m_CC.Window())
+        pumpBy(m_CC.NextSendAt(now));
+    }
+
+    void
+    Session::FlushTX(llarp_time_t now)
+    {
+      size_t inflight = 0;
+      for(const auto& item : m_TXMsgs)
+        inflight += item.second.InFlight();
+      for(auto& item : m_TXMsgs)
+      {
+        auto& msg  = item.second;
+        size_t idx = 0;
+        while(msg.NextFragment(idx))
         {
-          if(item.second.ShouldFlush(now))
+          if(not m_CC.CanSend(inflight, now))
+            return;
+          const auto seqno = m_CC.OnSent(msg.WasSent(idx));
+          if(not msg.SendFragment(idx, seqno, now,
+                                  util::memFn(&Session::EncryptAndSend, this)))
           {
-            item.second.FlushUnAcked(
-                util::memFn(&Session::EncryptAndSend, this), now);
+            // it stays unsent and the message times out
+            LogError("cannot send fragment ", idx, " of message ", item.first,
+                     " to ", m_RemoteAddr);
+            break;
           }
+          ++inflight;
         }
       }
     }
@@ -229,7 +422,9 @@ namespace llarp
     Session::ExtractStatus() const
     {
       return {{"remoteAddr", m_RemoteAddr.ToString()},
-              {"remoteRC", m_RemoteRC.ExtractStatus()}};
+              {"remoteRC", m_RemoteRC.ExtractStatus()},
+              {"txMsgQueueSize", m_TXMsgs.size()},
+              {"congestion", m_CC.ExtractStatus()}};
     }
 
     bool
@@ -310,9 +505,12 @@ namespace llarp
       std::copy(N.begin(), N.end(), intro.begin() + PubKey::SIZE);
       LogDebug("pk=", pk.ToHex(), " N=", N.ToHex(),
                " remote-pk=", m_ChosenAI.pubkey.ToHex());
-      std::vector< byte_t > req;
-      std::copy_n(intro.begin(), intro.size(), std::back_inserter(req));
-      AddRandomPadding(req);
+      PacketBuffer req;
+      if(not(req.Append(intro.data(), intro.size()) && AddRandomPadding(req)))
+      {
+        LogError("cannot build intro to ", m_RemoteAddr);
+        return;
+      }
       const llarp_buffer_t buf(req);
       Send_LL(buf);
       m_State = State::Introduction;
@@ -322,7 +520,7 @@ namespace llarp
     void
     Session::HandleCreateSessionRequest(const llarp_buffer_t& buf)
     {
-      std::vector< byte_t > result;
+      PacketBuffer result;
       if(not DecryptMessage(buf, result))
       {
         LogError("failed to decrypt session request from ", m_RemoteAddr);
@@ -334,7 +532,7 @@ namespace llarp
                  token.size(), " from ", m_RemoteAddr);
         return;
       }
-      if(not std::equal(result.begin(), result.begin() + token.size(),
+      if(not std::equal(result.data(), result.data() + token.size(),
                         token.begin()))
       {
         LogError("token missmatch from ", m_RemoteAddr);
@@ -366,12 +564,17 @@ namespace llarp
                  m_RemoteAddr);
         return;
       }
-      std::vector< byte_t > reply;
-      std::copy_n(token.begin(), token.size(), std::back_inserter(reply));
-      AddRandomPadding(reply);
+      PacketBuffer reply;
+      if(not(reply.Append(token.data(), token.size())
+             && AddRandomPadding(reply)))
+      {
+        LogError("cannot build intro ack to ", m_RemoteAddr);
+        return;
+      }
       const llarp_buffer_t pkt(reply);
       m_LastRX = m_Parent->Now();
-      EncryptAndSend(pkt);
+      // handshake packets skip the crypto pipeline like the intro does
+      EncryptAndSendNow(pkt);
       LogDebug("sent intro ack to ", m_RemoteAddr);
       m_State = State::Introduction;
     }
@@ -379,7 +582,7 @@ namespace llarp
     void
     Session::HandleGotIntroAck(const llarp_buffer_t& buf)
     {
-      std::vector< byte_t > reply;
+      PacketBuffer reply;
       if(not DecryptMessage(buf, reply))
       {
         LogError("intro ack decrypt failed from ", m_RemoteAddr);
@@ -392,22 +595,26 @@ namespace llarp
         return;
       }
       m_LastRX = m_Parent->Now();
-      std::copy_n(reply.begin(), token.size(), token.begin());
+      std::copy_n(reply.data(), token.size(), token.begin());
       const llarp_buffer_t pkt(token);
-      EncryptAndSend(pkt);
+      EncryptAndSendNow(pkt);
       LogDebug("sent session request to ", m_RemoteAddr);
       m_State = State::LinkIntro;
     }
 
     bool
-    Session::DecryptMessage(const llarp_buffer_t& buf,
-                            std::vector< byte_t >& result)
+    Session::DecryptMessage(const llarp_buffer_t& buf, PacketBuffer& result)
     {
       if(buf.sz <= PacketOverhead)
       {
         LogError("packet too small ", buf.sz);
         return false;
       }
+      if(not result.Resize(buf.sz - PacketOverhead))
+      {
+        LogError("packet too big ", buf.sz, " from ", m_RemoteAddr);
+        return false;
+      }
       ShortHash H;
       llarp_buffer_t curbuf(buf.base, buf.sz);
       curbuf.base += ShortHash::SIZE;
@@ -427,7 +634,6 @@ namespace llarp
       const byte_t* nonce_ptr = curbuf.base;
       curbuf.base += 32;
       curbuf.sz -= 32;
-      result.resize(buf.sz - PacketOverhead);
       const llarp_buffer_t outbuf(result);
       LogDebug("decrypt: ", result.size(), " bytes from ", m_RemoteAddr);
       return CryptoManager::instance()->xchacha20_alt(outbuf, curbuf,
@@ -445,12 +651,29 @@ namespace llarp
     void
     Session::HandleSessionData(const llarp_buffer_t& buf)
     {
-      std::vector< byte_t > result;
+      if(m_Parent->CryptoWorker())
+      {
+        auto pkt = m_Parent->Packets().Get();
+        if(not pkt->Append(buf.base, buf.sz))
+        {
+          LogError("packet too big ", buf.sz, " from ", m_RemoteAddr);
+          return;
+        }
+        QueueCrypto(m_DecryptQueue, std::move(pkt), false);
+        return;
+      }
+      PacketBuffer result;
       if(not DecryptMessage(buf, result))
       {
         LogError("failed to decrypt session data from ", m_RemoteAddr);
         return;
       }
+      HandlePlaintext(result);
+    }
+
+    void
+    Session::HandlePlaintext(const PacketBuffer& result)
+    {
       if(result[0] != LLARP_PROTO_VERSION)
       {
         LogError("protocol version missmatch ", int(result[0]),
@@ -461,29 +684,29 @@ namespace llarp
       switch(result[1])
       {
         case Command::eXMIT:
-          HandleXMIT(std::move(result));
+          HandleXMIT(result);
           return;
         case Command::eDATA:
-          HandleDATA(std::move(result));
+          HandleDATA(result);
           return;
         case Command::eACKS:
-          HandleACKS(std::move(result));
+          HandleACKS(result);
           return;
         case Command::ePING:
-          HandlePING(std::move(result));
+          HandlePING(result);
           return;
         case Command::eNACK:
-          HandleNACK(std::move(result));
+          HandleNACK(result);
           return;
         case Command::eCLOS:
-          HandleCLOS(std::move(result));
+          HandleCLOS(result);
           return;
       }
       LogError("invalid command ", int(result[1]));
     }
 
     void
-    Session::HandleNACK(std::vector< byte_t > data)
+    Session::HandleNACK(const PacketBuffer& data)
     {
       if(data.size() < 10)
       {
@@ -495,16 +718,21 @@ namespace llarp
       auto itr = m_TXMsgs.find(txid);
       if(itr != m_TXMsgs.end())
       {
-        auto xmit = itr->second.XMIT();
-        AddRandomPadding(xmit);
-        const llarp_buffer_t pkt(xmit);
-        EncryptAndSend(pkt);
+        PacketBuffer xmit;
+        if(itr->second.XMIT(xmit) && AddRandomPadding(xmit))
+        {
+          const llarp_buffer_t pkt(xmit);
+          EncryptAndSend(pkt);
+        }
+        else
+          LogError("cannot build xmit for message ", txid, " to ",
+                   m_RemoteAddr);
       }
       m_LastRX = m_Parent->Now();
     }
 
     void
-    Session::HandleXMIT(std::vector< byte_t > data)
+    Session::HandleXMIT(const PacketBuffer& data)
     {
       if(data.size() < 44)
       {
@@ -536,9 +764,9 @@ namespace llarp
     }
 
     void
-    Session::HandleDATA(std::vector< byte_t > data)
+    Session::HandleDATA(const PacketBuffer& data)
     {
-      if(data.size() <= 12)
+      if(data.size() <= FragmentHeaderSize)
       {
         LogError("short DATA from ", m_RemoteAddr, " ", data.size());
         return;
@@ -550,24 +778,30 @@ namespace llarp
       if(itr == m_RXMsgs.end())
       {
         LogDebug("no rxid=", rxid, " for ", m_RemoteAddr);
-        std::vector< byte_t > nack = {
+        PacketBuffer nack{
             LLARP_PROTO_VERSION, Command::eNACK, 0, 0, 0, 0, 0, 0, 0, 0};
         htobe64buf(nack.data() + 2, rxid);
-        AddRandomPadding(nack);
+        if(not AddRandomPadding(nack))
+        {
+          LogError("cannot pad nack to ", m_RemoteAddr);
+          return;
+        }
         const llarp_buffer_t nackbuf(nack);
         EncryptAndSend(nackbuf);
         return;
       }
 
       {
-        const llarp_buffer_t buf(data.data() + 12, data.size() - 12);
+        const llarp_buffer_t buf(data.data() + FragmentHeaderSize,
+                                 data.size() - FragmentHeaderSize);
         itr->second.HandleData(sz, buf, m_Parent->Now());
       }
 
       if(itr->second.IsCompleted())
       {
-        itr->second.SendACKS(util::memFn(&Session::EncryptAndSend, this),
-                             m_Parent->Now());
+        if(not itr->second.SendACKS(
+               util::memFn(&Session::EncryptAndSend, this), m_Parent->Now()))
+          LogError("cannot send acks to ", m_RemoteAddr);
         if(itr->second.Verify())
         {
           auto msg = std::move(itr->second);
@@ -584,7 +818,7 @@ namespace llarp
     }
 
     void
-    Session::HandleACKS(std::vector< byte_t > data)
+    Session::HandleACKS(const PacketBuffer& data)
     {
       if(data.size() < 11)
       {
@@ -600,28 +834,41 @@ namespace llarp
         LogDebug("no txid=", txid, " for ", m_RemoteAddr);
         return;
       }
-      itr->second.Ack(data[10]);
-
-      if(itr->second.IsTransmitted())
+      auto& msg       = itr->second;
+      const auto info = msg.Ack(data[10]);
+      if(info.acked)
       {
-        LogDebug("sent message ", itr->first);
-        itr->second.Completed();
-        itr = m_TXMsgs.erase(itr);
+        m_CC.OnAcked(info.acked);
+        // the ack for the last fragment goes out as soon as the message is
+        // complete, so that is the only one we can time
+        if(msg.IsTransmitted() && info.sampleSentAt)
+          m_CC.OnRTTSample(now - info.sampleSentAt);
+        // selective ack, fragments of this message sent well before what
+        // just got acked are gone so retransmit them now instead of waiting
+        // on the timer
+        uint64_t oldest = 0;
+        const auto lost = msg.DetectLoss(
+            info.highestSeqno, CongestionControl::ReorderThreshold, oldest);
+        if(lost)
+          m_CC.OnFastRetransmit(oldest, lost);
       }
-      else
+
+      if(msg.IsTransmitted())
       {
-        itr->second.FlushUnAcked(util::memFn(&Session::EncryptAndSend, this),
-                                 now);
+        LogDebug("sent message ", itr->first);
+        msg.Completed();
+        m_TXMsgs.erase(itr);
       }
+      FlushTX(now);
     }
 
-    void Session::HandleCLOS(std::vector< byte_t >)
+    void Session::HandleCLOS(const PacketBuffer&)
     {
       LogInfo("remote closed by ", m_RemoteAddr);
       Close();
     }
 
-    void Session::HandlePING(std::vector< byte_t >)
+    void Session::HandlePING(const PacketBuffer&)
     {
       m_LastRX = m_Parent->Now();
     }
@@ -631,7 +878,7 @@ namespace llarp
     {
       if(m_State == State::Ready)
       {
-        std::vector< byte_t > ping{LLARP_PROTO_VERSION, Command::ePING};
+        PacketBuffer ping{LLARP_PROTO_VERSION, Command::ePING};
         const llarp_buffer_t buf(ping);
         EncryptAndSend(buf);
         return true;
@@ -2,17 +2,16 @@
 #define LLARP_IWP_SESSION_HPP
 
 #include <link/session.hpp>
+#include <iwp/congestion.hpp>
 #include <iwp/linklayer.hpp>
 #include <iwp/message_buffer.hpp>
 
+#include <map>
+
 namespace llarp
 {
   namespace iwp
   {
-    void
-    AddRandomPadding(std::vector< byte_t >& pkt, size_t min = 16,
-                     size_t variance = 16);
-
     struct Session : public ILinkSession,
                      public std::enable_shared_from_this< Session >
     {
@@ -23,15 +22,15 @@ namespace llarp
       /// Time how long we wait to recieve a message
       static constexpr llarp_time_t RecievalTimeout = (DeliveryTimeout * 8) / 5;
       /// How often to acks RX messages
-      static constexpr llarp_time_t ACKResendInterval = 500;
-      /// How often to retransmit TX fragments
-      static constexpr llarp_time_t TXFlushInterval =
-          (ACKResendInterval * 3) / 2;
+      static constexpr llarp_time_t ACKResendInterval =
+          CongestionControl::MaxAckDelay;
       /// How often we send a keepalive
       static constexpr llarp_time_t PingInterval = 2000;
       /// How long we wait for a session to die with no tx from them
       static constexpr llarp_time_t SessionAliveTimeout =
           (PingInterval * 13) / 3;
+      /// How many packets we hand to the crypto worker at once
+      static constexpr size_t CryptoBatchSize = 32;
 
       /// outbound session
       Session(LinkLayer* parent, RouterContact rc, AddressInfo ai);
@@ -49,6 +48,12 @@ namespace llarp
       void
       Pump() override;
 
+      llarp_time_t
+      NextPumpAt() const override
+      {
+        return m_NextPumpAt;
+      }
+
       void
       Tick(llarp_time_t now) override;
 
@@ -62,6 +67,10 @@ namespace llarp
       void
       EncryptAndSend(const llarp_buffer_t& data);
 
+      /// encrypt and send inline even if we have a crypto worker
+      void
+      EncryptAndSendNow(const llarp_buffer_t& data);
+
       void
       Start() override;
 
@@ -153,15 +162,65 @@ namespace llarp
 
       llarp_time_t m_LastTX = 0;
       llarp_time_t m_LastRX = 0;
+      /// soonest ack, retransmit, ping or timeout the last Pump saw
+      llarp_time_t m_NextPumpAt = 0;
 
       uint64_t m_TXID = 0;
 
       std::unordered_map< uint64_t, InboundMessage > m_RXMsgs;
-      std::unordered_map< uint64_t, OutboundMessage > m_TXMsgs;
+      /// ordered by msgid so older messages get the window first
+      std::map< uint64_t, OutboundMessage > m_TXMsgs;
+      CongestionControl m_CC;
 
       /// maps rxid to time recieved
       std::unordered_map< uint64_t, llarp_time_t > m_ReplayFilter;
 
+      using Packet_ptr  = PacketPool::Packet_ptr;
+      using CryptoBatch = std::vector< Packet_ptr >;
+
+      /// one direction of the crypto pipeline, the worker may finish batches
+      /// in any order but we deliver them in the order we handed them out
+      struct CryptoQueue
+      {
+        /// packets not yet handed to the worker
+        CryptoBatch pending;
+        /// sequence number of the next batch handed to the worker
+        uint64_t dispatchSeqno = 0;
+        /// sequence number of the next batch we deliver
+        uint64_t deliverSeqno = 0;
+        /// batches the worker finished ahead of an earlier one
+        std::map< uint64_t, CryptoBatch > done;
+      };
+
+      CryptoQueue m_EncryptQueue;
+      CryptoQueue m_DecryptQueue;
+      /// true if a FlushCrypto is queued on the logic thread
+      bool m_CryptoFlushQueued = false;
+
+      /// encrypt the plaintext after PacketOverhead in place and key it
+      static bool
+      EncryptInPlace(PacketBuffer& pkt, const SharedSecret& key);
+
+      /// verify and decrypt in place, leaves the plaintext at the front
+      static bool
+      DecryptInPlace(PacketBuffer& pkt, const SharedSecret& key);
+
+      void
+      QueueCrypto(CryptoQueue& q, Packet_ptr pkt, bool encrypt);
+
+      void
+      DispatchCrypto(CryptoQueue& q, bool encrypt);
+
+      /// hand every pending packet to the crypto worker
+      void
+      FlushCrypto();
+
+      void
+      DeliverCrypto(uint64_t seqno, CryptoBatch batch, bool encrypted);
+
+      void
+      HandlePlaintext(const PacketBuffer& msg);
+
       void
       HandleGotIntro(const llarp_buffer_t& buf);
 
@@ -178,7 +237,7 @@ namespace llarp
       HandleSessionData(const llarp_buffer_t& buf);
 
       bool
-      DecryptMessage(const llarp_buffer_t& buf, std::vector< byte_t >& result);
+      DecryptMessage(const llarp_buffer_t& buf, PacketBuffer& result);
 
       void
       GenerateAndSendIntro();
@@ -195,23 +254,27 @@ namespace llarp
       void
       SendOurLIM(ILinkSession::CompletionHandler h = nullptr);
 
+      /// send as many fragments as the congestion window and pacer allow
+      void
+      FlushTX(llarp_time_t now);
+
       void
-      HandleXMIT(std::vector< byte_t > msg);
+      HandleXMIT(const PacketBuffer& msg);
 
       void
-      HandleDATA(std::vector< byte_t > msg);
+      HandleDATA(const PacketBuffer& msg);
 
       void
-      HandleACKS(std::vector< byte_t > msg);
+      HandleACKS(const PacketBuffer& msg);
 
       void
-      HandleNACK(std::vector< byte_t > msg);
+      HandleNACK(const PacketBuffer& msg);
 
       void
-      HandlePING(std::vector< byte_t > msg);
+      HandlePING(const PacketBuffer& msg);
 
       void
-      HandleCLOS(std::vector< byte_t > msg);
+      HandleCLOS(const PacketBuffer& msg);
     };
   }  // namespace iwp
 }  // namespace llarp
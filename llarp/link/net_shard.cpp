@@ -0,0 +1,175 @@
+#include <link/net_shard.hpp>
+
+#include <ev/ev.hpp>
+#include <util/logging/logger.hpp>
+
+namespace llarp
+{
+  constexpr size_t NetShard::MaxInbox;
+
+  NetShard::NetShard(Notify_t gotPackets)
+      : m_GotPackets(std::move(gotPackets)), m_Run(false), m_Dropped(0)
+  {
+    m_UDP.user      = this;
+    m_UDP.recvfrom  = &NetShard::OnRecv;
+    m_UDP.recvbatch = &NetShard::OnRecvBatch;
+    m_UDP.tick      = &NetShard::OnTick;
+    m_UDP.reuseport = true;
+  }
+
+  NetShard::~NetShard()
+  {
+    if(m_Started)
+      Stop();
+    else if(m_Loop)
+    {
+      // bound but never started, close our socket from here
+      m_Loop->stop();
+      m_Loop->stopped();
+    }
+  }
+
+  bool
+  NetShard::Bind(const Addr& addr)
+  {
+    m_Loop = llarp_make_ev_loop();
+    return llarp_ev_add_udp(m_Loop.get(), &m_UDP, addr) != -1;
+  }
+
+  bool
+  NetShard::Start(const std::string& name)
+  {
+    if(m_Loop == nullptr || m_Started)
+      return false;
+    m_Started = true;
+    m_Run.store(true);
+    m_Thread = std::thread([this, name]() {
+      util::SetThreadName(name);
+      while(m_Run.load())
+      {
+        m_Loop->update_time();
+        m_Loop->tick(EV_TICK_INTERVAL);
+      }
+      m_Loop->stop();
+      m_Loop->stopped();
+    });
+    return true;
+  }
+
+  void
+  NetShard::Stop()
+  {
+    if(not m_Thread.joinable())
+      return;
+    m_Run.store(false);
+    m_Loop->wakeup();
+    m_Thread.join();
+  }
+
+  void
+  NetShard::TakeReceived(PacketBatch& batch)
+  {
+    batch.clear();
+    util::Lock lock(&m_Access);
+    std::swap(batch, m_Inbox);
+  }
+
+  void
+  NetShard::QueueSend(const Addr& to, const llarp_buffer_t& pkt)
+  {
+    m_Queued.Push(to, pkt.base, pkt.sz);
+  }
+
+  void
+  NetShard::Flush()
+  {
+    if(m_Queued.empty())
+      return;
+    {
+      util::Lock lock(&m_Access);
+      if(m_Outbox.empty())
+        std::swap(m_Outbox, m_Queued);
+      else
+      {
+        m_Queued.ForEach([&](const Addr& to, const byte_t* ptr, size_t sz) {
+          m_Outbox.Push(to, ptr, sz);
+        });
+      }
+    }
+    m_Queued.clear();
+    m_Loop->wakeup();
+  }
+
+  void
+  NetShard::OnRecvBatch(llarp_udp_io* udp, const llarp_udp_pkt* pkts,
+                        size_t num)
+  {
+    auto* self = static_cast< NetShard* >(udp->user);
+    bool wasEmpty;
+    {
+      util::Lock lock(&self->m_Access);
+      wasEmpty = self->m_Inbox.empty();
+      for(size_t idx = 0; idx < num; ++idx)
+        self->PushInbox(Addr(*pkts[idx].from), pkts[idx].data, pkts[idx].sz);
+    }
+    if(wasEmpty)
+      self->m_GotPackets();
+  }
+
+  void
+  NetShard::OnRecv(llarp_udp_io* udp, const sockaddr* from, ManagedBuffer buf)
+  {
+    static_cast< NetShard* >(udp->user)->Received(from, buf.underlying.base,
+                                                  buf.underlying.sz);
+  }
+
+  void
+  NetShard::Received(const sockaddr* from, const byte_t* ptr, size_t sz)
+  {
+    bool wasEmpty;
+    {
+      util::Lock lock(&m_Access);
+      wasEmpty = m_Inbox.empty();
+      PushInbox(Addr(*from), ptr, sz);
+    }
+    if(wasEmpty)
+      m_GotPackets();
+  }
+
+  void
+  NetShard::PushInbox(const Addr& from, const byte_t* ptr, size_t sz)
+  {
+    if(m_Inbox.size() < MaxInbox)
+      m_Inbox.Push(from, ptr, sz);
+    else
+      ++m_Dropped;
+  }
+
+  util::StatusObject
+  NetShard::ExtractStatus() const
+  {
+    return util::StatusObject{{"dropped", Dropped()}};
+  }
+
+  void
+  NetShard::OnTick(llarp_udp_io* udp)
+  {
+    static_cast< NetShard* >(udp->user)->SendQueued();
+  }
+
+  void
+  NetShard::SendQueued()
+  {
+    m_Sending.clear();
+    {
+      util::Lock lock(&m_Access);
+      std::swap(m_Sending, m_Outbox);
+    }
+    if(m_Sending.empty())
+      return;
+    m_Sending.ForEach([&](const Addr& to, const byte_t* ptr, size_t sz) {
+      llarp_ev_udp_queue_sendto(&m_UDP, to, llarp_buffer_t(ptr, sz));
+    });
+    llarp_ev_udp_flush(&m_UDP);
+  }
+}  // namespace llarp
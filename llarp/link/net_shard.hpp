@@ -0,0 +1,169 @@
+#ifndef LLARP_LINK_NET_SHARD_HPP
+#define LLARP_LINK_NET_SHARD_HPP
+
+#include <ev/ev.h>
+#include <net/net_addr.hpp>
+#include <util/buffer.hpp>
+#include <util/status.hpp>
+#include <util/thread/threading.hpp>
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace llarp
+{
+  /// datagrams packed into one buffer so handing a batch between threads is
+  /// a swap
+  struct PacketBatch
+  {
+    struct Entry
+    {
+      Addr addr;
+      size_t offset;
+      size_t sz;
+    };
+
+    std::vector< byte_t > data;
+    std::vector< Entry > pkts;
+
+    void
+    Push(const Addr& addr, const byte_t* ptr, size_t sz)
+    {
+      pkts.emplace_back(Entry{addr, data.size(), sz});
+      data.insert(data.end(), ptr, ptr + sz);
+    }
+
+    /// call visit(addr, ptr, sz) on every datagram in order
+    template < typename Visit_t >
+    void
+    ForEach(Visit_t visit) const
+    {
+      for(const auto& pkt : pkts)
+        visit(pkt.addr, data.data() + pkt.offset, pkt.sz);
+    }
+
+    bool
+    empty() const
+    {
+      return pkts.empty();
+    }
+
+    size_t
+    size() const
+    {
+      return pkts.size();
+    }
+
+    void
+    clear()
+    {
+      data.clear();
+      pkts.clear();
+    }
+  };
+
+  /// an event loop on its own thread with its own SO_REUSEPORT udp socket
+  /// bound to the same address as a link. the kernel hashes each remote to
+  /// one socket of the group so a shard reads its own share of peers.
+  ///
+  /// datagrams go between the shard and the link thread as batches through
+  /// an inbox and an outbox, the link thread only takes the lock once per
+  /// pump in each direction. a shard only does the socket io, sessions are
+  /// still handled on the link thread and their crypto on the crypto worker.
+  struct NetShard
+  {
+    /// most datagrams the inbox holds, we drop what comes in after that
+    /// until the link thread catches up
+    static constexpr size_t MaxInbox = 8192;
+
+    /// called on the shard thread when the inbox goes from empty to not
+    using Notify_t = std::function< void(void) >;
+
+    explicit NetShard(Notify_t gotPackets);
+
+    ~NetShard();
+
+    NetShard(const NetShard&) = delete;
+
+    NetShard&
+    operator=(const NetShard&) = delete;
+
+    /// bind our socket, call before Start
+    bool
+    Bind(const Addr& addr);
+
+    bool
+    Start(const std::string& name);
+
+    /// stop the loop and wait for the thread
+    void
+    Stop();
+
+    /// swap out everything read since the last call, link thread only
+    void
+    TakeReceived(PacketBatch& batch) LOCKS_EXCLUDED(m_Access);
+
+    /// queue a datagram to send from our socket once Flush is called, link
+    /// thread only
+    void
+    QueueSend(const Addr& to, const llarp_buffer_t& pkt);
+
+    /// hand what was queued to the shard thread, link thread only
+    void
+    Flush() LOCKS_EXCLUDED(m_Access);
+
+    /// datagrams dropped because the inbox was full
+    uint64_t
+    Dropped() const
+    {
+      return m_Dropped.load();
+    }
+
+    util::StatusObject
+    ExtractStatus() const;
+
+   private:
+    static void
+    OnRecvBatch(llarp_udp_io* udp, const llarp_udp_pkt* pkts, size_t num);
+
+    static void
+    OnRecv(llarp_udp_io* udp, const sockaddr* from, ManagedBuffer buf);
+
+    static void
+    OnTick(llarp_udp_io* udp);
+
+    void
+    Received(const sockaddr* from, const byte_t* ptr, size_t sz);
+
+    /// put a datagram in the inbox unless it is full
+    void
+    PushInbox(const Addr& from, const byte_t* ptr, size_t sz)
+        EXCLUSIVE_LOCKS_REQUIRED(m_Access);
+
+    /// send what the link flushed, shard thread only
+    void
+    SendQueued() LOCKS_EXCLUDED(m_Access);
+
+    const Notify_t m_GotPackets;
+    llarp_ev_loop_ptr m_Loop;
+    llarp_udp_io m_UDP;
+    std::thread m_Thread;
+    bool m_Started = false;
+    std::atomic< bool > m_Run;
+    std::atomic< uint64_t > m_Dropped;
+
+    /// filled by the link thread between flushes
+    PacketBatch m_Queued;
+    /// drained by the shard thread
+    PacketBatch m_Sending;
+
+    util::Mutex m_Access;  // protects m_Inbox, m_Outbox
+    PacketBatch m_Inbox GUARDED_BY(m_Access);
+    PacketBatch m_Outbox GUARDED_BY(m_Access);
+  };
+}  // namespace llarp
+
+#endif
@@ -1,7 +1,10 @@
 #include <link/server.hpp>
 
 #include <crypto/crypto.hpp>
+#include <ev/ev.hpp>
 #include <util/fs.hpp>
+
+#include <algorithm>
 #include <utility>
 
 namespace llarp
@@ -24,7 +27,12 @@ namespace llarp
   {
   }
 
-  ILinkLayer::~ILinkLayer() = default;
+  ILinkLayer::~ILinkLayer()
+  {
+    // they call back into us from their own threads
+    for(auto& shard : m_NetShards)
+      shard->Stop();
+  }
 
   bool
   ILinkLayer::HasSessionTo(const RouterID& id)
@@ -105,10 +113,11 @@ namespace llarp
   ILinkLayer::Configure(llarp_ev_loop_ptr loop, const std::string& ifname,
                         int af, uint16_t port)
   {
-    m_Loop         = loop;
-    m_udp.user     = this;
-    m_udp.recvfrom = &ILinkLayer::udp_recv_from;
-    m_udp.tick     = &ILinkLayer::udp_tick;
+    m_Loop          = loop;
+    m_udp.user      = this;
+    m_udp.recvfrom  = &ILinkLayer::udp_recv_from;
+    m_udp.tick      = &ILinkLayer::udp_tick;
+    m_udp.recvbatch = &ILinkLayer::udp_recv_batch;
     if(ifname == "*")
     {
       if(!AllInterfaces(af, m_ourAddr))
@@ -117,56 +126,176 @@ namespace llarp
     else if(!GetIFAddr(ifname, m_ourAddr, af))
       m_ourAddr = Addr(ifname);
     m_ourAddr.port(port);
-    return llarp_ev_add_udp(m_Loop.get(), &m_udp, m_ourAddr) != -1;
+#ifdef __linux__
+    // an ephemeral port can't be shared
+    m_udp.reuseport = m_NetThreads > 1 && port != 0;
+#else
+    // only linux spreads datagrams across sockets sharing a port
+    m_udp.reuseport = false;
+#endif
+    if(llarp_ev_add_udp(m_Loop.get(), &m_udp, m_ourAddr) == -1)
+      return false;
+    if(not m_udp.reuseport)
+      return true;
+    for(size_t idx = 1; idx < m_NetThreads; ++idx)
+    {
+      auto shard =
+          std::make_unique< NetShard >([this]() { m_Loop->wakeup(); });
+      if(!shard->Bind(m_ourAddr))
+      {
+        LogWarn("cannot share ", m_ourAddr, " across net threads, using one");
+        m_NetShards.clear();
+        break;
+      }
+      m_NetShards.emplace_back(std::move(shard));
+    }
+    return true;
+  }
+
+  void
+  ILinkLayer::SendTo_LL(const llarp::Addr& to, const llarp_buffer_t& pkt)
+  {
+    NetShard* shard = NetShardFor(to);
+    if(shard)
+      shard->QueueSend(to, pkt);
+    else
+      llarp_ev_udp_queue_sendto(&m_udp, to, pkt);
+  }
+
+  NetShard*
+  ILinkLayer::NetShardFor(const Addr& remote) const
+  {
+    if(m_NetShards.empty())
+      return nullptr;
+    // always the same socket for a remote so its packets stay in order
+    const uint64_t h = Addr::Hash{}(remote) * 0x9E3779B97F4A7C15ULL;
+    const size_t idx = (h >> 32) % (m_NetShards.size() + 1);
+    return idx ? m_NetShards[idx - 1].get() : nullptr;
+  }
+
+  void
+  ILinkLayer::PumpNetShards()
+  {
+    for(auto& shard : m_NetShards)
+    {
+      shard->TakeReceived(m_NetShardRX);
+      m_NetShardRX.ForEach([&](const Addr& from, const byte_t* ptr,
+                               size_t sz) { RecvFrom(from, ptr, sz); });
+    }
   }
 
   void
   ILinkLayer::Pump()
   {
-    auto _now = Now();
+    PumpNetShards();
+    const auto _now = Now();
+    while(not m_PumpTimers.empty() && m_PumpTimers.begin()->first <= _now)
+    {
+      ILinkSession* s = m_PumpTimers.begin()->second;
+      m_PumpTimers.erase(m_PumpTimers.begin());
+      m_PumpAt[s] = 0;
+      m_Woken.insert(s);
+    }
+    m_Pumping.assign(m_Woken.begin(), m_Woken.end());
+    m_Woken.clear();
+    for(ILinkSession* s : m_Pumping)
+    {
+      // removed while we pumped another
+      if(m_PumpAt.count(s) == 0)
+        continue;
+      if(s->TimedOut(_now))
+      {
+        RemoveTimedOut(s);
+        continue;
+      }
+      s->Pump();
+      SchedulePump(s, s->NextPumpAt());
+    }
+    m_Pumping.clear();
+    llarp_ev_udp_flush(&m_udp);
+    for(auto& shard : m_NetShards)
+      shard->Flush();
+  }
+
+  void
+  ILinkLayer::WakeSession(ILinkSession* s)
+  {
+    // a session that is gone may still be finishing crypto jobs
+    if(m_PumpAt.count(s))
+      m_Woken.insert(s);
+  }
+
+  void
+  ILinkLayer::SchedulePump(ILinkSession* s, llarp_time_t at)
+  {
+    auto itr = m_PumpAt.find(s);
+    if(itr == m_PumpAt.end())
+      itr = m_PumpAt.emplace(s, 0).first;
+    else if(itr->second)
+      m_PumpTimers.erase({itr->second, s});
+    itr->second = at;
+    if(at)
+      m_PumpTimers.emplace(at, s);
+    else
+      m_Woken.insert(s);
+  }
+
+  void
+  ILinkLayer::ForgetSession(ILinkSession* s)
+  {
+    auto itr = m_PumpAt.find(s);
+    if(itr == m_PumpAt.end())
+      return;
+    if(itr->second)
+      m_PumpTimers.erase({itr->second, s});
+    m_PumpAt.erase(itr);
+    m_Woken.erase(s);
+  }
+
+  void
+  ILinkLayer::RemoveTimedOut(ILinkSession* s)
+  {
+    ForgetSession(s);
+    const RouterID pk = s->GetPubKey();
+    std::shared_ptr< ILinkSession > authed;
     {
       Lock lock(&m_AuthedLinksMutex);
-      auto itr = m_AuthedLinks.begin();
-      while(itr != m_AuthedLinks.end())
+      auto range = m_AuthedLinks.equal_range(pk);
+      auto itr   = std::find_if(range.first, range.second, [s](const auto& i) {
+        return i.second.get() == s;
+      });
+      if(itr != range.second)
       {
-        if(not itr->second->TimedOut(_now))
-        {
-          itr->second->Pump();
-          ++itr;
-        }
-        else
-        {
-          llarp::LogInfo("session to ", RouterID(itr->second->GetPubKey()),
-                         " timed out");
-          itr->second->Close();
-          itr = m_AuthedLinks.erase(itr);
-        }
+        authed = itr->second;
+        m_AuthedLinks.erase(itr);
       }
     }
+    if(authed)
     {
-      Lock lock(&m_PendingMutex);
-
-      auto itr = m_Pending.begin();
-      while(itr != m_Pending.end())
+      llarp::LogInfo("session to ", pk, " timed out");
+      authed->Close();
+      if(not HasSessionTo(pk))
       {
-        if(not itr->second->TimedOut(_now))
-        {
-          itr->second->Pump();
-          ++itr;
-        }
-        else
-        {
-          LogInfo("pending session at ", itr->first, " timed out");
-          // defer call so we can acquire mutexes later
-          auto self = itr->second->BorrowSelf();
-          m_Logic->queue_func([&, self]() {
-            this->HandleTimeout(self.get());
-            self->Close();
-          });
-          itr = m_Pending.erase(itr);
-        }
+        // all sessions were removed
+        SessionClosed(pk);
       }
+      return;
     }
+    Lock lock(&m_PendingMutex);
+    auto range = m_Pending.equal_range(s->GetRemoteEndpoint());
+    auto itr   = std::find_if(range.first, range.second, [s](const auto& i) {
+      return i.second.get() == s;
+    });
+    if(itr == range.second)
+      return;
+    LogInfo("pending session at ", itr->first, " timed out");
+    // defer call so we can acquire mutexes later
+    auto self = itr->second;
+    m_Logic->queue_func([&, self]() {
+      this->HandleTimeout(self.get());
+      self->Close();
+    });
+    m_Pending.erase(itr);
   }
 
   bool
@@ -229,9 +358,14 @@ namespace llarp
                      });
     }
 
+    std::vector< util::StatusObject > shards;
+    for(const auto& shard : m_NetShards)
+      shards.emplace_back(shard->ExtractStatus());
+
     return {{"name", Name()},
             {"rank", uint64_t(Rank())},
             {"addr", m_ourAddr.ToString()},
+            {"netShards", shards},
             {"sessions",
              util::StatusObject{{"pending", pending},
                                 {"established", established}}}};
@@ -267,6 +401,12 @@ namespace llarp
   ILinkLayer::Start(std::shared_ptr< Logic > l)
   {
     m_Logic = l;
+    for(size_t idx = 0; idx < m_NetShards.size(); ++idx)
+    {
+      if(!m_NetShards[idx]->Start(std::string(Name()) + "-net-"
+                                  + std::to_string(idx + 1)))
+        return false;
+    }
     ScheduleTick(100);
     return true;
   }
@@ -300,6 +440,8 @@ namespace llarp
   {
     if(m_Logic && tick_id)
       m_Logic->remove_call(tick_id);
+    for(auto& shard : m_NetShards)
+      shard->Stop();
     {
       Lock l(&m_AuthedLinksMutex);
       auto itr = m_AuthedLinks.begin();
@@ -323,16 +465,22 @@ namespace llarp
   void
   ILinkLayer::CloseSessionTo(const RouterID& remote)
   {
-    Lock l(&m_AuthedLinksMutex);
     RouterID r = remote;
     llarp::LogInfo("Closing all to ", r);
-    auto range = m_AuthedLinks.equal_range(r);
-    auto itr   = range.first;
-    while(itr != range.second)
     {
-      itr->second->Close();
-      itr = m_AuthedLinks.erase(itr);
+      Lock l(&m_AuthedLinksMutex);
+      auto range = m_AuthedLinks.equal_range(r);
+      if(range.first == range.second)
+        return;
+      auto itr = range.first;
+      while(itr != range.second)
+      {
+        ForgetSession(itr->second.get());
+        itr->second->Close();
+        itr = m_AuthedLinks.erase(itr);
+      }
     }
+    SessionClosed(r);
   }
 
   void
@@ -436,6 +584,7 @@ namespace llarp
     if(m_Pending.count(addr) >= MaxSessionsPerEndpoint)
       return false;
     m_Pending.emplace(addr, s);
+    SchedulePump(s.get(), 0);
     return true;
   }
 
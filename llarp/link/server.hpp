@@ -3,16 +3,20 @@
 
 #include <crypto/types.hpp>
 #include <ev/ev.h>
+#include <link/net_shard.hpp>
 #include <link/session.hpp>
 #include <net/net.hpp>
 #include <router_contact.hpp>
 #include <util/status.hpp>
 #include <util/thread/logic.hpp>
+#include <util/thread/thread_pool.hpp>
 #include <util/thread/threading.hpp>
 
 #include <list>
 #include <memory>
+#include <set>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace llarp
 {
@@ -97,12 +101,22 @@ namespace llarp
           srcaddr, buf.underlying.base, buf.underlying.sz);
     }
 
-    void
-    SendTo_LL(const llarp::Addr& to, const llarp_buffer_t& pkt)
+    static void
+    udp_recv_batch(llarp_udp_io* udp, const llarp_udp_pkt* pkts, size_t num)
     {
-      llarp_ev_udp_sendto(&m_udp, to, pkt);
+      auto* self = static_cast< ILinkLayer* >(udp->user);
+      for(size_t idx = 0; idx < num; ++idx)
+      {
+        const llarp::Addr srcaddr(*pkts[idx].from);
+        self->RecvFrom(srcaddr, pkts[idx].data, pkts[idx].sz);
+      }
     }
 
+    /// queue a packet to send, queued packets are flushed at the end of
+    /// Pump() or before the event loop next blocks, whichever comes first
+    void
+    SendTo_LL(const llarp::Addr& to, const llarp_buffer_t& pkt);
+
     virtual bool
     Configure(llarp_ev_loop_ptr loop, const std::string& ifname, int af,
               uint16_t port);
@@ -110,9 +124,16 @@ namespace llarp
     virtual std::shared_ptr< ILinkSession >
     NewOutboundSession(const RouterContact& rc, const AddressInfo& ai) = 0;
 
-    virtual void
+    /// pump the sessions that were woken up or whose next pump time came,
+    /// everything else is left alone
+    void
     Pump();
 
+    /// have the next Pump visit s, sessions call this when they got data or
+    /// queued something to send
+    void
+    WakeSession(ILinkSession* s);
+
     virtual void
     RecvFrom(const Addr& from, const void* buf, size_t sz) = 0;
 
@@ -206,6 +227,35 @@ namespace llarp
       return m_Logic;
     }
 
+    llarp_ev_loop_ptr
+    evloop()
+    {
+      return m_Loop;
+    }
+
+    /// do per packet crypto on this worker instead of inline
+    /// nullptr turns the crypto pipeline off
+    void
+    SetCryptoWorker(std::shared_ptr< thread::ThreadPool > worker)
+    {
+      m_CryptoWorker = std::move(worker);
+    }
+
+    const std::shared_ptr< thread::ThreadPool >&
+    CryptoWorker() const
+    {
+      return m_CryptoWorker;
+    }
+
+    /// read and write datagrams on this many threads, each with its own
+    /// socket sharing our port, set before Configure. only the socket io is
+    /// spread out, sessions stay on our thread. linux only.
+    void
+    SetNetThreads(size_t num)
+    {
+      m_NetThreads = num;
+    }
+
     bool
     operator<(const ILinkLayer& other) const
     {
@@ -233,8 +283,40 @@ namespace llarp
     void
     ScheduleTick(uint64_t interval);
 
+    /// hand what the net shards read to RecvFrom
+    void
+    PumpNetShards();
+
+    /// the net shard that sends to remote, nullptr for our own socket
+    NetShard*
+    NetShardFor(const Addr& remote) const;
+
     uint32_t tick_id;
     const SecretKey& m_RouterEncSecret;
+    size_t m_NetThreads = 1;
+    /// extra sockets on our port each read and written on its own thread
+    std::vector< std::unique_ptr< NetShard > > m_NetShards;
+    /// reused to take batches out of the net shards
+    PacketBatch m_NetShardRX;
+
+    /// take s out of the pump schedule once it left our session maps
+    void
+    ForgetSession(ILinkSession* s);
+
+    /// s timed out in Pump, drop it and tell whoever needs to know
+    void
+    RemoveTimedOut(ILinkSession* s);
+
+    // the pump schedule is only touched on the event loop thread, a session
+    // is in it as long as it is in m_AuthedLinks or m_Pending
+    /// when each session wants its next pump
+    std::unordered_map< ILinkSession*, llarp_time_t > m_PumpAt;
+    /// m_PumpAt ordered by time, 0 is kept out of here
+    std::set< std::pair< llarp_time_t, ILinkSession* > > m_PumpTimers;
+    /// sessions for the next Pump regardless of time
+    std::unordered_set< ILinkSession* > m_Woken;
+    /// reused to hold the sessions one Pump visits
+    std::vector< ILinkSession* > m_Pumping;
 
    protected:
     using Lock  = util::NullLock;
@@ -243,7 +325,13 @@ namespace llarp
     bool
     PutSession(const std::shared_ptr< ILinkSession >& s);
 
+    /// pump s at or after time at, 0 for the next Pump, registers s with
+    /// the schedule if it is new
+    void
+    SchedulePump(ILinkSession* s, llarp_time_t at);
+
     std::shared_ptr< llarp::Logic > m_Logic = nullptr;
+    std::shared_ptr< thread::ThreadPool > m_CryptoWorker = nullptr;
     llarp_ev_loop_ptr m_Loop;
     Addr m_ourAddr;
     llarp_udp_io m_udp;
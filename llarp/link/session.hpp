@@ -34,10 +34,19 @@ namespace llarp
     virtual void
     OnLinkEstablished(ILinkLayer *){};
 
-    /// called every event loop tick
+    /// called from the event loop when we were woken up or our next pump
+    /// time came
     virtual void
     Pump() = 0;
 
+    /// when the last Pump wants to be called again to send acks,
+    /// retransmit, ping or time out, 0 for every event loop tick
+    virtual llarp_time_t
+    NextPumpAt() const
+    {
+      return 0;
+    }
+
     /// called every timer tick
     virtual void Tick(llarp_time_t) = 0;
 
@@ -100,8 +100,7 @@ namespace llarp
 
       if(!isLIM)
       {
-        metrics::integerTick(msg->Name(), "RX", 1, "id",
-                             RouterID(from->GetPubKey()).ToString());
+        metrics::integerTick(msg->Name(), "RX", 1, PeerTags(from));
       }
 
       msg->session = from;
@@ -136,12 +135,42 @@ namespace llarp
       return false;
     }
 
+    // relayed traffic is forwarded straight out of the receive buffer
+    RelayMessageView relay;
+    if(relay.Parse(buf))
+    {
+      metrics::integerTick(
+          relay.type == 'u' ? "RelayUpstream" : "RelayDownstream", "RX", 1,
+          PeerTags(src));
+      return relay.Handle(router, src);
+    }
+
     from     = src;
     firstkey = true;
     ManagedBuffer copy(buf);
     return bencode_read_dict(*this, &copy.underlying);
   }
 
+  metrics::TagsId
+  LinkMessageParser::PeerTags(ILinkSession* session)
+  {
+    // routers we stopped talking to would otherwise pile up here. the
+    // TagTable never forgets a tag set, so it holds one per router we ever
+    // talked to and hands a router its old id again after a clear
+    static constexpr size_t MaxPeerTags = 4096;
+
+    const RouterID remote(session->GetPubKey());
+    auto itr = peerTags.find(remote);
+    if(itr != peerTags.end())
+      return itr->second;
+    if(peerTags.size() >= MaxPeerTags)
+      peerTags.clear();
+    const auto tags =
+        metrics::TagTable::intern(metrics::packToTags("id", remote.ToString()));
+    peerTags.emplace(remote, tags);
+    return tags;
+  }
+
   void
   LinkMessageParser::Reset()
   {
@@ -3,8 +3,10 @@
 
 #include <router_id.hpp>
 #include <util/bencode.h>
+#include <util/metrics/types.hpp>
 
 #include <memory>
+#include <unordered_map>
 
 namespace llarp
 {
@@ -37,6 +39,11 @@ namespace llarp
     RouterID
     GetCurrentFrom();
 
+    /// metrics tags naming the session's remote router, interned on first
+    /// use so ticking a message does not encode the key every time
+    metrics::TagsId
+    PeerTags(ILinkSession* session);
+
    private:
     bool firstkey;
     AbstractRouter* router;
@@ -46,6 +53,8 @@ namespace llarp
     struct msg_holder_t;
 
     std::unique_ptr< msg_holder_t > holder;
+
+    std::unordered_map< RouterID, metrics::TagsId, RouterID::Hash > peerTags;
   };
 }  // namespace llarp
 #endif
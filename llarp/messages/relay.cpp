@@ -4,6 +4,8 @@
 #include <router/abstractrouter.hpp>
 #include <util/bencode.hpp>
 
+#include <algorithm>
+
 namespace llarp
 {
   void
@@ -116,4 +118,70 @@ namespace llarp
     llarp::LogWarn("unhandled downstream message");
     return false;
   }
+
+  /// read a bencoded string key and compare it to k
+  static bool
+  ReadKey(llarp_buffer_t* buf, char k)
+  {
+    llarp_buffer_t key;
+    return bencode_read_string(buf, &key) && key.sz == 1 && *key.base == k;
+  }
+
+  bool
+  RelayMessageView::Parse(const llarp_buffer_t& buf)
+  {
+    // d 1:a 1:? 1:p 16:... 1:v i?e 1:x ?:... 1:y 32:... e
+    llarp_buffer_t b(buf.base, buf.base, buf.sz);
+    llarp_buffer_t str;
+    if(b.sz == 0 || *b.cur != 'd')
+      return false;
+    b.cur++;
+    if(!ReadKey(&b, 'a') || !bencode_read_string(&b, &str) || str.sz != 1)
+      return false;
+    type = *str.base;
+    if(type != 'u' && type != 'd')
+      return false;
+    if(!ReadKey(&b, 'p') || !bencode_read_string(&b, &str)
+       || str.sz != PathID_t::SIZE)
+      return false;
+    pathid = str.base;
+    uint64_t v = 0;
+    if(!ReadKey(&b, 'v') || !bencode_read_integer(&b, &v)
+       || v != LLARP_PROTO_VERSION)
+      return false;
+    if(!ReadKey(&b, 'x') || !bencode_read_string(&b, &X)
+       || X.sz > MAX_LINK_MSG_SIZE - 128)
+      return false;
+    X.cur = X.base;
+    if(!ReadKey(&b, 'y') || !bencode_read_string(&b, &str)
+       || str.sz != TunnelNonce::SIZE)
+      return false;
+    nonce = str.base;
+    // must be the end of the dict and of the buffer
+    if(b.size_left() != 1 || *b.cur != 'e')
+      return false;
+    msg.base = buf.base;
+    msg.cur  = buf.base;
+    msg.sz   = buf.sz;
+    return true;
+  }
+
+  bool
+  RelayMessageView::Handle(AbstractRouter* router, ILinkSession* from)
+  {
+    const bool upstream = type == 'u';
+    PathID_t id;
+    std::copy_n(pathid, id.size(), id.begin());
+    auto& paths = router->pathContext();
+    auto path   = upstream ? paths.GetByDownstream(from->GetPubKey(), id)
+                         : paths.GetByUpstream(from->GetPubKey(), id);
+    if(path)
+    {
+      const TunnelNonce Y(nonce);
+      return path->HandleRelayInPlace(*this, Y, router);
+    }
+    if(!upstream)
+      llarp::LogWarn("unhandled downstream message");
+    return false;
+  }
 }  // namespace llarp
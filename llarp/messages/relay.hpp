@@ -59,6 +59,31 @@ namespace llarp
       return "RelayDownstream";
     }
   };
+
+  /// a relay message sitting in a receive buffer laid out exactly the way we
+  /// encode them, lets us handle it without decoding or copying the payload
+  struct RelayMessageView
+  {
+    /// 'u' or 'd'
+    byte_t type = 0;
+    /// the whole encoded message
+    llarp_buffer_t msg;
+    /// points at the path id inside msg
+    byte_t* pathid = nullptr;
+    /// the encrypted payload inside msg
+    llarp_buffer_t X;
+    /// points at the tunnel nonce inside msg
+    byte_t* nonce = nullptr;
+
+    /// return true if buf holds a relay message we can handle in place,
+    /// anything else goes through the regular parser
+    bool
+    Parse(const llarp_buffer_t& buf);
+
+    /// handle it like the decoded message would be, from link session from
+    bool
+    Handle(AbstractRouter* router, ILinkSession* from);
+  };
 }  // namespace llarp
 
 #endif
@@ -0,0 +1,188 @@
+#include <net/ip_pool.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace llarp
+{
+  namespace net
+  {
+    constexpr uint32_t IPPool::None;
+
+    void
+    IPPool::Init(huint128_t lo, huint128_t hi)
+    {
+      m_Lowest = lo;
+      ++m_Lowest;
+      // the list links need a spare value, cap absurdly large ranges
+      if(hi.h > m_Lowest.h)
+        m_Capacity =
+            static_cast< uint32_t >(std::min< absl::uint128 >(hi.h - m_Lowest.h,
+                                                             None));
+      else
+        m_Capacity = 0;
+      m_Entries.clear();
+      m_LRU  = List{};
+      m_Free = List{};
+      m_Reserved.clear();
+    }
+
+    bool
+    IPPool::Contains(huint128_t ip) const
+    {
+      return !(ip < m_Lowest) && ip.h - m_Lowest.h < m_Capacity;
+    }
+
+    uint32_t
+    IPPool::IndexOf(huint128_t ip) const
+    {
+      return static_cast< uint32_t >(ip.h - m_Lowest.h);
+    }
+
+    void
+    IPPool::Unlink(List& list, uint32_t idx)
+    {
+      Entry& entry = m_Entries[idx];
+      if(entry.prev == None)
+        list.head = entry.next;
+      else
+        m_Entries[entry.prev].next = entry.next;
+      if(entry.next == None)
+        list.tail = entry.prev;
+      else
+        m_Entries[entry.next].prev = entry.prev;
+      entry.prev = None;
+      entry.next = None;
+    }
+
+    void
+    IPPool::PushBack(List& list, uint32_t idx)
+    {
+      Entry& entry = m_Entries[idx];
+      entry.prev   = list.tail;
+      entry.next   = None;
+      if(list.tail == None)
+        list.head = idx;
+      else
+        m_Entries[list.tail].next = idx;
+      list.tail = idx;
+    }
+
+    bool
+    IPPool::Allocate(huint128_t& ip, bool& evicted, llarp_time_t now)
+    {
+      evicted      = false;
+      uint32_t idx = m_Free.head;
+      if(idx != None)
+        Unlink(m_Free, idx);
+      else
+      {
+        // first use of the next address, skip ones pinned ahead of time
+        while(m_Entries.size() < m_Capacity)
+        {
+          idx = static_cast< uint32_t >(m_Entries.size());
+          m_Entries.emplace_back();
+          if(m_Reserved.erase(idx) == 0)
+            break;
+          m_Entries[idx].state = State::Pinned;
+          idx                  = None;
+        }
+        if(idx == None)
+        {
+          idx = m_LRU.head;
+          if(idx == None)
+            return false;
+          Unlink(m_LRU, idx);
+          evicted = true;
+        }
+      }
+      Entry& entry     = m_Entries[idx];
+      entry.state      = State::Active;
+      entry.lastActive = now;
+      PushBack(m_LRU, idx);
+      ip = m_Lowest;
+      ip.h += idx;
+      return true;
+    }
+
+    void
+    IPPool::Touch(huint128_t ip, llarp_time_t now)
+    {
+      if(!Contains(ip))
+        return;
+      const uint32_t idx = IndexOf(ip);
+      if(idx >= m_Entries.size() || m_Entries[idx].state != State::Active)
+        return;
+      Entry& entry     = m_Entries[idx];
+      entry.lastActive = std::max(entry.lastActive, now);
+      if(m_LRU.tail != idx)
+      {
+        Unlink(m_LRU, idx);
+        PushBack(m_LRU, idx);
+      }
+    }
+
+    void
+    IPPool::Pin(huint128_t ip)
+    {
+      if(!Contains(ip))
+        return;
+      const uint32_t idx = IndexOf(ip);
+      if(idx >= m_Entries.size())
+      {
+        m_Reserved.insert(idx);
+        return;
+      }
+      Entry& entry = m_Entries[idx];
+      if(entry.state == State::Free)
+        Unlink(m_Free, idx);
+      else if(entry.state == State::Active)
+        Unlink(m_LRU, idx);
+      entry.state = State::Pinned;
+    }
+
+    void
+    IPPool::Release(huint128_t ip)
+    {
+      if(!Contains(ip))
+        return;
+      const uint32_t idx = IndexOf(ip);
+      if(idx >= m_Entries.size())
+      {
+        m_Reserved.erase(idx);
+        return;
+      }
+      Entry& entry = m_Entries[idx];
+      if(entry.state == State::Free)
+        return;
+      if(entry.state == State::Active)
+        Unlink(m_LRU, idx);
+      entry.state      = State::Free;
+      entry.lastActive = 0;
+      PushBack(m_Free, idx);
+    }
+
+    llarp_time_t
+    IPPool::LastActive(huint128_t ip) const
+    {
+      if(!Contains(ip))
+        return 0;
+      const uint32_t idx = IndexOf(ip);
+      if(idx >= m_Entries.size())
+        return m_Reserved.count(idx) ? std::numeric_limits< llarp_time_t >::max()
+                                     : 0;
+      const Entry& entry = m_Entries[idx];
+      if(entry.state == State::Pinned)
+        return std::numeric_limits< llarp_time_t >::max();
+      return entry.lastActive;
+    }
+
+    huint128_t
+    IPPool::NextUnused() const
+    {
+      huint128_t ip = m_Lowest;
+      ip.h += m_Entries.size();
+      return ip;
+    }
+  }  // namespace net
+}  // namespace llarp
@@ -0,0 +1,107 @@
+#ifndef LLARP_NET_IP_POOL_HPP
+#define LLARP_NET_IP_POOL_HPP
+
+#include <net/net_int.hpp>
+#include <util/types.hpp>
+
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+namespace llarp
+{
+  namespace net
+  {
+    /// hands out the addresses strictly between two bounds, once they are all
+    /// in use it takes back the least recently active one.
+    ///
+    /// addresses get an entry the first time they are handed out, entries
+    /// are threaded on an intrusive lru list while active and on a free list
+    /// once released, so allocating, touching and evicting are all O(1).
+    /// pinned addresses are on neither list and are never handed out.
+    struct IPPool
+    {
+      /// hand out addresses strictly between lo and hi, forgets everything
+      void
+      Init(huint128_t lo, huint128_t hi);
+
+      /// take a free address or, failing that, the least recently active
+      /// one. sets evicted if it was taken from its current holder. returns
+      /// false if every address is pinned.
+      bool
+      Allocate(huint128_t& ip, bool& evicted, llarp_time_t now);
+
+      /// ip was active at now, moves it to the back of the lru
+      void
+      Touch(huint128_t ip, llarp_time_t now);
+
+      /// ip is in use and is never evicted
+      void
+      Pin(huint128_t ip);
+
+      /// ip can be handed out again
+      void
+      Release(huint128_t ip);
+
+      /// ip is one we hand out
+      bool
+      Contains(huint128_t ip) const;
+
+      /// when ip was last active, max for pinned and 0 for unused addresses
+      llarp_time_t
+      LastActive(huint128_t ip) const;
+
+      /// the first address never handed out
+      huint128_t
+      NextUnused() const;
+
+     private:
+      static constexpr uint32_t None = UINT32_MAX;
+
+      enum class State : uint8_t
+      {
+        Free,
+        Active,
+        Pinned
+      };
+
+      struct Entry
+      {
+        uint32_t prev           = None;
+        uint32_t next           = None;
+        llarp_time_t lastActive = 0;
+        State state             = State::Free;
+      };
+
+      /// intrusive list through the entries
+      struct List
+      {
+        uint32_t head = None;
+        uint32_t tail = None;
+      };
+
+      void
+      Unlink(List& list, uint32_t idx);
+
+      void
+      PushBack(List& list, uint32_t idx);
+
+      /// index of ip, valid only if Contains(ip)
+      uint32_t
+      IndexOf(huint128_t ip) const;
+
+      huint128_t m_Lowest = {0};
+      uint32_t m_Capacity = 0;
+      /// indexed by offset from m_Lowest, grows as addresses are first used
+      std::vector< Entry > m_Entries;
+      /// active entries, least recently active first
+      List m_LRU;
+      /// released entries
+      List m_Free;
+      /// pinned before we got to them
+      std::unordered_set< uint32_t > m_Reserved;
+    };
+  }  // namespace net
+}  // namespace llarp
+
+#endif
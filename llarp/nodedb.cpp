@@ -10,13 +10,48 @@
 #include <util/thread/logic.hpp>
 #include <util/thread/thread_pool.hpp>
 
+#include <algorithm>
 #include <fstream>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 
 static const char skiplist_subdirs[] = "0123456789abcdef";
 static const std::string RC_FILE_EXT = ".signed";
 
+/// random picks to try before scanning the select index for a match
+static constexpr size_t SelectTries = 32;
+/// rc files read and verified by one job when loading
+static constexpr size_t LoadBatch = 64;
+
+static void
+IndexAdd(llarp_nodedb::SelectIndex_t &index,
+         size_t llarp_nodedb::NetDBEntry::*pos, llarp_nodedb::NetDBEntry *entry)
+{
+  entry->*pos = index.size();
+  index.push_back(entry);
+}
+
+/// swap remove so the index stays dense
+static void
+IndexDel(llarp_nodedb::SelectIndex_t &index,
+         size_t llarp_nodedb::NetDBEntry::*pos, llarp_nodedb::NetDBEntry *entry)
+{
+  const size_t idx = entry->*pos;
+  if(idx == llarp_nodedb::NetDBEntry::NotIndexed)
+    return;
+  index[idx]       = index.back();
+  index[idx]->*pos = idx;
+  index.pop_back();
+  entry->*pos = llarp_nodedb::NetDBEntry::NotIndexed;
+}
+
+static bool
+UsableAsHop(const llarp::RouterContact &rc, llarp_time_t now)
+{
+  return rc.addrs.size() && !rc.IsExpired(now);
+}
+
 llarp_nodedb::NetDBEntry::NetDBEntry(llarp::RouterContact value)
     : rc(std::move(value)), inserted(llarp::time_now_ms())
 {
@@ -42,6 +77,8 @@ llarp_nodedb::Clear()
 {
   llarp::util::Lock lock(&access);
   entries.clear();
+  hops.clear();
+  exits.clear();
 }
 
 bool
@@ -75,7 +112,7 @@ llarp_nodedb::RemoveIf(
       if(filter(itr->second.rc))
       {
         files.insert(getRCFilePath(itr->second.rc.pubkey));
-        itr = entries.erase(itr);
+        itr = EraseNoLock(itr);
       }
       else
         ++itr;
@@ -193,16 +230,41 @@ llarp_nodedb::Insert(const llarp::RouterContact &rc)
   // save rc after writing to disk
   {
     llarp::util::Lock lock(&access);
-    auto itr = entries.find(rc.pubkey.as_array());
-    if(itr != entries.end())
-      entries.erase(itr);
-    entries.emplace(rc.pubkey.as_array(), rc);
+    PutNoLock(rc);
     LogInfo("Added or updated RC for ", llarp::RouterID(rc.pubkey),
             " to nodedb.  Current nodedb count is: ", entries.size());
   }
   return true;
 }
 
+void
+llarp_nodedb::Put(const llarp::RouterContact &rc)
+{
+  llarp::util::Lock lock(&access);
+  PutNoLock(rc);
+}
+
+void
+llarp_nodedb::PutNoLock(const llarp::RouterContact &rc)
+{
+  auto itr = entries.find(rc.pubkey.as_array());
+  if(itr != entries.end())
+    EraseNoLock(itr);
+  auto &entry = entries.emplace(rc.pubkey.as_array(), rc).first->second;
+  if(UsableAsHop(entry.rc, llarp::time_now_ms()))
+    IndexAdd(hops, &NetDBEntry::hopsIndex, &entry);
+  if(entry.rc.IsExit())
+    IndexAdd(exits, &NetDBEntry::exitsIndex, &entry);
+}
+
+llarp_nodedb::NetDBMap_t::iterator
+llarp_nodedb::EraseNoLock(NetDBMap_t::iterator itr)
+{
+  IndexDel(hops, &NetDBEntry::hopsIndex, &itr->second);
+  IndexDel(exits, &NetDBEntry::exitsIndex, &itr->second);
+  return entries.erase(itr);
+}
+
 ssize_t
 llarp_nodedb::Load(const fs::path &path)
 {
@@ -211,21 +273,70 @@ llarp_nodedb::Load(const fs::path &path)
   {
     return -1;
   }
-  ssize_t loaded = 0;
-
+  // find every file first so reading and verifying can be split up evenly
+  std::vector< fs::path > files;
   for(const char &ch : skiplist_subdirs)
   {
     if(!ch)
       continue;
     std::string p;
     p += ch;
-    fs::path sub = path / p;
+    llarp::util::IterDir(path / p, [&](const fs::path &f) -> bool {
+      if(f.extension() == RC_FILE_EXT && fs::is_regular_file(f))
+        files.emplace_back(f);
+      return true;
+    });
+  }
 
-    ssize_t l = loadSubdir(sub);
-    if(l > 0)
-      loaded += l;
+  const llarp_time_t now = llarp::time_now_ms();
+  const size_t batches   = (files.size() + LoadBatch - 1) / LoadBatch;
+  std::vector< std::vector< llarp::RouterContact > > loaded(batches);
+  const auto loadBatch = [&](size_t batch) {
+    const size_t end = std::min(files.size(), (batch + 1) * LoadBatch);
+    for(size_t idx = batch * LoadBatch; idx < end; ++idx)
+    {
+      llarp::RouterContact rc;
+      if(ReadRC(files[idx], now, rc))
+        loaded[batch].emplace_back(std::move(rc));
+    }
+  };
+  if(batches > 1)
+  {
+    // the router's worker pools are not running yet when the nodedb is
+    // loaded at startup, so spin up one of our own for it
+    const size_t threads =
+        std::min< size_t >(std::thread::hardware_concurrency(), batches);
+    llarp::thread::ThreadPool pool(std::max< size_t >(threads, 1), batches,
+                                   "nodedb-load");
+    if(pool.start())
+    {
+      for(size_t batch = 0; batch < batches; ++batch)
+        pool.addJob(std::bind(loadBatch, batch));
+      pool.stop();
+    }
+    else
+    {
+      for(size_t batch = 0; batch < batches; ++batch)
+        loadBatch(batch);
+    }
   }
-  return loaded;
+  else if(batches == 1)
+    loadBatch(0);
+
+  ssize_t count = 0;
+  {
+    llarp::util::Lock lock(&access);
+    for(const auto &batch : loaded)
+    {
+      for(const auto &rc : batch)
+      {
+        if(entries.find(rc.pubkey.as_array()) == entries.end())
+          PutNoLock(rc);
+        ++count;
+      }
+    }
+  }
+  return count;
 }
 
 void
@@ -273,24 +384,34 @@ llarp_nodedb::loadSubdir(const fs::path &dir)
 }
 
 bool
-llarp_nodedb::loadfile(const fs::path &fpath)
+llarp_nodedb::ReadRC(const fs::path &fpath, llarp_time_t now,
+                     llarp::RouterContact &rc)
 {
-  if(fpath.extension() != RC_FILE_EXT)
-    return false;
-  llarp::RouterContact rc;
   if(!rc.Read(fpath.string().c_str()))
   {
     llarp::LogError("failed to read file ", fpath);
     return false;
   }
-  if(!rc.Verify(llarp::time_now_ms()))
+  if(!rc.Verify(now))
   {
     llarp::LogError(fpath, " contains invalid RC");
     return false;
   }
+  return true;
+}
+
+bool
+llarp_nodedb::loadfile(const fs::path &fpath)
+{
+  if(fpath.extension() != RC_FILE_EXT)
+    return false;
+  llarp::RouterContact rc;
+  if(!ReadRC(fpath, llarp::time_now_ms(), rc))
+    return false;
   {
     llarp::util::Lock lock(&access);
-    entries.emplace(rc.pubkey.as_array(), rc);
+    if(entries.find(rc.pubkey.as_array()) == entries.end())
+      PutNoLock(rc);
   }
   return true;
 }
@@ -501,34 +622,53 @@ bool
 llarp_nodedb::select_random_exit(llarp::RouterContact &result)
 {
   llarp::util::Lock lock(&access);
-  const auto sz = entries.size();
-  auto itr      = entries.begin();
-  if(sz < 3)
+  if(entries.size() < 3 || exits.empty())
     return false;
-  auto idx = llarp::randint() % sz;
-  if(idx)
-    std::advance(itr, idx - 1);
-  while(itr != entries.end())
+  result = exits[llarp::randint() % exits.size()]->rc;
+  return true;
+}
+
+template < typename Pred_t >
+llarp_nodedb::NetDBEntry *
+llarp_nodedb::PickHop(Pred_t pred, const SelectWeight_t &weight)
+{
+  const llarp_time_t now = llarp::time_now_ms();
+  // a few random picks almost always land on a match, the weight is only
+  // honoured here
+  size_t tries = 0;
+  while(tries < SelectTries && !hops.empty())
   {
-    if(itr->second.rc.IsExit())
+    NetDBEntry *entry = hops[llarp::randint() % hops.size()];
+    if(!UsableAsHop(entry->rc, now))
     {
-      result = itr->second.rc;
-      return true;
+      IndexDel(hops, &NetDBEntry::hopsIndex, entry);
+      continue;
     }
-    ++itr;
+    ++tries;
+    if(!pred(*entry))
+      continue;
+    if(weight == nullptr
+       || (llarp::randint() % 1024) < weight(entry->rc.pubkey) * 1024)
+      return entry;
   }
-  // wrap around
-  itr = entries.begin();
-  while(idx--)
+  // most of the hops are excluded or weighted out, look at all of them and
+  // only settle for one weighted at 0 if there is nothing else
+  if(hops.empty())
+    return nullptr;
+  NetDBEntry *fallback = nullptr;
+  const size_t sz      = hops.size();
+  const size_t start   = llarp::randint() % sz;
+  for(size_t idx = 0; idx < sz; ++idx)
   {
-    if(itr->second.rc.IsExit())
-    {
-      result = itr->second.rc;
-      return true;
-    }
-    ++itr;
+    NetDBEntry *entry = hops[(start + idx) % sz];
+    if(!UsableAsHop(entry->rc, now) || !pred(*entry))
+      continue;
+    if(weight == nullptr || weight(entry->rc.pubkey) > 0)
+      return entry;
+    if(fallback == nullptr)
+      fallback = entry;
   }
-  return false;
+  return fallback;
 }
 
 bool
@@ -538,87 +678,38 @@ llarp_nodedb::select_random_hop(const llarp::RouterContact &prev,
   llarp::util::Lock lock(&access);
   /// checking for "guard" status for N = 0 is done by caller inside of
   /// pathbuilder's scope
-  size_t sz = entries.size();
-  if(sz < 3)
+  if(entries.size() < 3)
     return false;
   if(!N)
     return false;
-  llarp_time_t now = llarp::time_now_ms();
-
-  auto itr   = entries.begin();
-  size_t pos = llarp::randint() % sz;
-  std::advance(itr, pos);
-  auto start = itr;
-  while(itr == entries.end())
-  {
-    if(prev.pubkey != itr->second.rc.pubkey)
-    {
-      if(itr->second.rc.addrs.size() && !itr->second.rc.IsExpired(now))
-      {
-        result = itr->second.rc;
-        return true;
-      }
-    }
-    itr++;
-  }
-  itr = entries.begin();
-  while(itr != start)
-  {
-    if(prev.pubkey != itr->second.rc.pubkey)
-    {
-      if(itr->second.rc.addrs.size() && !itr->second.rc.IsExpired(now))
-      {
-        result = itr->second.rc;
-        return true;
-      }
-    }
-    ++itr;
-  }
-  return false;
+  const NetDBEntry *entry = PickHop(
+      [&](const NetDBEntry &e) { return prev.pubkey != e.rc.pubkey; },
+      nullptr);
+  if(entry == nullptr)
+    return false;
+  result = entry->rc;
+  return true;
 }
 
 bool
 llarp_nodedb::select_random_hop_excluding(
-    llarp::RouterContact &result, const std::set< llarp::RouterID > &exclude)
+    llarp::RouterContact &result, const std::set< llarp::RouterID > &exclude,
+    const SelectWeight_t &weight)
 {
   llarp::util::Lock lock(&access);
   /// checking for "guard" status for N = 0 is done by caller inside of
   /// pathbuilder's scope
-  const size_t sz = entries.size();
-  if(sz < 3)
+  if(entries.size() < 3)
   {
     return false;
   }
-  llarp_time_t now = llarp::time_now_ms();
-
-  auto itr   = entries.begin();
-  size_t pos = llarp::randint() % sz;
-  std::advance(itr, pos);
-  auto start = itr;
-  while(itr == entries.end())
-  {
-    if(exclude.count(itr->first) == 0)
-    {
-      if(itr->second.rc.addrs.size() && !itr->second.rc.IsExpired(now))
-      {
-        result = itr->second.rc;
-        return true;
-      }
-    }
-    itr++;
-  }
-  itr = entries.begin();
-  while(itr != start)
-  {
-    if(exclude.count(itr->first) == 0)
-    {
-      if(itr->second.rc.addrs.size() && !itr->second.rc.IsExpired(now))
-      {
-        result = itr->second.rc;
-        return true;
-      }
-    }
-    ++itr;
-  }
-  return false;
+  const NetDBEntry *entry = PickHop(
+      [&](const NetDBEntry &e) {
+        return exclude.count(llarp::RouterID(e.rc.pubkey)) == 0;
+      },
+      weight);
+  if(entry == nullptr)
+    return false;
+  result = entry->rc;
+  return true;
 }
@@ -9,8 +9,11 @@
 
 #include <absl/base/thread_annotations.h>
 
+#include <functional>
+#include <limits>
 #include <set>
 #include <utility>
+#include <vector>
 
 #ifdef _MSC_VER
 #include <BaseTsd.h>
@@ -60,8 +63,13 @@ struct llarp_nodedb
 
   struct NetDBEntry
   {
+    static constexpr size_t NotIndexed = std::numeric_limits< size_t >::max();
+
     const llarp::RouterContact rc;
     llarp_time_t inserted;
+    /// position in hops and exits
+    size_t hopsIndex  = NotIndexed;
+    size_t exitsIndex = NotIndexed;
 
     NetDBEntry(llarp::RouterContact data);
   };
@@ -69,7 +77,17 @@ struct llarp_nodedb
   using NetDBMap_t =
       std::unordered_map< llarp::RouterID, NetDBEntry, llarp::RouterID::Hash >;
 
+  /// dense list of entries for picking one at random in O(1)
+  using SelectIndex_t = std::vector< NetDBEntry * >;
+
+  /// how much to favour a router when picking it, in [0, 1]
+  using SelectWeight_t = std::function< double(const llarp::RouterID &) >;
+
   NetDBMap_t entries GUARDED_BY(access);
+  /// entries usable as a path hop, ones found expired are dropped on the way
+  SelectIndex_t hops GUARDED_BY(access);
+  /// entries that are exits
+  SelectIndex_t exits GUARDED_BY(access);
   fs::path nodePath;
 
   bool
@@ -96,6 +114,10 @@ struct llarp_nodedb
   bool
   Insert(const llarp::RouterContact &rc) LOCKS_EXCLUDED(access);
 
+  /// insert or replace in memory only
+  void
+  Put(const llarp::RouterContact &rc) LOCKS_EXCLUDED(access);
+
   /// unconditional insert and write to disk in background
   /// updates the inserted time of the entry
   void
@@ -112,8 +134,10 @@ struct llarp_nodedb
                      std::function< void(void) > completionHandler = nullptr)
       LOCKS_EXCLUDED(access);
 
+  /// read and verify every rc under path in parallel, then add the valid
+  /// ones in one go, returns how many were valid
   ssize_t
-  Load(const fs::path &path);
+  Load(const fs::path &path) LOCKS_EXCLUDED(access);
 
   ssize_t
   loadSubdir(const fs::path &dir);
@@ -155,16 +179,37 @@ struct llarp_nodedb
                     llarp::RouterContact &result, size_t N)
       LOCKS_EXCLUDED(access);
 
+  /// pick a hop not in exclude, if weight is set a router is kept with
+  /// the probability it returns
   bool
   select_random_hop_excluding(llarp::RouterContact &result,
-                              const std::set< llarp::RouterID > &exclude)
+                              const std::set< llarp::RouterID > &exclude,
+                              const SelectWeight_t &weight = nullptr)
       LOCKS_EXCLUDED(access);
 
   static bool
   ensure_dir(const char *dir);
 
+  /// read an rc file and check it is valid at now
+  static bool
+  ReadRC(const fs::path &fpath, llarp_time_t now, llarp::RouterContact &rc);
+
   void
   SaveAll() LOCKS_EXCLUDED(access);
+
+ private:
+  void
+  PutNoLock(const llarp::RouterContact &rc) EXCLUSIVE_LOCKS_REQUIRED(access);
+
+  /// erase an entry and drop it from the select indexes
+  NetDBMap_t::iterator
+  EraseNoLock(NetDBMap_t::iterator itr) EXCLUSIVE_LOCKS_REQUIRED(access);
+
+  /// pick a usable hop that pred accepts, weighted by weight if set
+  template < typename Pred_t >
+  NetDBEntry *
+  PickHop(Pred_t pred, const SelectWeight_t &weight)
+      EXCLUSIVE_LOCKS_REQUIRED(access);
 };
 
 /// struct for async rc verification
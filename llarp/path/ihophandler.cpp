@@ -1 +1,18 @@
 #include <path/ihophandler.hpp>
+
+#include <messages/relay.hpp>
+
+namespace llarp
+{
+  namespace path
+  {
+    bool
+    IHopHandler::HandleRelayInPlace(RelayMessageView& view,
+                                    const TunnelNonce& Y, AbstractRouter* r)
+    {
+      if(view.type == 'u')
+        return HandleUpstream(view.X, Y, r);
+      return HandleDownstream(view.X, Y, r);
+    }
+  }  // namespace path
+}  // namespace llarp
@@ -12,6 +12,7 @@ struct llarp_buffer_t;
 namespace llarp
 {
   struct AbstractRouter;
+  struct RelayMessageView;
 
   namespace routing
   {
@@ -44,6 +45,12 @@ namespace llarp
       HandleDownstream(const llarp_buffer_t& X, const TunnelNonce& Y,
                        AbstractRouter* r) = 0;
 
+      /// handle a relay message still in its receive buffer, by default the
+      /// payload is handled in place like HandleUpstream/HandleDownstream
+      virtual bool
+      HandleRelayInPlace(RelayMessageView& view, const TunnelNonce& Y,
+                         AbstractRouter* r);
+
       /// return timestamp last remote activity happened at
       virtual llarp_time_t
       LastRemoteActivityAt() const = 0;
@@ -363,16 +363,27 @@ namespace llarp
       }
     }
 
+    bool
+    Path::OnionCrypt(const llarp_buffer_t& buf, const TunnelNonce& Y,
+                     bool upstream) const
+    {
+      std::array< OnionLayer, path::max_len > layers;
+      if(hops.size() > layers.size())
+        return false;
+      for(size_t idx = 0; idx < hops.size(); ++idx)
+        layers[idx] = {&hops[idx].shared, &hops[idx].nonceXOR};
+      // upstream mutates the nonce after each layer, downstream before
+      OnionPacket pkt{buf.base, buf.sz, Y};
+      return CryptoManager::instance()->onion_batch(
+          &pkt, 1, layers.data(), hops.size(), not upstream);
+    }
+
     bool
     Path::HandleUpstream(const llarp_buffer_t& buf, const TunnelNonce& Y,
                          AbstractRouter* r)
     {
-      TunnelNonce n = Y;
-      for(const auto& hop : hops)
-      {
-        CryptoManager::instance()->xchacha20(buf, hop.shared, n);
-        n ^= hop.nonceXOR;
-      }
+      if(!OnionCrypt(buf, Y, true))
+        return false;
       RelayUpstreamMessage msg;
       msg.X      = buf;
       msg.Y      = Y;
@@ -410,12 +421,8 @@ namespace llarp
     Path::HandleDownstream(const llarp_buffer_t& buf, const TunnelNonce& Y,
                            AbstractRouter* r)
     {
-      TunnelNonce n = Y;
-      for(const auto& hop : hops)
-      {
-        n ^= hop.nonceXOR;
-        CryptoManager::instance()->xchacha20(buf, hop.shared, n);
-      }
+      if(!OnionCrypt(buf, Y, false))
+        return false;
       if(!HandleRoutingMessage(buf, r))
         return false;
       m_LastRecvMessage = r->Now();
@@ -335,6 +335,11 @@ namespace llarp
       SendExitClose(const routing::CloseExitMessage& msg, AbstractRouter* r);
 
      private:
+      /// run buf through every hop's layer of onion crypto in one go
+      bool
+      OnionCrypt(const llarp_buffer_t& buf, const TunnelNonce& Y,
+                 bool upstream) const;
+
       /// call obtained exit hooks
       bool
       InformExitResult(llarp_time_t b);
@@ -98,20 +98,6 @@ namespace llarp
       return nullptr;
     }
 
-    template < typename Map_t, typename Key_t, typename CheckValue_t >
-    bool
-    MapHas(Map_t& map, const Key_t& k, CheckValue_t check)
-    {
-      util::Lock lock(&map.first);
-      auto range = map.second.equal_range(k);
-      for(auto i = range.first; i != range.second; ++i)
-      {
-        if(check(i->second))
-          return true;
-      }
-      return false;
-    }
-
     template < typename Map_t, typename Key_t, typename Value_t >
     void
     MapPut(Map_t& map, const Key_t& k, const Value_t& v)
@@ -120,30 +106,6 @@ namespace llarp
       map.second.emplace(k, v);
     }
 
-    template < typename Map_t, typename Visit_t >
-    void
-    MapIter(Map_t& map, Visit_t v)
-    {
-      util::Lock lock(map.first);
-      for(const auto& item : map.second)
-        v(item);
-    }
-
-    template < typename Map_t, typename Key_t, typename Check_t >
-    void
-    MapDel(Map_t& map, const Key_t& k, Check_t check)
-    {
-      util::Lock lock(map.first);
-      auto range = map.second.equal_range(k);
-      for(auto i = range.first; i != range.second;)
-      {
-        if(check(i->second))
-          i = map.second.erase(i);
-        else
-          ++i;
-      }
-    }
-
     void
     PathContext::AddOwnPath(PathSet_ptr set, Path_ptr path)
     {
@@ -155,16 +117,26 @@ namespace llarp
     bool
     PathContext::HasTransitHop(const TransitHopInfo& info)
     {
-      return MapHas(m_TransitPaths, info.txID,
-                    [info](const std::shared_ptr< TransitHop >& hop) -> bool {
-                      return info == hop->info;
-                    });
+      return m_TransitPaths.Get(info.txID, info.downstream,
+                                [&info](const TransitHop& hop) -> bool {
+                                  return info == hop.info;
+                                })
+          != nullptr;
     }
 
     HopHandler_ptr
     PathContext::GetByUpstream(const RouterID& remote, const PathID_t& id)
     {
-      auto own = MapGet(
+      // transit hops first, they are most of what a relay looks up and
+      // need no lock
+      auto hop = m_TransitPaths.Get(id, remote,
+                                    [&remote](const TransitHop& h) -> bool {
+                                      return h.info.upstream == remote;
+                                    });
+      if(hop)
+        return hop;
+
+      return MapGet(
           m_OurPaths, id,
           [](const PathSet_ptr) -> bool {
             // TODO: is this right?
@@ -173,41 +145,26 @@ namespace llarp
           [remote, id](PathSet_ptr p) -> HopHandler_ptr {
             return p->GetByUpstream(remote, id);
           });
-      if(own)
-        return own;
-
-      return MapGet(
-          m_TransitPaths, id,
-          [remote](const std::shared_ptr< TransitHop >& hop) -> bool {
-            return hop->info.upstream == remote;
-          },
-          [](const std::shared_ptr< TransitHop >& h) -> HopHandler_ptr {
-            return h;
-          });
     }
 
     bool
     PathContext::TransitHopPreviousIsRouter(const PathID_t& path,
                                             const RouterID& otherRouter)
     {
-      util::Lock lock(&m_TransitPaths.first);
-      auto itr = m_TransitPaths.second.find(path);
-      if(itr == m_TransitPaths.second.end())
-        return false;
-      return itr->second->info.downstream == otherRouter;
+      return m_TransitPaths.Get(path, otherRouter,
+                                [&otherRouter](const TransitHop& h) -> bool {
+                                  return h.info.downstream == otherRouter;
+                                })
+          != nullptr;
     }
 
     HopHandler_ptr
     PathContext::GetByDownstream(const RouterID& remote, const PathID_t& id)
     {
-      return MapGet(
-          m_TransitPaths, id,
-          [remote](const std::shared_ptr< TransitHop >& hop) -> bool {
-            return hop->info.downstream == remote;
-          },
-          [](const std::shared_ptr< TransitHop >& h) -> HopHandler_ptr {
-            return h;
-          });
+      return m_TransitPaths.Get(id, remote,
+                                [&remote](const TransitHop& h) -> bool {
+                                  return h.info.downstream == remote;
+                                });
     }
 
     PathSet_ptr
@@ -238,44 +195,22 @@ namespace llarp
     HopHandler_ptr
     PathContext::GetPathForTransfer(const PathID_t& id)
     {
-      RouterID us(OurRouterID());
-      auto& map = m_TransitPaths;
-      {
-        util::Lock lock(&map.first);
-        auto range = map.second.equal_range(id);
-        for(auto i = range.first; i != range.second; ++i)
-        {
-          if(i->second->info.upstream == us)
-            return i->second;
-        }
-      }
-      return nullptr;
+      const RouterID us(OurRouterID());
+      return m_TransitPaths.Get(id, us, [&us](const TransitHop& h) -> bool {
+        return h.IsEndpoint(us);
+      });
     }
 
     void
     PathContext::PutTransitHop(std::shared_ptr< TransitHop > hop)
     {
-      MapPut(m_TransitPaths, hop->info.txID, hop);
-      MapPut(m_TransitPaths, hop->info.rxID, hop);
+      m_TransitPaths.Put(hop);
     }
 
     void
     PathContext::ExpirePaths(llarp_time_t now)
     {
-      {
-        util::Lock lock(&m_TransitPaths.first);
-        auto& map = m_TransitPaths.second;
-        auto itr  = map.begin();
-        while(itr != map.end())
-        {
-          if(itr->second->Expired(now))
-          {
-            itr = map.erase(itr);
-          }
-          else
-            ++itr;
-        }
-      }
+      m_TransitPaths.Expire(now);
       {
         util::Lock lock(&m_OurPaths.first);
         auto& map = m_OurPaths.second;
@@ -297,17 +232,9 @@ namespace llarp
       if(h)
         return h;
       const RouterID us(OurRouterID());
-      auto& map = m_TransitPaths;
-      {
-        util::Lock lock(&map.first);
-        auto range = map.second.equal_range(id);
-        for(auto i = range.first; i != range.second; ++i)
-        {
-          if(i->second->info.upstream == us)
-            return i->second;
-        }
-      }
-      return nullptr;
+      return m_TransitPaths.Get(id, us, [&us](const TransitHop& hop) -> bool {
+        return hop.IsEndpoint(us);
+      });
     }
 
     void
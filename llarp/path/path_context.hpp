@@ -6,6 +6,7 @@
 #include <path/path_types.hpp>
 #include <path/pathset.hpp>
 #include <path/transit_hop.hpp>
+#include <path/transit_hop_table.hpp>
 #include <routing/handler.hpp>
 #include <router/i_outbound_message_handler.hpp>
 #include <util/compare_ptr.hpp>
@@ -98,23 +99,6 @@ namespace llarp
       void
       RemovePathSet(PathSet_ptr set);
 
-      using TransitHopsMap_t = std::multimap< PathID_t, TransitHop_ptr >;
-
-      struct SyncTransitMap_t
-      {
-        util::Mutex first;  // protects second
-        TransitHopsMap_t second GUARDED_BY(first);
-
-        void
-        ForEach(std::function< void(const TransitHop_ptr&) > visit)
-            LOCKS_EXCLUDED(first)
-        {
-          util::Lock lock(&first);
-          for(const auto& item : second)
-            visit(item.second);
-        }
-      };
-
       // maps path id -> pathset owner of path
       using OwnedPathsMap_t = std::map< PathID_t, PathSet_ptr >;
 
@@ -149,7 +133,7 @@ namespace llarp
 
      private:
       AbstractRouter* m_Router;
-      SyncTransitMap_t m_TransitPaths;
+      TransitHopTable m_TransitPaths;
       SyncOwnedPathsMap_t m_OurPaths;
       bool m_AllowTransit;
     };
@@ -1,6 +1,7 @@
 #include <path/pathbuilder.hpp>
 
 #include <crypto/crypto.hpp>
+#include <crypto/key_pool.hpp>
 #include <messages/relay_commit.hpp>
 #include <nodedb.hpp>
 #include <path/path_context.hpp>
@@ -10,6 +11,7 @@
 #include <util/meta/memfn.hpp>
 #include <util/thread/logic.hpp>
 
+#include <atomic>
 #include <functional>
 
 namespace llarp
@@ -25,93 +27,41 @@ namespace llarp
         std::function< void(std::shared_ptr< AsyncPathKeyExchangeContext >) >;
 
     Handler result;
-    size_t idx             = 0;
     AbstractRouter* router = nullptr;
     std::shared_ptr< thread::ThreadPool > worker;
     std::shared_ptr< Logic > logic;
     LR_CommitMessage LRCM;
 
+    /// keys taken from the pool up front, zero if it ran dry
+    std::array< SecretKey, path::max_len > framekeys;
+    /// hops still being generated
+    std::atomic< size_t > pending{0};
+    std::atomic< bool > failed{false};
+
     void
-    GenerateNextKey()
+    GenerateKey(size_t idx)
     {
-      // current hop
-      auto& hop   = path->hops[idx];
-      auto& frame = LRCM.frames[idx];
-
-      auto crypto = CryptoManager::instance();
-
-      // generate key
-      crypto->encryption_keygen(hop.commkey);
-      hop.nonce.Randomize();
-      // do key exchange
-      if(!crypto->dh_client(hop.shared, hop.rc.enckey, hop.commkey, hop.nonce))
-      {
-        LogError(pathset->Name(),
-                 " Failed to generate shared key for path build");
-        return;
-      }
-      // generate nonceXOR valueself->hop->pathKey
-      crypto->shorthash(hop.nonceXOR, llarp_buffer_t(hop.shared));
-      ++idx;
-
-      bool isFarthestHop = idx == path->hops.size();
-
-      LR_CommitRecord record;
-      if(isFarthestHop)
-      {
-        hop.upstream = hop.rc.pubkey;
-      }
-      else
-      {
-        hop.upstream  = path->hops[idx].rc.pubkey;
-        record.nextRC = std::make_unique< RouterContact >(path->hops[idx].rc);
-      }
-      // build record
-      record.lifetime    = path::default_lifetime;
-      record.version     = LLARP_PROTO_VERSION;
-      record.txid        = hop.txID;
-      record.rxid        = hop.rxID;
-      record.tunnelNonce = hop.nonce;
-      record.nextHop     = hop.upstream;
-      record.commkey     = seckey_topublic(hop.commkey);
-
-      llarp_buffer_t buf(frame.data(), frame.size());
-      buf.cur = buf.base + EncryptedFrameOverheadSize;
-      // encode record
-      if(!record.BEncode(&buf))
+      const auto& hops = path->hops;
+      const path::PathHopConfig* next =
+          idx + 1 < hops.size() ? &hops[idx + 1] : nullptr;
+      if(!path::SealHopRecord(path->hops[idx], next, LRCM.frames[idx],
+                              framekeys[idx]))
       {
-        // failed to encode?
-        LogError(pathset->Name(), " Failed to generate Commit Record");
-        DumpBuffer(buf);
-        return;
+        LogError(pathset->Name(), " Failed to generate record for hop ", idx);
+        failed.store(true);
       }
-      // use ephemeral keypair for frame
-      SecretKey framekey;
-      crypto->encryption_keygen(framekey);
-      if(!frame.EncryptInPlace(framekey, hop.rc.enckey))
-      {
-        LogError(pathset->Name(), " Failed to encrypt LRCR");
+      // last one done hands the build back to the logic thread
+      if(pending.fetch_sub(1) != 1 || failed.load())
         return;
-      }
-
-      if(isFarthestHop)
-      {
-        // farthest hop
-        // TODO: encrypt junk frames because our public keys are not eligator
-        logic->queue_func(std::bind(result, shared_from_this()));
-      }
-      else
-      {
-        // next hop
-        worker->addJob(std::bind(&AsyncPathKeyExchangeContext::GenerateNextKey,
-                                 shared_from_this()));
-      }
+      // TODO: encrypt junk frames because our public keys are not eligator
+      logic->queue_func(std::bind(result, shared_from_this()));
     }
 
     /// Generate all keys asynchronously and call handler when done
     void
     AsyncGenerateKeys(Path_t p, std::shared_ptr< Logic > l,
-                      std::shared_ptr< thread::ThreadPool > pool, Handler func)
+                      std::shared_ptr< thread::ThreadPool > pool,
+                      EncryptionKeyPool* keys, Handler func)
     {
       path   = p;
       logic  = l;
@@ -122,8 +72,24 @@ namespace llarp
       {
         LRCM.frames[i].Randomize();
       }
-      pool->addJob(std::bind(&AsyncPathKeyExchangeContext::GenerateNextKey,
-                             shared_from_this()));
+      const size_t numHops = path->hops.size();
+      if(keys)
+      {
+        for(size_t i = 0; i < numHops; ++i)
+        {
+          keys->Take(path->hops[i].commkey);
+          keys->Take(framekeys[i]);
+        }
+      }
+      // hops are independent, generate them all at once
+      pending.store(numHops);
+      for(size_t i = 0; i < numHops; ++i)
+      {
+        pool->addJob(std::bind(&AsyncPathKeyExchangeContext::GenerateKey,
+                               shared_from_this(), i));
+      }
+      if(keys)
+        keys->ScheduleRefill();
     }
   };
 
@@ -149,6 +115,56 @@ namespace llarp
 
   namespace path
   {
+    bool
+    SealHopRecord(PathHopConfig& hop, const PathHopConfig* next,
+                  EncryptedFrame& frame, SecretKey framekey)
+    {
+      auto crypto = CryptoManager::instance();
+
+      // generate key unless the pool gave us one
+      if(hop.commkey.IsZero())
+        crypto->encryption_keygen(hop.commkey);
+      hop.nonce.Randomize();
+      // do key exchange
+      if(!crypto->dh_client(hop.shared, hop.rc.enckey, hop.commkey, hop.nonce))
+        return false;
+      // generate nonceXOR valueself->hop->pathKey
+      crypto->shorthash(hop.nonceXOR, llarp_buffer_t(hop.shared));
+
+      LR_CommitRecord record;
+      if(next == nullptr)
+      {
+        // farthest hop
+        hop.upstream = hop.rc.pubkey;
+      }
+      else
+      {
+        hop.upstream  = next->rc.pubkey;
+        record.nextRC = std::make_unique< RouterContact >(next->rc);
+      }
+      // build record
+      record.lifetime    = path::default_lifetime;
+      record.version     = LLARP_PROTO_VERSION;
+      record.txid        = hop.txID;
+      record.rxid        = hop.rxID;
+      record.tunnelNonce = hop.nonce;
+      record.nextHop     = hop.upstream;
+      record.commkey     = seckey_topublic(hop.commkey);
+
+      llarp_buffer_t buf(frame.data(), frame.size());
+      buf.cur = buf.base + EncryptedFrameOverheadSize;
+      // encode record
+      if(!record.BEncode(&buf))
+      {
+        DumpBuffer(buf);
+        return false;
+      }
+      // use ephemeral keypair for frame
+      if(framekey.IsZero())
+        crypto->encryption_keygen(framekey);
+      return frame.EncryptInPlace(framekey, hop.rc.enckey);
+    }
+
     Builder::Builder(AbstractRouter* p_router, size_t pathNum, size_t hops)
         : path::PathSet(pathNum), _run(true), m_router(p_router), numHops(hops)
     {
@@ -224,14 +240,16 @@ namespace llarp
         return got;
       }
 
+      // favour routers that paths have worked over
+      const auto weight = [&](const RouterID& r) -> double {
+        return m_router->routerProfiling().PathSuccessRatio(r);
+      };
       do
       {
         cur.Clear();
         --tries;
-        std::set< RouterID > excluding = exclude;
-        if(db->select_random_hop_excluding(cur, excluding))
+        if(db->select_random_hop_excluding(cur, exclude, weight))
         {
-          excluding.insert(cur.pubkey);
           if(!m_router->routerProfiling().IsBadForPath(cur.pubkey))
             return true;
         }
@@ -427,6 +445,7 @@ namespace llarp
       path->SetBuildResultHook(
           [this](Path_ptr p) { this->HandlePathBuilt(p); });
       ctx->AsyncGenerateKeys(path, m_router->logic(), m_router->threadpool(),
+                             m_router->pathKeyPool().get(),
                              &PathBuilderKeysGenerated);
     }
 
@@ -9,11 +9,22 @@
 
 namespace llarp
 {
+  struct EncryptedFrame;
+
   namespace path
   {
     // milliseconds waiting between builds on a path
     constexpr llarp_time_t MIN_PATH_BUILD_INTERVAL = 500;
 
+    struct PathHopConfig;
+
+    /// do the key exchange for hop and seal its commit record into frame,
+    /// next is the hop after it or nullptr for the farthest hop. hop.commkey
+    /// and framekey are generated here if they are zero.
+    bool
+    SealHopRecord(PathHopConfig& hop, const PathHopConfig* next,
+                  EncryptedFrame& frame, SecretKey framekey);
+
     struct Builder : public PathSet
     {
      private:
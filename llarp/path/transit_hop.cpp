@@ -4,6 +4,7 @@
 #include <exit/context.hpp>
 #include <exit/exit_messages.hpp>
 #include <messages/discard.hpp>
+#include <messages/relay.hpp>
 #include <messages/relay_commit.hpp>
 #include <messages/relay_status.hpp>
 #include <path/path_context.hpp>
@@ -149,6 +150,28 @@ namespace llarp
       return r->SendToOrQueue(info.upstream, &msg);
     }
 
+    bool
+    TransitHop::HandleRelayInPlace(RelayMessageView& view,
+                                   const TunnelNonce& Y, AbstractRouter* r)
+    {
+      const bool upstream = view.type == 'u';
+      if(upstream && IsEndpoint(r->pubkey()))
+        return HandleUpstream(view.X, Y, r);
+
+      CryptoManager::instance()->xchacha20(view.X, pathKey, Y);
+      // the rest of the message keeps its layout, only p and y change
+      const PathID_t& pathid = upstream ? info.txID : info.rxID;
+      std::copy(pathid.begin(), pathid.end(), view.pathid);
+      const TunnelNonce N = Y ^ nonceXOR;
+      std::copy(N.begin(), N.end(), view.nonce);
+
+      const RouterID& next = upstream ? info.upstream : info.downstream;
+      llarp::LogDebug("relay ", view.X.sz, " bytes ",
+                      upstream ? "upstream" : "downstream", " in place to ",
+                      next);
+      return r->SendBufferToOrQueue(next, view.msg);
+    }
+
     bool
     TransitHop::HandleDHTMessage(const llarp::dht::IMessage& msg,
                                  AbstractRouter* r)
@@ -7,6 +7,8 @@
 #include <routing/handler.hpp>
 #include <router_id.hpp>
 
+#include <atomic>
+
 namespace llarp
 {
   struct LR_CommitRecord;
@@ -92,7 +94,8 @@ namespace llarp
       llarp_proto_version_t version;
       llarp_time_t m_LastActivity = 0;
 
-      bool destroy = false;
+      /// set from the logic thread, read by lockless lookups on any thread
+      std::atomic< bool > destroy{false};
 
       bool
       IsEndpoint(const RouterID& us) const
@@ -113,6 +116,11 @@ namespace llarp
       HandleLRSM(uint64_t status, std::array< EncryptedFrame, 8 >& frames,
                  AbstractRouter* r) override;
 
+      /// forward a relay message by rewriting it in its receive buffer
+      bool
+      HandleRelayInPlace(RelayMessageView& view, const TunnelNonce& Y,
+                         AbstractRouter* r) override;
+
       std::ostream&
       print(std::ostream& stream, int level, int spaces) const;
 
@@ -0,0 +1,199 @@
+#include <path/transit_hop_table.hpp>
+
+#include <cstring>
+
+namespace llarp
+{
+  namespace path
+  {
+    TransitHopTable::TransitHopTable() : m_Slots(new Slots(MinSlots))
+    {
+    }
+
+    TransitHopTable::~TransitHopTable()
+    {
+      delete m_Slots.load();
+    }
+
+    uint64_t
+    TransitHopTable::Tag(const PathID_t& id, const RouterID& neighbour)
+    {
+      // path ids are random, mix in the router so the up and downstream
+      // entries of a hop land apart
+      uint64_t a, b;
+      std::memcpy(&a, id.data(), sizeof(a));
+      std::memcpy(&b, neighbour.data(), sizeof(b));
+      uint64_t h = a ^ (b * 0x9E3779B97F4A7C15ULL);
+      h ^= h >> 31;
+      // never 0, that marks an unused slot
+      return h | 1;
+    }
+
+    size_t
+    TransitHopTable::Keys(const TransitHopInfo& info,
+                          std::array< uint64_t, KeysPerHop >& tags)
+    {
+      const std::array< std::pair< const PathID_t*, const RouterID* >,
+                        KeysPerHop >
+          keys = {{{&info.txID, &info.upstream},
+                   {&info.txID, &info.downstream},
+                   {&info.rxID, &info.upstream},
+                   {&info.rxID, &info.downstream}}};
+      size_t n = 0;
+      for(size_t k = 0; k < keys.size(); ++k)
+      {
+        bool dupe = false;
+        for(size_t j = 0; j < k; ++j)
+        {
+          if(*keys[j].first == *keys[k].first
+             && *keys[j].second == *keys[k].second)
+            dupe = true;
+        }
+        if(not dupe)
+          tags[n++] = Tag(*keys[k].first, *keys[k].second);
+      }
+      return n;
+    }
+
+    void
+    TransitHopTable::Link(Slots* slots, const Node* node)
+    {
+      std::array< uint64_t, KeysPerHop > tags;
+      const size_t n = Keys(node->hop->info, tags);
+      for(size_t k = 0; k < n; ++k)
+      {
+        size_t idx = (tags[k] >> 1) & slots->mask;
+        while(true)
+        {
+          auto& slot     = slots->slots[idx];
+          const auto old = slot.tag.load(std::memory_order_relaxed);
+          if(old == 0 || slot.node.load(std::memory_order_relaxed) == nullptr)
+          {
+            if(old == 0)
+              ++m_Used;
+            slot.tag.store(tags[k], std::memory_order_release);
+            slot.node.store(node, std::memory_order_release);
+            break;
+          }
+          idx = (idx + 1) & slots->mask;
+        }
+      }
+    }
+
+    void
+    TransitHopTable::Unlink(const Node* node)
+    {
+      Slots* slots = m_Slots.load(std::memory_order_relaxed);
+      std::array< uint64_t, KeysPerHop > tags;
+      const size_t n = Keys(node->hop->info, tags);
+      for(size_t k = 0; k < n; ++k)
+      {
+        size_t idx = (tags[k] >> 1) & slots->mask;
+        while(slots->slots[idx].tag.load(std::memory_order_relaxed) != 0)
+        {
+          auto& slot = slots->slots[idx];
+          if(slot.node.load(std::memory_order_relaxed) == node)
+          {
+            // leave the tag so probes keep walking past this tombstone
+            slot.node.store(nullptr, std::memory_order_release);
+            break;
+          }
+          idx = (idx + 1) & slots->mask;
+        }
+      }
+    }
+
+    void
+    TransitHopTable::Rehash(size_t hops)
+    {
+      // keep at most a quarter of the slots filed so probes stay short
+      size_t sz = MinSlots;
+      while(sz < hops * KeysPerHop * 4)
+        sz <<= 1;
+      auto slots = std::make_unique< Slots >(sz);
+      m_Used     = 0;
+      for(const auto& item : m_ByExpiry)
+        Link(slots.get(), item.second.get());
+      Slots* old = m_Slots.exchange(slots.release(), std::memory_order_acq_rel);
+      m_RetiredSlots[0].emplace_back(old);
+    }
+
+    TransitHopTable::ByExpiry_t::iterator
+    TransitHopTable::Remove(ByExpiry_t::iterator itr)
+    {
+      Unlink(itr->second.get());
+      m_RetiredNodes[0].emplace_back(std::move(itr->second));
+      return m_ByExpiry.erase(itr);
+    }
+
+    void
+    TransitHopTable::Put(const TransitHop_ptr& hop)
+    {
+      util::Lock lock(&m_Access);
+      auto itr = m_ByExpiry.emplace(hop->ExpireTime(),
+                                    std::make_unique< Node >(hop));
+      const Slots* slots = m_Slots.load(std::memory_order_relaxed);
+      // grow, or just sweep out tombstones, before we go over half full
+      if((m_Used + KeysPerHop) * 2 > slots->mask + 1)
+        Rehash(m_ByExpiry.size());
+      else
+        Link(m_Slots.load(std::memory_order_relaxed), itr->second.get());
+    }
+
+    void
+    TransitHopTable::Expire(llarp_time_t now)
+    {
+      util::Lock lock(&m_Access);
+      // nobody can still be looking at what was retired before the last pass
+      m_RetiredNodes[1].clear();
+      m_RetiredSlots[1].clear();
+      std::swap(m_RetiredNodes[0], m_RetiredNodes[1]);
+      std::swap(m_RetiredSlots[0], m_RetiredSlots[1]);
+
+      auto itr = m_ByExpiry.begin();
+      while(itr != m_ByExpiry.end() && itr->first <= now)
+        itr = Remove(itr);
+
+      // pick up where we left off looking for hops torn down early, always
+      // finishing off every hop with the same expiry time so none are skipped
+      itr = m_SweepFrom ? m_ByExpiry.upper_bound(m_SweepFrom)
+                        : m_ByExpiry.begin();
+      size_t checked = 0;
+      while(itr != m_ByExpiry.end() && checked < SweepBatch)
+      {
+        const auto at = itr->first;
+        while(itr != m_ByExpiry.end() && itr->first == at)
+        {
+          if(itr->second->hop->Expired(now))
+            itr = Remove(itr);
+          else
+            ++itr;
+          ++checked;
+        }
+        m_SweepFrom = at;
+      }
+      if(itr == m_ByExpiry.end())
+        m_SweepFrom = 0;
+
+      const Slots* slots = m_Slots.load(std::memory_order_relaxed);
+      if(slots->mask + 1 > MinSlots
+         && m_ByExpiry.size() * KeysPerHop * 16 < slots->mask + 1)
+        Rehash(m_ByExpiry.size());
+    }
+
+    size_t
+    TransitHopTable::Size() const
+    {
+      util::Lock lock(&m_Access);
+      return m_ByExpiry.size();
+    }
+
+    void
+    TransitHopTable::ForEach(std::function< void(const TransitHop_ptr&) > visit)
+    {
+      util::Lock lock(&m_Access);
+      for(const auto& item : m_ByExpiry)
+        visit(item.second->hop);
+    }
+  }  // namespace path
+}  // namespace llarp
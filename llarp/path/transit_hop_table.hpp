@@ -0,0 +1,176 @@
+#ifndef LLARP_PATH_TRANSIT_HOP_TABLE_HPP
+#define LLARP_PATH_TRANSIT_HOP_TABLE_HPP
+
+#include <path/transit_hop.hpp>
+#include <router_id.hpp>
+#include <util/thread/threading.hpp>
+#include <util/types.hpp>
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace llarp
+{
+  namespace path
+  {
+    using TransitHop_ptr = std::shared_ptr< TransitHop >;
+
+    /// open addressing hash table of transit hops keyed by (path id,
+    /// neighbour router id) where lookups never take a lock.
+    ///
+    /// each hop is filed under its tx and rx id paired with both its upstream
+    /// and downstream router. writers serialize on a mutex and publish slots
+    /// with release stores; anything a reader could still be looking at
+    /// (removed hops, outgrown slot arrays) is retired and only freed on the
+    /// expiry pass after next, which is a full router tick later.
+    struct TransitHopTable
+    {
+      /// how many hops an expiry pass checks for early teardown
+      static constexpr size_t SweepBatch = 256;
+
+      TransitHopTable();
+
+      ~TransitHopTable();
+
+      TransitHopTable(const TransitHopTable&) = delete;
+
+      TransitHopTable&
+      operator=(const TransitHopTable&) = delete;
+
+      /// add a hop, its info must not change after this
+      void
+      Put(const TransitHop_ptr& hop) LOCKS_EXCLUDED(m_Access);
+
+      /// get a hop filed under (id, neighbour) for which check returns true,
+      /// safe to call from any thread without locking. hops torn down early
+      /// are skipped even before the expiry pass gets round to them.
+      template < typename Check_t >
+      TransitHop_ptr
+      Get(const PathID_t& id, const RouterID& neighbour, Check_t check) const
+      {
+        const Slots* slots = m_Slots.load(std::memory_order_acquire);
+        const uint64_t tag = Tag(id, neighbour);
+        size_t idx         = (tag >> 1) & slots->mask;
+        for(size_t probes = 0; probes <= slots->mask; ++probes)
+        {
+          const Slot& slot = slots->slots[idx];
+          const auto t     = slot.tag.load(std::memory_order_acquire);
+          if(t == 0)
+            break;
+          if(t == tag)
+          {
+            // a slot can be refiled while we look at it so check the hop
+            // itself rather than trusting the tag
+            const Node* node = slot.node.load(std::memory_order_acquire);
+            if(node && Matches(node->hop->info, id, neighbour)
+               && not node->hop->destroy && check(*node->hop))
+              return node->hop;
+          }
+          idx = (idx + 1) & slots->mask;
+        }
+        return nullptr;
+      }
+
+      /// remove hops whose lifetime is over and look at up to SweepBatch
+      /// others for ones that were torn down early
+      void
+      Expire(llarp_time_t now) LOCKS_EXCLUDED(m_Access);
+
+      /// number of hops held
+      size_t
+      Size() const LOCKS_EXCLUDED(m_Access);
+
+      /// call visit on every hop held
+      void
+      ForEach(std::function< void(const TransitHop_ptr&) > visit)
+          LOCKS_EXCLUDED(m_Access);
+
+     private:
+      /// what a slot points at, never changes while published
+      struct Node
+      {
+        explicit Node(TransitHop_ptr h) : hop(std::move(h))
+        {
+        }
+
+        const TransitHop_ptr hop;
+      };
+
+      /// tag 0 marks a slot that was never used and ends a probe, a used slot
+      /// with no node is a tombstone left behind by a removal
+      struct Slot
+      {
+        std::atomic< uint64_t > tag{0};
+        std::atomic< const Node* > node{nullptr};
+      };
+
+      struct Slots
+      {
+        explicit Slots(size_t sz) : mask(sz - 1), slots(new Slot[sz])
+        {
+        }
+
+        const size_t mask;
+        const std::unique_ptr< Slot[] > slots;
+      };
+
+      /// smallest slot array we shrink down to
+      static constexpr size_t MinSlots = 64;
+      /// most slots a hop is filed under
+      static constexpr size_t KeysPerHop = 4;
+
+      static uint64_t
+      Tag(const PathID_t& id, const RouterID& neighbour);
+
+      static bool
+      Matches(const TransitHopInfo& info, const PathID_t& id,
+              const RouterID& neighbour)
+      {
+        return (info.txID == id || info.rxID == id)
+            && (info.upstream == neighbour || info.downstream == neighbour);
+      }
+
+      /// tags of every distinct (id, neighbour) pair of a hop, returns count
+      static size_t
+      Keys(const TransitHopInfo& info, std::array< uint64_t, KeysPerHop >& tags);
+
+      /// file node under every distinct (id, neighbour) pair of its hop
+      void
+      Link(Slots* slots, const Node* node) EXCLUSIVE_LOCKS_REQUIRED(m_Access);
+
+      void
+      Unlink(const Node* node) EXCLUSIVE_LOCKS_REQUIRED(m_Access);
+
+      /// rebuild the slot array at a size fitting the live hops
+      void
+      Rehash(size_t hops) EXCLUSIVE_LOCKS_REQUIRED(m_Access);
+
+      using ByExpiry_t = std::multimap< llarp_time_t, std::unique_ptr< Node > >;
+
+      /// unlink and retire a hop, returns the next one by expiry
+      ByExpiry_t::iterator
+      Remove(ByExpiry_t::iterator itr) EXCLUSIVE_LOCKS_REQUIRED(m_Access);
+
+      std::atomic< Slots* > m_Slots;
+
+      mutable util::Mutex m_Access;  // protects everything below
+      /// owns the live nodes, ordered by expiry time
+      ByExpiry_t m_ByExpiry GUARDED_BY(m_Access);
+      /// slots in use, including tombstones
+      size_t m_Used GUARDED_BY(m_Access) = 0;
+      /// where the last early teardown sweep stopped
+      llarp_time_t m_SweepFrom GUARDED_BY(m_Access) = 0;
+      /// retired in the current and the previous expiry pass
+      std::vector< std::unique_ptr< const Node > > m_RetiredNodes[2]
+          GUARDED_BY(m_Access);
+      std::vector< std::unique_ptr< Slots > > m_RetiredSlots[2]
+          GUARDED_BY(m_Access);
+    };
+  }  // namespace path
+}  // namespace llarp
+
+#endif
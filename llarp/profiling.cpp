@@ -97,6 +97,12 @@ namespace llarp
     return checkIsGood(pathFailCount, pathSuccessCount, chances);
   }
 
+  double
+  RouterProfile::PathSuccessRatio() const
+  {
+    return (pathSuccessCount + 1.0) / (pathSuccessCount + pathFailCount + 1.0);
+  }
+
   Profiling::Profiling() : m_DisableProfiling(false)
   {
   }
@@ -137,6 +143,18 @@ namespace llarp
     return !itr->second.IsGoodForPath(chances);
   }
 
+  double
+  Profiling::PathSuccessRatio(const RouterID& r)
+  {
+    if(m_DisableProfiling.load())
+      return 1.0;
+    lock_t lock(&m_ProfilesMutex);
+    auto itr = m_Profiles.find(r);
+    if(itr == m_Profiles.end())
+      return 1.0;
+    return itr->second.PathSuccessRatio();
+  }
+
   bool
   Profiling::IsBad(const RouterID& r, uint64_t chances)
   {
@@ -37,6 +37,10 @@ namespace llarp
     bool
     IsGoodForPath(uint64_t chances) const;
 
+    /// share of paths over this router that worked, in (0, 1]
+    double
+    PathSuccessRatio() const;
+
     /// decay stats
     void
     Decay();
@@ -60,6 +64,11 @@ namespace llarp
     IsBadForPath(const RouterID& r, uint64_t chances = 8)
         LOCK_RETURNED(m_ProfilesMutex);
 
+    /// how much to favour this router when picking hops, in (0, 1] and 1 for
+    /// routers we have no profile of
+    double
+    PathSuccessRatio(const RouterID& r) LOCKS_EXCLUDED(m_ProfilesMutex);
+
     /// check if this router should be connected directly to
     bool
     IsBadForConnect(const RouterID& r, uint64_t chances = 8)
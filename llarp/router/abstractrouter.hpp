@@ -29,6 +29,7 @@ namespace llarp
   struct IOutboundSessionMaker;
   struct ILinkManager;
   struct I_RCLookupHandler;
+  struct EncryptionKeyPool;
 
   namespace exit
   {
@@ -102,6 +103,10 @@ namespace llarp
     virtual std::shared_ptr< thread::ThreadPool >
     diskworker() = 0;
 
+    /// precomputed ephemeral keys for building paths
+    virtual std::shared_ptr< EncryptionKeyPool >
+    pathKeyPool() = 0;
+
     virtual service::Context &
     hiddenServiceContext() = 0;
 
@@ -178,6 +183,11 @@ namespace llarp
     SendToOrQueue(const RouterID &remote, const ILinkMessage *msg,
                   SendStatusHandler handler = nullptr) = 0;
 
+    /// send an already encoded link message to remote router or queue it
+    virtual bool
+    SendBufferToOrQueue(const RouterID &remote, const llarp_buffer_t &buf,
+                        SendStatusHandler handler = nullptr) = 0;
+
     virtual void
     PersistSessionUntil(const RouterID &remote, llarp_time_t until) = 0;
 
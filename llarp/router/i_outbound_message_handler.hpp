@@ -6,6 +6,8 @@
 #include <cstdint>
 #include <functional>
 
+struct llarp_buffer_t;
+
 namespace llarp
 {
   enum class SendStatus
@@ -31,6 +33,11 @@ namespace llarp
     QueueMessage(const RouterID &remote, const ILinkMessage *msg,
                  SendStatusHandler callback) = 0;
 
+    /// queue an already encoded link message
+    virtual bool
+    QueueMessageBuffer(const RouterID &remote, const llarp_buffer_t &buf,
+                       SendStatusHandler callback) = 0;
+
     virtual util::StatusObject
     ExtractStatus() const = 0;
   };
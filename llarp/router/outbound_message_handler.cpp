@@ -25,17 +25,27 @@ namespace llarp
       return false;
     }
 
+    return QueueMessageBuffer(remote, buf, callback);
+  }
+
+  bool
+  OutboundMessageHandler::QueueMessageBuffer(const RouterID &remote,
+                                             const llarp_buffer_t &buf,
+                                             SendStatusHandler callback)
+  {
+    // the link session copies it, only keep our own copy if we have to wait
+    // for a session
+    if(SendIfSession(remote, buf, callback))
+    {
+      return true;
+    }
+
     Message message;
     message.first.resize(buf.sz);
     message.second = callback;
 
     std::copy_n(buf.base, buf.sz, message.first.data());
 
-    if(SendIfSession(remote, message))
-    {
-      return true;
-    }
-
     bool shouldCreateSession = false;
     {
       util::Lock l(&_mutex);
@@ -166,10 +176,10 @@ namespace llarp
   }
 
   bool
-  OutboundMessageHandler::Send(const RouterID &remote, const Message &msg)
+  OutboundMessageHandler::Send(const RouterID &remote,
+                               const llarp_buffer_t &buf,
+                               SendStatusHandler callback)
   {
-    const llarp_buffer_t buf(msg.first);
-    auto callback = msg.second;
     return _linkManager->SendTo(
         remote, buf, [=](ILinkSession::DeliveryStatus status) {
           if(status == ILinkSession::DeliveryStatus::eDeliverySuccess)
@@ -181,11 +191,12 @@ namespace llarp
 
   bool
   OutboundMessageHandler::SendIfSession(const RouterID &remote,
-                                        const Message &msg)
+                                        const llarp_buffer_t &buf,
+                                        SendStatusHandler callback)
   {
     if(_linkManager->HasSessionTo(remote))
     {
-      return Send(remote, msg);
+      return Send(remote, buf, callback);
     }
     return false;
   }
@@ -213,7 +224,7 @@ namespace llarp
     {
       if(status == SendStatus::Success)
       {
-        Send(router, msg);
+        Send(router, llarp_buffer_t(msg.first), msg.second);
       }
       else
       {
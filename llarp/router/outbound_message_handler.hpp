@@ -28,6 +28,11 @@ namespace llarp
     QueueMessage(const RouterID &remote, const ILinkMessage *msg,
                  SendStatusHandler callback) override LOCKS_EXCLUDED(_mutex);
 
+    bool
+    QueueMessageBuffer(const RouterID &remote, const llarp_buffer_t &buf,
+                       SendStatusHandler callback) override
+        LOCKS_EXCLUDED(_mutex);
+
     util::StatusObject
     ExtractStatus() const override;
 
@@ -66,10 +71,12 @@ namespace llarp
     EncodeBuffer(const ILinkMessage *msg, llarp_buffer_t &buf);
 
     bool
-    Send(const RouterID &remote, const Message &msg);
+    Send(const RouterID &remote, const llarp_buffer_t &buf,
+         SendStatusHandler callback);
 
     bool
-    SendIfSession(const RouterID &remote, const Message &msg);
+    SendIfSession(const RouterID &remote, const llarp_buffer_t &buf,
+                  SendStatusHandler callback);
 
     void
     FinalizeRequest(const RouterID &router, SendStatus status)
@@ -5,6 +5,8 @@
 #include <constants/proto.hpp>
 #include <crypto/crypto_libsodium.hpp>
 #include <crypto/crypto.hpp>
+#include <crypto/key_pool.hpp>
+#include <crypto/verify_cache.hpp>
 #include <dht/context.hpp>
 #include <dht/node.hpp>
 #include <iwp/iwp.hpp>
@@ -90,6 +92,8 @@ namespace llarp
       , _exitContext(this)
       , disk(std::make_shared< llarp::thread::ThreadPool >(1, 1000,
                                                            "diskworker"))
+      , _pathKeyPool(std::make_shared< EncryptionKeyPool >(
+            path::key_pool_size, cryptoworker))
       , _dht(llarp_dht_context_new(this))
       , inbound_link_msg_parser(this)
       , _hiddenServiceContext(this)
@@ -114,7 +118,8 @@ namespace llarp
         {"dht", _dht->impl->ExtractStatus()},
         {"services", _hiddenServiceContext.ExtractStatus()},
         {"exit", _exitContext.ExtractStatus()},
-        {"links", _linkManager.ExtractStatus()}};
+        {"links", _linkManager.ExtractStatus()},
+        {"verifyCache", VerifyCache::Default().ExtractStatus()}};
   }
 
   bool
@@ -179,6 +184,18 @@ namespace llarp
     return _outboundMessageHandler.QueueMessage(remote, msg, handler);
   }
 
+  bool
+  Router::SendBufferToOrQueue(const RouterID &remote, const llarp_buffer_t &buf,
+                              SendStatusHandler handler)
+  {
+    if(handler == nullptr)
+    {
+      using std::placeholders::_1;
+      handler = std::bind(&Router::MessageSent, this, remote, _1);
+    }
+    return _outboundMessageHandler.QueueMessageBuffer(remote, buf, handler);
+  }
+
   void
   Router::ForEachPeer(std::function< void(const ILinkSession *, bool) > visit,
                       bool randomize) const
@@ -394,6 +411,9 @@ namespace llarp
     publicOverride     = conf->router.publicOverride();
     ip4addr            = conf->router.ip4addr();
 
+    m_LinkCryptoPipeline = conf->router.linkCryptoPipeline();
+    m_NetThreads         = conf->router.numNetThreads();
+
     if(!conf->router.blockBogons().value_or(true))
     {
       RouterContact::BlockBogons = false;
@@ -533,6 +553,9 @@ namespace llarp
         llarp::LogError("failed to ensure keyfile ", transport_keyfile);
         return false;
       }
+      if(m_LinkCryptoPipeline)
+        server->SetCryptoWorker(cryptoworker);
+      server->SetNetThreads(m_NetThreads);
 
       const auto &key = std::get< LinksConfig::Interface >(serverConfig);
       int af          = std::get< LinksConfig::AddressFamily >(serverConfig);
@@ -870,6 +893,7 @@ namespace llarp
       LogError("crypto worker failed to start");
       return false;
     }
+    _pathKeyPool->ScheduleRefill();
 
     if(!disk->start())
     {
@@ -1142,6 +1166,9 @@ namespace llarp
       LogError("failed to load ", transport_keyfile);
       return false;
     }
+    if(m_LinkCryptoPipeline)
+      link->SetCryptoWorker(cryptoworker);
+    link->SetNetThreads(m_NetThreads);
 
     const auto afs = {AF_INET, AF_INET6};
 
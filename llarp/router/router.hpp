@@ -171,6 +171,12 @@ namespace llarp
       return disk;
     }
 
+    std::shared_ptr< EncryptionKeyPool >
+    pathKeyPool() override
+    {
+      return _pathKeyPool;
+    }
+
     // our ipv4 public setting
     bool publicOverride = false;
     struct sockaddr_in ip4addr;
@@ -186,6 +192,7 @@ namespace llarp
     SecretKey _identity;
     SecretKey _encryption;
     std::shared_ptr< thread::ThreadPool > disk;
+    std::shared_ptr< EncryptionKeyPool > _pathKeyPool;
     llarp_dht_context *_dht = nullptr;
     llarp_nodedb *_nodedb;
     llarp_time_t _startedAt;
@@ -386,6 +393,11 @@ namespace llarp
     SendToOrQueue(const RouterID &remote, const ILinkMessage *msg,
                   SendStatusHandler handler) override;
 
+    /// send an already encoded link message, same rules as SendToOrQueue
+    bool
+    SendBufferToOrQueue(const RouterID &remote, const llarp_buffer_t &buf,
+                        SendStatusHandler handler) override;
+
     void
     ForEachPeer(std::function< void(const ILinkSession *, bool) > visit,
                 bool randomize = false) const override;
@@ -462,6 +474,12 @@ namespace llarp
 
     bool m_isServiceNode = false;
 
+    /// offload per packet link crypto to the crypto worker
+    bool m_LinkCryptoPipeline = false;
+
+    /// threads each link reads and writes datagrams on
+    size_t m_NetThreads = 1;
+
     llarp_time_t m_LastStatsReport = 0;
 
     bool
@@ -2,6 +2,7 @@
 
 #include <constants/version.hpp>
 #include <crypto/crypto.hpp>
+#include <crypto/verify_cache.hpp>
 #include <net/net.hpp>
 #include <util/bencode.hpp>
 #include <util/buffer.hpp>
@@ -332,7 +333,7 @@ namespace llarp
         return false;
       }
     }
-    if(!VerifySignature())
+    if(!VerifySignature(now))
     {
       llarp::LogError("invalid signature");
       return false;
@@ -341,7 +342,7 @@ namespace llarp
   }
 
   bool
-  RouterContact::VerifySignature() const
+  RouterContact::VerifySignature(llarp_time_t now) const
   {
     RouterContact copy;
     copy = *this;
@@ -355,7 +356,7 @@ namespace llarp
     }
     buf.sz  = buf.cur - buf.base;
     buf.cur = buf.base;
-    return CryptoManager::instance()->verify(pubkey, buf, signature);
+    return VerifyCache::Default().Verify(pubkey, buf, signature, now);
   }
 
   bool
@@ -208,7 +208,7 @@ namespace llarp
 
    private:
     bool
-    VerifySignature() const;
+    VerifySignature(llarp_time_t now) const;
   };
 
   inline std::ostream &
@@ -68,7 +68,7 @@ namespace llarp
       // set sender
       self->msg.sender = self->m_LocalIdentity.pub;
       // set version
-      self->msg.version = LLARP_PROTO_VERSION;
+      self->msg.version = eProtocolVersionFrameMAC;
       // encrypt and sign
       if(self->frame.EncryptAndSign(self->msg, K, self->m_LocalIdentity))
         self->logic->queue_job({self, &Result});
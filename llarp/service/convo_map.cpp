@@ -0,0 +1,75 @@
+#include <service/convo_map.hpp>
+
+namespace llarp
+{
+  namespace service
+  {
+    const Session*
+    ConvoMap::Find(const ConvoTag& tag) const
+    {
+      auto itr = m_Sessions.find(tag);
+      if(itr == m_Sessions.end())
+        return nullptr;
+      return &itr->second;
+    }
+
+    bool
+    ConvoMap::Erase(const ConvoTag& tag)
+    {
+      auto itr = m_Sessions.find(tag);
+      if(itr == m_Sessions.end())
+        return false;
+      Unlink(itr->second.remote.Addr(), tag);
+      m_ByExpiry.erase({itr->second.ExpiresAt(), tag});
+      m_Sessions.erase(itr);
+      return true;
+    }
+
+    bool
+    ConvoMap::GetTagsFor(const Address& addr, std::set< ConvoTag >& tags) const
+    {
+      auto itr = m_ByAddr.find(addr);
+      if(itr == m_ByAddr.end())
+        return false;
+      bool inserted = false;
+      for(const auto& tag : itr->second)
+      {
+        if(tags.insert(tag).second)
+          inserted = true;
+      }
+      return inserted;
+    }
+
+    bool
+    ConvoMap::HasInbound(const Address& addr) const
+    {
+      auto itr = m_ByAddr.find(addr);
+      if(itr == m_ByAddr.end())
+        return false;
+      for(const auto& tag : itr->second)
+      {
+        if(m_Sessions.at(tag).inbound)
+          return true;
+      }
+      return false;
+    }
+
+    void
+    ConvoMap::Index(Map_t::const_iterator itr)
+    {
+      m_ByAddr[itr->second.remote.Addr()].insert(itr->first);
+      m_ByExpiry.emplace(itr->second.ExpiresAt(), itr->first);
+    }
+
+    void
+    ConvoMap::Unlink(const Address& addr, const ConvoTag& tag)
+    {
+      auto itr = m_ByAddr.find(addr);
+      if(itr == m_ByAddr.end())
+        return;
+      itr->second.erase(tag);
+      if(itr->second.empty())
+        m_ByAddr.erase(itr);
+    }
+  }  // namespace service
+}  // namespace llarp
@@ -0,0 +1,150 @@
+#ifndef LLARP_SERVICE_CONVO_MAP_HPP
+#define LLARP_SERVICE_CONVO_MAP_HPP
+
+#include <service/address.hpp>
+#include <service/handler.hpp>
+#include <service/session.hpp>
+
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace llarp
+{
+  namespace service
+  {
+    /// conversations by tag, indexed by remote address and by when they
+    /// expire so neither lookup nor expiry has to walk every conversation.
+    ///
+    /// sessions are only changed through Visit and Put which put them back
+    /// in the indexes afterwards.
+    struct ConvoMap
+    {
+      using Map_t = std::unordered_map< ConvoTag, Session, ConvoTag::Hash >;
+      using const_iterator = Map_t::const_iterator;
+
+      /// session for tag or nullptr
+      const Session*
+      Find(const ConvoTag& tag) const;
+
+      bool
+      Contains(const ConvoTag& tag) const
+      {
+        return m_Sessions.count(tag) != 0;
+      }
+
+      /// call visit with the session for tag if we have one, returns false if
+      /// we don't
+      template < typename Visit_t >
+      bool
+      Visit(const ConvoTag& tag, Visit_t visit)
+      {
+        auto itr = m_Sessions.find(tag);
+        if(itr == m_Sessions.end())
+          return false;
+        Update(itr, visit);
+        return true;
+      }
+
+      /// like Visit but makes the session first if we don't have it, created
+      /// tells visit which one it was
+      template < typename Visit_t >
+      void
+      Put(const ConvoTag& tag, Visit_t visit)
+      {
+        auto itr = m_Sessions.find(tag);
+        if(itr == m_Sessions.end())
+        {
+          itr = m_Sessions.emplace(tag, Session{}).first;
+          Index(itr);
+          Update(itr, [&](Session& s) { visit(s, true); });
+        }
+        else
+          Update(itr, [&](Session& s) { visit(s, false); });
+      }
+
+      bool
+      Erase(const ConvoTag& tag);
+
+      /// put the tags we have with addr into tags, returns true if any were
+      /// new to tags
+      bool
+      GetTagsFor(const Address& addr, std::set< ConvoTag >& tags) const;
+
+      /// we have an inbound convo with addr
+      bool
+      HasInbound(const Address& addr) const;
+
+      /// remove every session expired at now, soonest to expire first, and
+      /// call visit with each before it goes
+      template < typename Visit_t >
+      void
+      Expire(llarp_time_t now, Visit_t visit)
+      {
+        while(!m_ByExpiry.empty() && m_ByExpiry.begin()->first <= now)
+        {
+          const ConvoTag tag = m_ByExpiry.begin()->second;
+          visit(tag);
+          Erase(tag);
+        }
+      }
+
+      size_t
+      Size() const
+      {
+        return m_Sessions.size();
+      }
+
+      const_iterator
+      begin() const
+      {
+        return m_Sessions.begin();
+      }
+
+      const_iterator
+      end() const
+      {
+        return m_Sessions.end();
+      }
+
+     private:
+      using Tags_t = std::unordered_set< ConvoTag, ConvoTag::Hash >;
+
+      template < typename Visit_t >
+      void
+      Update(Map_t::iterator itr, Visit_t visit)
+      {
+        Session& s                 = itr->second;
+        const Address addr         = s.remote.Addr();
+        const llarp_time_t expires = s.ExpiresAt();
+        visit(s);
+        if(addr != s.remote.Addr())
+        {
+          Unlink(addr, itr->first);
+          m_ByAddr[s.remote.Addr()].insert(itr->first);
+        }
+        if(expires != s.ExpiresAt())
+        {
+          m_ByExpiry.erase({expires, itr->first});
+          m_ByExpiry.emplace(s.ExpiresAt(), itr->first);
+        }
+      }
+
+      void
+      Index(Map_t::const_iterator itr);
+
+      /// take tag out of addr's tags
+      void
+      Unlink(const Address& addr, const ConvoTag& tag);
+
+      Map_t m_Sessions;
+      /// tags by remote address
+      std::unordered_map< Address, Tags_t, Address::Hash > m_ByAddr;
+      /// tags by when they expire
+      std::set< std::pair< llarp_time_t, ConvoTag > > m_ByExpiry;
+    };
+  }  // namespace service
+}  // namespace llarp
+
+#endif
@@ -133,22 +133,20 @@ namespace llarp
                                       llarp::AlignedBuffer< 32 >& addr,
                                       bool& snode) const
     {
-      auto itr = Sessions().find(tag);
-      if(itr != Sessions().end())
+      const Session* s = Sessions().Find(tag);
+      if(s)
       {
         snode = false;
-        addr  = itr->second.remote.Addr();
+        addr  = s->remote.Addr();
         return true;
       }
 
-      for(const auto& item : m_state->m_SNodeSessions)
+      auto itr = m_state->m_SNodeTags.find(tag);
+      if(itr != m_state->m_SNodeTags.end())
       {
-        if(item.second.second == tag)
-        {
-          snode = true;
-          addr  = item.first;
-          return true;
-        }
+        snode = true;
+        addr  = itr->second;
+        return true;
       }
 
       return false;
@@ -179,7 +177,8 @@ namespace llarp
       }
 
       // expire snode sessions
-      EndpointUtil::ExpireSNodeSessions(now, m_state->m_SNodeSessions);
+      EndpointUtil::ExpireSNodeSessions(now, m_state->m_SNodeSessions,
+                                        m_state->m_SNodeTags);
       // expire pending tx
       EndpointUtil::ExpirePendingTx(now, m_state->m_PendingLookups);
       // expire pending router lookups
@@ -328,79 +327,71 @@ namespace llarp
     bool
     Endpoint::HasInboundConvo(const Address& addr) const
     {
-      for(const auto& item : Sessions())
-      {
-        if(item.second.remote.Addr() == addr && item.second.inbound)
-          return true;
-      }
-      return false;
+      return Sessions().HasInbound(addr);
     }
 
     void
     Endpoint::PutSenderFor(const ConvoTag& tag, const ServiceInfo& info,
                            bool inbound)
     {
-      auto itr = Sessions().find(tag);
-      if(itr == Sessions().end())
-      {
-        itr                 = Sessions().emplace(tag, Session{}).first;
-        itr->second.inbound = inbound;
-        itr->second.remote  = info;
-      }
-      itr->second.lastUsed = Now();
+      const auto now = Now();
+      Sessions().Put(tag, [&](Session& s, bool created) {
+        if(created)
+        {
+          s.inbound = inbound;
+          s.remote  = info;
+        }
+        s.lastUsed = now;
+      });
     }
 
     bool
     Endpoint::GetSenderFor(const ConvoTag& tag, ServiceInfo& si) const
     {
-      auto itr = Sessions().find(tag);
-      if(itr == Sessions().end())
+      const Session* s = Sessions().Find(tag);
+      if(s == nullptr)
         return false;
-      si = itr->second.remote;
+      si = s->remote;
       return true;
     }
 
     void
     Endpoint::PutIntroFor(const ConvoTag& tag, const Introduction& intro)
     {
-      auto itr = Sessions().find(tag);
-      if(itr == Sessions().end())
-      {
-        return;
-      }
-      itr->second.intro    = intro;
-      itr->second.lastUsed = Now();
+      const auto now = Now();
+      Sessions().Visit(tag, [&](Session& s) {
+        s.intro    = intro;
+        s.lastUsed = now;
+      });
     }
 
     bool
     Endpoint::GetIntroFor(const ConvoTag& tag, Introduction& intro) const
     {
-      auto itr = Sessions().find(tag);
-      if(itr == Sessions().end())
+      const Session* s = Sessions().Find(tag);
+      if(s == nullptr)
         return false;
-      intro = itr->second.intro;
+      intro = s->intro;
       return true;
     }
 
     void
     Endpoint::PutReplyIntroFor(const ConvoTag& tag, const Introduction& intro)
     {
-      auto itr = Sessions().find(tag);
-      if(itr == Sessions().end())
-      {
-        return;
-      }
-      itr->second.replyIntro = intro;
-      itr->second.lastUsed   = Now();
+      const auto now = Now();
+      Sessions().Visit(tag, [&](Session& s) {
+        s.replyIntro = intro;
+        s.lastUsed   = now;
+      });
     }
 
     bool
     Endpoint::GetReplyIntroFor(const ConvoTag& tag, Introduction& intro) const
     {
-      auto itr = Sessions().find(tag);
-      if(itr == Sessions().end())
+      const Session* s = Sessions().Find(tag);
+      if(s == nullptr)
         return false;
-      intro = itr->second.replyIntro;
+      intro = s->replyIntro;
       return true;
     }
 
@@ -415,33 +406,41 @@ namespace llarp
     Endpoint::GetCachedSessionKeyFor(const ConvoTag& tag,
                                      SharedSecret& secret) const
     {
-      auto itr = Sessions().find(tag);
-      if(itr == Sessions().end())
+      const Session* s = Sessions().Find(tag);
+      if(s == nullptr)
         return false;
-      secret = itr->second.sharedKey;
+      secret = s->sharedKey;
       return true;
     }
 
     void
     Endpoint::PutCachedSessionKeyFor(const ConvoTag& tag, const SharedSecret& k)
     {
-      auto itr = Sessions().find(tag);
-      if(itr == Sessions().end())
-      {
-        itr = Sessions().emplace(tag, Session{}).first;
-      }
-      itr->second.sharedKey = k;
-      itr->second.lastUsed  = Now();
+      const auto now = Now();
+      Sessions().Put(tag, [&](Session& s, bool) {
+        s.sharedKey = k;
+        s.lastUsed  = now;
+      });
     }
 
     void
     Endpoint::MarkConvoTagActive(const ConvoTag& tag)
     {
-      auto itr = Sessions().find(tag);
-      if(itr != Sessions().end())
-      {
-        itr->second.lastUsed = Now();
-      }
+      const auto now = Now();
+      Sessions().Visit(tag, [now](Session& s) { s.lastUsed = now; });
+    }
+
+    void
+    Endpoint::MarkFrameMACFor(const ConvoTag& tag)
+    {
+      Sessions().Visit(tag, [](Session& s) { s.frameMAC = true; });
+    }
+
+    bool
+    Endpoint::HasFrameMACFor(const ConvoTag& tag) const
+    {
+      const Session* s = Sessions().Find(tag);
+      return s && s->frameMAC;
     }
 
     bool
@@ -804,6 +803,9 @@ namespace llarp
       intro.router    = PubKey(path->Endpoint());
       intro.expiresAt = std::min(path->ExpireTime(), msg->introReply.expiresAt);
       PutIntroFor(msg->tag, intro);
+      // authenticated by the frame it came in so the remote really said so
+      if(msg->version >= eProtocolVersionFrameMAC)
+        MarkFrameMACFor(msg->tag);
       return ProcessDataMessage(msg);
     }
 
@@ -844,7 +846,7 @@ namespace llarp
     void
     Endpoint::RemoveConvoTag(const ConvoTag& t)
     {
-      Sessions().erase(t);
+      Sessions().Erase(t);
     }
 
     bool
@@ -998,6 +1000,7 @@ namespace llarp
             Router(), numPaths, numHops, false, ShouldBundleRC());
 
         m_state->m_SNodeSessions.emplace(snode, std::make_pair(session, tag));
+        m_state->m_SNodeTags.emplace(tag, snode);
       }
       EnsureRouterIsKnown(snode);
       auto range = nodeSessions.equal_range(snode);
@@ -1142,7 +1145,10 @@ namespace llarp
             f.S         = 1;
             f.F         = m.introReply.pathID;
             transfer->P = remoteIntro.pathID;
-            if(!f.EncryptAndSign(m, K, m_Identity))
+            const bool sealed = HasFrameMACFor(f.T)
+                ? f.EncryptAndMAC(m, K)
+                : f.EncryptAndSign(m, K, m_Identity);
+            if(!sealed)
             {
               LogError("failed to encrypt and sign");
               return false;
@@ -1196,16 +1202,15 @@ namespace llarp
     bool
     Endpoint::HasConvoTag(const ConvoTag& t) const
     {
-      return Sessions().find(t) != Sessions().end();
+      return Sessions().Contains(t);
     }
 
     uint64_t
     Endpoint::GetSeqNoForConvo(const ConvoTag& tag)
     {
-      auto itr = Sessions().find(tag);
-      if(itr == Sessions().end())
-        return 0;
-      return ++(itr->second.seqno);
+      uint64_t seqno = 0;
+      Sessions().Visit(tag, [&seqno](Session& s) { seqno = ++s.seqno; });
+      return seqno;
     }
 
     bool
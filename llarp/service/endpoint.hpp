@@ -32,6 +32,7 @@ namespace llarp
   {
     struct AsyncKeyExchange;
     struct Context;
+    struct ConvoMap;
     struct EndpointState;
     struct OutboundContext;
 
@@ -320,6 +321,12 @@ namespace llarp
       void
       MarkConvoTagActive(const ConvoTag& remote) override;
 
+      void
+      MarkFrameMACFor(const ConvoTag& remote) override;
+
+      bool
+      HasFrameMACFor(const ConvoTag& remote) const override;
+
       void
       PutReplyIntroFor(const ConvoTag& remote,
                        const Introduction& intro) override;
@@ -432,7 +439,6 @@ namespace llarp
       const IntroSet& introSet() const;
       IntroSet&       introSet();
 
-      using ConvoMap = std::unordered_map< ConvoTag, Session, ConvoTag::Hash >;
       const ConvoMap& Sessions() const;
       ConvoMap&       Sessions();
       // clang-format on
@@ -66,6 +66,8 @@ namespace llarp
       std::set< ConvoTag > m_InboundConvos;
 
       SNodeSessions m_SNodeSessions;
+      /// snode a convo tag from m_SNodeSessions goes to
+      SNodeConvoTags m_SNodeTags;
 
       std::unordered_multimap< Address, PathEnsureHook, Address::Hash >
           m_PendingServiceLookups;
@@ -1,6 +1,7 @@
 #ifndef LLARP_SERVICE_ENDPOINT_TYPES_HPP
 #define LLARP_SERVICE_ENDPOINT_TYPES_HPP
 
+#include <service/convo_map.hpp>
 #include <service/pendingbuffer.hpp>
 #include <service/router_lookup_job.hpp>
 #include <service/session.hpp>
@@ -52,7 +53,9 @@ namespace llarp
     using SNodeSessions =
         std::unordered_multimap< RouterID, SNodeSessionValue, RouterID::Hash >;
 
-    using ConvoMap = std::unordered_map< ConvoTag, Session, ConvoTag::Hash >;
+    /// which snode session a convo tag belongs to
+    using SNodeConvoTags =
+        std::unordered_map< ConvoTag, RouterID, ConvoTag::Hash >;
 
     using PathEnsureHook = std::function< void(Address, OutboundContext*) >;
 
@@ -10,13 +10,15 @@ namespace llarp
   namespace service
   {
     void
-    EndpointUtil::ExpireSNodeSessions(llarp_time_t now, SNodeSessions& sessions)
+    EndpointUtil::ExpireSNodeSessions(llarp_time_t now, SNodeSessions& sessions,
+                                      SNodeConvoTags& tags)
     {
       auto itr = sessions.begin();
       while(itr != sessions.end())
       {
         if(itr->second.first->ShouldRemove() && itr->second.first->IsStopped())
         {
+          tags.erase(itr->second.second);
           itr = sessions.erase(itr);
           continue;
         }
@@ -111,17 +113,9 @@ namespace llarp
     void
     EndpointUtil::ExpireConvoSessions(llarp_time_t now, ConvoMap& sessions)
     {
-      auto itr = sessions.begin();
-      while(itr != sessions.end())
-      {
-        if(itr->second.IsExpired(now))
-        {
-          LogInfo("Expire session T=", itr->first);
-          itr = sessions.erase(itr);
-        }
-        else
-          ++itr;
-      }
+      sessions.Expire(now, [](const ConvoTag& tag) {
+        LogInfo("Expire session T=", tag);
+      });
     }
 
     void
@@ -162,20 +156,7 @@ namespace llarp
                                          const Address& info,
                                          std::set< ConvoTag >& tags)
     {
-      bool inserted = false;
-      auto itr      = sessions.begin();
-      while(itr != sessions.end())
-      {
-        if(itr->second.remote.Addr() == info)
-        {
-          if(tags.insert(itr->first).second)
-          {
-            inserted = true;
-          }
-        }
-        ++itr;
-      }
-      return inserted;
+      return sessions.GetTagsFor(info, tags);
     }
   }  // namespace service
 }  // namespace llarp
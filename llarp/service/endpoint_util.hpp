@@ -10,7 +10,8 @@ namespace llarp
     struct EndpointUtil
     {
       static void
-      ExpireSNodeSessions(llarp_time_t now, SNodeSessions& sessions);
+      ExpireSNodeSessions(llarp_time_t now, SNodeSessions& sessions,
+                          SNodeConvoTags& tags);
 
       static void
       ExpirePendingTx(llarp_time_t now, PendingLookups& lookups);
@@ -32,6 +32,13 @@ namespace llarp
       virtual void
       MarkConvoTagActive(const ConvoTag& tag) = 0;
 
+      /// remote takes frames authenticated with a mac on this convo tag
+      virtual void
+      MarkFrameMACFor(const ConvoTag& tag) = 0;
+
+      virtual bool
+      HasFrameMACFor(const ConvoTag& tag) const = 0;
+
       virtual void
       RemoveConvoTag(const ConvoTag& remote) = 0;
 
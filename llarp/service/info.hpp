@@ -40,6 +40,12 @@ namespace llarp
         return enckey;
       }
 
+      const PubKey&
+      SigningPublicKey() const
+      {
+        return signkey;
+      }
+
       bool
       Update(const byte_t* enc, const byte_t* sign,
              const OptNonce& nonce = OptNonce())
@@ -1,5 +1,6 @@
 #include <service/intro_set.hpp>
 
+#include <crypto/verify_cache.hpp>
 #include <path/path.hpp>
 
 namespace llarp
@@ -114,7 +115,7 @@ namespace llarp
     }
 
     bool
-    IntroSet::Verify(llarp_time_t now) const
+    IntroSet::VerifySignature(llarp_time_t now) const
     {
       std::array< byte_t, MAX_INTROSET_SIZE > tmp;
       llarp_buffer_t buf(tmp);
@@ -128,7 +129,13 @@ namespace llarp
       // rewind and resize buffer
       buf.sz  = buf.cur - buf.base;
       buf.cur = buf.base;
-      if(!A.Verify(buf, Z))
+      return VerifyCache::Default().Verify(A.SigningPublicKey(), buf, Z, now);
+    }
+
+    bool
+    IntroSet::Verify(llarp_time_t now) const
+    {
+      if(!VerifySignature(now))
       {
         return false;
       }
@@ -72,6 +72,10 @@ namespace llarp
 
       util::StatusObject
       ExtractStatus() const;
+
+     private:
+      bool
+      VerifySignature(llarp_time_t now) const;
     };
 
     inline bool
@@ -6,6 +6,8 @@
 #include <util/meta/memfn.hpp>
 #include <util/thread/logic.hpp>
 
+#include <sodium/utils.h>
+
 #include <utility>
 
 namespace llarp
@@ -94,8 +96,17 @@ namespace llarp
 
     ProtocolFrame::~ProtocolFrame() = default;
 
+    /// mixed into the session key for the mac key so the two never meet
+    static constexpr char FrameMACKeyTag[] = "lokinet-frame-mac";
+
     bool
     ProtocolFrame::BEncode(llarp_buffer_t* buf) const
+    {
+      return Encode(buf, Auth::Keep);
+    }
+
+    bool
+    ProtocolFrame::Encode(llarp_buffer_t* buf, Auth auth) const
     {
       if(!bencode_start_dict(buf))
         return false;
@@ -114,6 +125,11 @@ namespace llarp
       }
       if(!BEncodeWriteDictEntry("F", F, buf))
         return false;
+      if(auth == Auth::Keep && !M.IsZero())
+      {
+        if(!BEncodeWriteDictEntry("M", M, buf))
+          return false;
+      }
       if(!N.IsZero())
       {
         if(!BEncodeWriteDictEntry("N", N, buf))
@@ -131,8 +147,17 @@ namespace llarp
       }
       if(!BEncodeWriteDictInt("V", version, buf))
         return false;
-      if(!BEncodeWriteDictEntry("Z", Z, buf))
-        return false;
+      // a frame with a mac has no signature
+      if(auth == Auth::ZeroSignature)
+      {
+        if(!BEncodeWriteDictEntry("Z", Signature(), buf))
+          return false;
+      }
+      else if(auth == Auth::Keep && M.IsZero())
+      {
+        if(!BEncodeWriteDictEntry("Z", Z, buf))
+          return false;
+      }
       return bencode_end(buf);
     }
 
@@ -155,6 +180,8 @@ namespace llarp
         return false;
       if(!BEncodeMaybeReadDictEntry("C", C, read, key, val))
         return false;
+      if(!BEncodeMaybeReadDictEntry("M", M, read, key, val))
+        return false;
       if(!BEncodeMaybeReadDictEntry("N", N, read, key, val))
         return false;
       if(!BEncodeMaybeReadDictInt("S", S, read, key, val))
@@ -185,10 +212,11 @@ namespace llarp
     ProtocolFrame::Sign(const Identity& localIdent)
     {
       Z.Zero();
+      M.Zero();
       std::array< byte_t, MAX_PROTOCOL_MESSAGE_SIZE > tmp;
       llarp_buffer_t buf(tmp);
       // encode
-      if(!BEncode(&buf))
+      if(!Encode(&buf, Auth::ZeroSignature))
       {
         LogError("message too big to encode");
         return false;
@@ -201,9 +229,8 @@ namespace llarp
     }
 
     bool
-    ProtocolFrame::EncryptAndSign(const ProtocolMessage& msg,
-                                  const SharedSecret& sessionKey,
-                                  const Identity& localIdent)
+    ProtocolFrame::EncryptPayload(const ProtocolMessage& msg,
+                                  const SharedSecret& sessionKey)
     {
       std::array< byte_t, MAX_PROTOCOL_MESSAGE_SIZE > tmp;
       llarp_buffer_t buf(tmp);
@@ -220,21 +247,33 @@ namespace llarp
       CryptoManager::instance()->xchacha20(buf, sessionKey, N);
       // put encrypted buffer
       D = buf;
+      return true;
+    }
+
+    bool
+    ProtocolFrame::EncryptAndSign(const ProtocolMessage& msg,
+                                  const SharedSecret& sessionKey,
+                                  const Identity& localIdent)
+    {
+      if(!EncryptPayload(msg, sessionKey))
+        return false;
       // zero out signature
       Z.Zero();
-      llarp_buffer_t buf2(tmp);
+      M.Zero();
+      std::array< byte_t, MAX_PROTOCOL_MESSAGE_SIZE > tmp;
+      llarp_buffer_t buf(tmp);
       // encode frame
-      if(!BEncode(&buf2))
+      if(!Encode(&buf, Auth::ZeroSignature))
       {
         LogError("frame too big to encode");
-        DumpBuffer(buf2);
+        DumpBuffer(buf);
         return false;
       }
       // rewind
-      buf2.sz  = buf2.cur - buf2.base;
-      buf2.cur = buf2.base;
+      buf.sz  = buf.cur - buf.base;
+      buf.cur = buf.base;
       // sign
-      if(!localIdent.Sign(Z, buf2))
+      if(!localIdent.Sign(Z, buf))
       {
         LogError("failed to sign? wtf?!");
         return false;
@@ -242,6 +281,44 @@ namespace llarp
       return true;
     }
 
+    bool
+    ProtocolFrame::EncryptAndMAC(const ProtocolMessage& msg,
+                                 const SharedSecret& sessionKey)
+    {
+      if(!EncryptPayload(msg, sessionKey))
+        return false;
+      Z.Zero();
+      if(!ComputeMAC(M, sessionKey))
+      {
+        LogError("failed to compute frame mac");
+        return false;
+      }
+      return true;
+    }
+
+    bool
+    ProtocolFrame::ComputeMAC(ShortHash& mac,
+                              const SharedSecret& sessionKey) const
+    {
+      auto crypto = CryptoManager::instance();
+      SharedSecret macKey;
+      if(!crypto->hmac(macKey.data(),
+                       llarp_buffer_t(FrameMACKeyTag, sizeof(FrameMACKeyTag)),
+                       sessionKey))
+        return false;
+      std::array< byte_t, MAX_PROTOCOL_MESSAGE_SIZE > tmp;
+      llarp_buffer_t buf(tmp);
+      if(!Encode(&buf, Auth::None))
+      {
+        LogError("frame too big to encode");
+        return false;
+      }
+      // rewind
+      buf.sz  = buf.cur - buf.base;
+      buf.cur = buf.base;
+      return crypto->hmac(mac.data(), buf, macKey);
+    }
+
     struct AsyncFrameDecrypt
     {
       path::Path_ptr path;
@@ -357,6 +434,7 @@ namespace llarp
       F       = other.F;
       N       = other.N;
       Z       = other.Z;
+      M       = other.M;
       T       = other.T;
       R       = other.R;
       S       = other.S;
@@ -392,7 +470,15 @@ namespace llarp
         LogError("No sender for T=", T);
         return false;
       }
-      if(!Verify(si))
+      if(!M.IsZero())
+      {
+        if(!VerifyMAC(shared))
+        {
+          LogError("MAC failure from ", si.Addr());
+          return false;
+        }
+      }
+      else if(!Verify(si))
       {
         LogError("Signature failure from ", si.Addr());
         return false;
@@ -418,20 +504,17 @@ namespace llarp
     ProtocolFrame::operator==(const ProtocolFrame& other) const
     {
       return C == other.C && D == other.D && N == other.N && Z == other.Z
-          && T == other.T && S == other.S && version == other.version;
+          && M == other.M && T == other.T && S == other.S
+          && version == other.version;
     }
 
     bool
     ProtocolFrame::Verify(const ServiceInfo& svc) const
     {
-      ProtocolFrame copy(*this);
-      // save signature
-      // zero out signature for verify
-      copy.Z.Zero();
-      // serialize
+      // serialize with the signature zeroed out
       std::array< byte_t, MAX_PROTOCOL_MESSAGE_SIZE > tmp;
       llarp_buffer_t buf(tmp);
-      if(!copy.BEncode(&buf))
+      if(!Encode(&buf, Auth::ZeroSignature))
       {
         LogError("bencode fail");
         return false;
@@ -444,6 +527,15 @@ namespace llarp
       return svc.Verify(buf, Z);
     }
 
+    bool
+    ProtocolFrame::VerifyMAC(const SharedSecret& sessionKey) const
+    {
+      ShortHash mac;
+      if(!ComputeMAC(mac, sessionKey))
+        return false;
+      return sodium_memcmp(mac.data(), M.data(), mac.size()) == 0;
+    }
+
     bool
     ProtocolFrame::HandleMessage(routing::IMessageHandler* h,
                                  ABSL_ATTRIBUTE_UNUSED AbstractRouter* r) const
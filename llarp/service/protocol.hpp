@@ -37,6 +37,10 @@ namespace llarp
     constexpr ProtocolType eProtocolTrafficV4 = 1UL;
     constexpr ProtocolType eProtocolTrafficV6 = 2UL;
 
+    /// inner message version from which the sender accepts frames on an
+    /// established convo tag authenticated with a mac instead of a signature
+    constexpr uint64_t eProtocolVersionFrameMAC = 1;
+
     /// inner message
     struct ProtocolMessage
     {
@@ -51,7 +55,7 @@ namespace llarp
       IDataHandler* handler = nullptr;
       ConvoTag tag;
       uint64_t seqno   = 0;
-      uint64_t version = LLARP_PROTO_VERSION;
+      uint64_t version = eProtocolVersionFrameMAC;
 
       bool
       DecodeKey(const llarp_buffer_t& key, llarp_buffer_t* val);
@@ -82,6 +86,9 @@ namespace llarp
       uint64_t R;
       KeyExchangeNonce N;
       Signature Z;
+      /// keyed hash of the frame under the session key, set instead of Z on
+      /// established convo tags once the remote said it takes it
+      ShortHash M;
       PathID_t F;
       service::ConvoTag T;
 
@@ -92,6 +99,7 @@ namespace llarp
           , R(other.R)
           , N(other.N)
           , Z(other.Z)
+          , M(other.M)
           , F(other.F)
           , T(other.T)
       {
@@ -122,6 +130,11 @@ namespace llarp
       EncryptAndSign(const ProtocolMessage& msg, const SharedSecret& sharedkey,
                      const Identity& localIdent);
 
+      /// encrypt and authenticate with a mac under the session key, only
+      /// for convo tags where the remote sent eProtocolVersionFrameMAC
+      bool
+      EncryptAndMAC(const ProtocolMessage& msg, const SharedSecret& sessionKey);
+
       bool
       Sign(const Identity& localIdent);
 
@@ -156,6 +169,7 @@ namespace llarp
         T.Zero();
         N.Zero();
         Z.Zero();
+        M.Zero();
         R       = 0;
         version = LLARP_PROTO_VERSION;
       }
@@ -163,9 +177,35 @@ namespace llarp
       bool
       Verify(const ServiceInfo& from) const;
 
+      bool
+      VerifyMAC(const SharedSecret& sessionKey) const;
+
       bool
       HandleMessage(routing::IMessageHandler* h,
                     AbstractRouter* r) const override;
+
+     private:
+      /// what goes in the auth fields when encoding
+      enum class Auth
+      {
+        /// as they are
+        Keep,
+        /// a zero signature, what Z is over
+        ZeroSignature,
+        /// neither, what M is over
+        None
+      };
+
+      bool
+      Encode(llarp_buffer_t* buf, Auth auth) const;
+
+      /// encode msg and encrypt it into D
+      bool
+      EncryptPayload(const ProtocolMessage& msg, const SharedSecret& sessionKey);
+
+      /// compute the mac of this frame without M and Z
+      bool
+      ComputeMAC(ShortHash& mac, const SharedSecret& sessionKey) const;
     };
   }  // namespace service
 }  // namespace llarp
@@ -85,7 +85,11 @@ namespace llarp
       m.sender     = m_Endpoint->GetIdentity().pub;
       m.tag        = f.T;
       m.PutBuffer(payload);
-      if(!f.EncryptAndSign(m, shared, m_Endpoint->GetIdentity()))
+      // only the handshake needs a signature once the remote takes macs
+      const bool sealed = m_DataHandler->HasFrameMACFor(f.T)
+          ? f.EncryptAndMAC(m, shared)
+          : f.EncryptAndSign(m, shared, m_Endpoint->GetIdentity());
+      if(!sealed)
       {
         LogError(m_Endpoint->Name(), " failed to sign message");
         return;
@@ -1,5 +1,7 @@
 #include <service/session.hpp>
 
+#include <algorithm>
+
 namespace llarp
 {
   namespace service
@@ -11,6 +13,7 @@ namespace llarp
                              {"replyIntro", replyIntro.ExtractStatus()},
                              {"remote", remote.Addr().ToString()},
                              {"seqno", seqno},
+                             {"frameMAC", frameMAC},
                              {"intro", intro.ExtractStatus()}};
       return obj;
     }
@@ -22,5 +25,12 @@ namespace llarp
           && (now - lastUsed > lifetime || intro.IsExpired(now));
     }
 
+    llarp_time_t
+    Session::ExpiresAt(llarp_time_t lifetime) const
+    {
+      const llarp_time_t idle = lastUsed + lifetime + 1;
+      return std::min(idle, std::max(intro.expiresAt, lastUsed + 1));
+    }
+
   }  // namespace service
 }  // namespace llarp
@@ -25,6 +25,8 @@ namespace llarp
       llarp_time_t lastUsed = 0;
       uint64_t seqno        = 0;
       bool inbound          = false;
+      /// remote takes frames with a mac instead of a signature
+      bool frameMAC = false;
 
       util::StatusObject
       ExtractStatus() const;
@@ -32,6 +34,10 @@ namespace llarp
       bool
       IsExpired(llarp_time_t now,
                 llarp_time_t lifetime = (path::default_lifetime * 2)) const;
+
+      /// the first time IsExpired is true for
+      llarp_time_t
+      ExpiresAt(llarp_time_t lifetime = (path::default_lifetime * 2)) const;
     };
 
   }  // namespace service
@@ -8,9 +8,12 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cmath>
 #include <functional>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <utility>
 
 namespace llarp
@@ -32,6 +35,10 @@ namespace llarp
                llarp_time_t initialIntervalMs = 100, size_t MaxSize = 1024 >
     struct CoDelQueue
     {
+      /// safe to push into from more than one thread at once
+      static constexpr bool MultiProducer =
+          !std::is_same< Mutex_t, NullMutex >::value;
+
       CoDelQueue(std::string name, PutTime put, GetNow now)
           : m_QueueIdx(0)
           , m_name(std::move(name))
@@ -158,8 +165,277 @@ namespace llarp
       GetTime _getTime;
       PutTime _putTime;
       GetNow _getNow;
-    };  // namespace util
-  }     // namespace util
+    };
+
+    /// codel queue for packets pushed from a few threads and drained by one.
+    ///
+    /// every producer thread gets a shard of its own holding two single
+    /// producer single consumer rings of buffer handles, one of queued
+    /// items and one of spare buffers the consumer hands back, so neither
+    /// side takes a lock. buffers are allocated the first time a shard needs
+    /// them and recycled after, a quiet queue holds next to nothing.
+    ///
+    /// a thread keeps the shard it first pushed from, threads past the first
+    /// Shards - 1 share the last shard under a lock.
+    ///
+    /// the single consumer runs codel on every item it takes out: once items
+    /// have waited longer than dropMs for a whole interval it drops one and
+    /// shortens the interval by the square root of the drops in a row.
+    template < typename T, typename GetTime, typename PutTime, typename GetNow,
+               llarp_time_t dropMs = 5, llarp_time_t initialIntervalMs = 100,
+               size_t ShardSize = 1024, size_t Shards = 4 >
+    struct CoDelRing
+    {
+      static_assert(Shards > 1, "need a shard to share");
+
+      static constexpr bool MultiProducer = true;
+
+      CoDelRing(std::string name, PutTime put, GetNow now)
+          : m_name(std::move(name))
+          , _putTime(std::move(put))
+          , _getNow(std::move(now))
+      {
+      }
+
+      ~CoDelRing()
+      {
+        for(auto& shard : m_Shards)
+        {
+          while(T* t = shard.queued.Pop())
+          {
+            t->~T();
+            delete reinterpret_cast< Storage* >(t);
+          }
+          while(T* t = shard.spare.Pop())
+            delete reinterpret_cast< Storage* >(t);
+          delete reinterpret_cast< Storage* >(shard.unused);
+        }
+      }
+
+      CoDelRing(const CoDelRing&) = delete;
+
+      CoDelRing&
+      operator=(const CoDelRing&) = delete;
+
+      /// items queued right now, racy if called off the consumer thread
+      size_t
+      Size() const
+      {
+        size_t sz = 0;
+        for(const auto& shard : m_Shards)
+          sz += shard.queued.Size();
+        return sz;
+      }
+
+      /// items dropped by codel so far, consumer thread only
+      uint64_t
+      Dropped() const
+      {
+        return m_Dropped;
+      }
+
+      template < typename... Args >
+      bool
+      EmplaceIf(std::function< bool(T&) > pred, Args&&... args)
+          LOCKS_EXCLUDED(m_SharedAccess)
+      {
+        Shard& shard = ProducerShard();
+        if(&shard != &m_Shards.back())
+          return Put(shard, pred, std::forward< Args >(args)...);
+        Lock lock(&m_SharedAccess);
+        return Put(shard, pred, std::forward< Args >(args)...);
+      }
+
+      template < typename... Args >
+      void
+      Emplace(Args&&... args)
+      {
+        EmplaceIf([](T&) -> bool { return true; },
+                  std::forward< Args >(args)...);
+      }
+
+      /// visit what is queued now, dropping what codel says to, consumer
+      /// thread only
+      template < typename Visit >
+      void
+      Process(Visit visitor)
+      {
+        const llarp_time_t now = _getNow();
+        for(auto& shard : m_Shards)
+        {
+          // leave what comes in meanwhile to the next call
+          for(size_t num = shard.queued.Size(); num > 0; --num)
+          {
+            T* item = shard.queued.Pop();
+            const llarp_time_t put = _getTime(*item);
+            if(ShouldDrop(now, now > put ? now - put : 0))
+            {
+              ++m_Dropped;
+              llarp::LogDebug(m_name, " dropped item, ", m_Count, " in a row");
+            }
+            else
+              visitor(*item);
+            item->~T();
+            shard.spare.Push(item);
+          }
+        }
+      }
+
+     private:
+      using Storage =
+          typename std::aligned_storage< sizeof(T), alignof(T) >::type;
+
+      /// fixed size single producer single consumer ring of handles
+      struct Ring
+      {
+        std::array< T*, ShardSize > slots;
+        std::atomic< size_t > head{0};
+        std::atomic< size_t > tail{0};
+
+        size_t
+        Size() const
+        {
+          return tail.load(std::memory_order_acquire)
+              - head.load(std::memory_order_acquire);
+        }
+
+        /// producer side
+        void
+        Push(T* t)
+        {
+          const size_t idx = tail.load(std::memory_order_relaxed);
+          slots[idx % ShardSize] = t;
+          tail.store(idx + 1, std::memory_order_release);
+        }
+
+        /// consumer side, nullptr when empty
+        T*
+        Pop()
+        {
+          const size_t idx = head.load(std::memory_order_relaxed);
+          if(idx == tail.load(std::memory_order_acquire))
+            return nullptr;
+          T* t = slots[idx % ShardSize];
+          head.store(idx + 1, std::memory_order_release);
+          return t;
+        }
+      };
+
+      struct Shard
+      {
+        std::atomic< std::thread::id > owner{std::thread::id()};
+        /// producer to consumer
+        Ring queued;
+        /// consumer to producer, never holds more than allocated so it
+        /// cannot overflow
+        Ring spare;
+        /// producer only
+        size_t allocated = 0;
+        /// producer only, a buffer the predicate turned down
+        T* unused = nullptr;
+      };
+
+      Shard&
+      ProducerShard()
+      {
+        const auto self = std::this_thread::get_id();
+        for(size_t idx = 0; idx + 1 < Shards; ++idx)
+        {
+          auto owner = m_Shards[idx].owner.load(std::memory_order_acquire);
+          if(owner == self)
+            return m_Shards[idx];
+          if(owner == std::thread::id()
+             && m_Shards[idx].owner.compare_exchange_strong(owner, self))
+            return m_Shards[idx];
+        }
+        return m_Shards.back();
+      }
+
+      template < typename... Args >
+      bool
+      Put(Shard& shard, const std::function< bool(T&) >& pred, Args&&... args)
+      {
+        T* buf = shard.unused;
+        shard.unused = nullptr;
+        if(buf == nullptr)
+          buf = shard.spare.Pop();
+        if(buf == nullptr)
+        {
+          // every buffer we made is queued, the shard is full
+          if(shard.allocated == ShardSize)
+            return false;
+          buf = reinterpret_cast< T* >(new Storage);
+          ++shard.allocated;
+        }
+        T* t = new(buf) T(std::forward< Args >(args)...);
+        if(!pred(*t))
+        {
+          t->~T();
+          shard.unused = buf;
+          return false;
+        }
+        _putTime(*t);
+        shard.queued.Push(t);
+        return true;
+      }
+
+      llarp_time_t
+      ControlLaw(llarp_time_t t) const
+      {
+        return t + initialIntervalMs / std::sqrt(m_Count);
+      }
+
+      /// codel's dequeue decision for an item that waited sojourn ms
+      bool
+      ShouldDrop(llarp_time_t now, llarp_time_t sojourn)
+      {
+        if(sojourn < dropMs)
+        {
+          m_FirstAbove = 0;
+          m_Dropping   = false;
+          return false;
+        }
+        if(m_FirstAbove == 0)
+        {
+          m_FirstAbove = now + initialIntervalMs;
+          return false;
+        }
+        if(now < m_FirstAbove)
+          return false;
+        if(!m_Dropping)
+        {
+          m_Dropping = true;
+          // carry on from where we left off if we stopped dropping recently
+          if(m_Count > 2 && now < m_DropNext + 8 * initialIntervalMs)
+            m_Count -= 2;
+          else
+            m_Count = 1;
+          m_DropNext = ControlLaw(now);
+          return true;
+        }
+        if(now < m_DropNext)
+          return false;
+        ++m_Count;
+        m_DropNext = ControlLaw(m_DropNext);
+        return true;
+      }
+
+      std::array< Shard, Shards > m_Shards;
+      util::Mutex m_SharedAccess;  // serializes pushes to the last shard
+
+      /// codel state, consumer only
+      llarp_time_t m_FirstAbove = 0;
+      llarp_time_t m_DropNext   = 0;
+      size_t m_Count            = 0;
+      bool m_Dropping           = false;
+      uint64_t m_Dropped        = 0;
+
+      std::string m_name;
+      GetTime _getTime;
+      PutTime _putTime;
+      GetNow _getNow;
+    };
+  }  // namespace util
 }  // namespace llarp
 
 #endif
@@ -1,6 +1,7 @@
 #include <util/logging/file_logger.hpp>
 #include <util/logging/logger_internal.hpp>
 
+#include <memory>
 #include <utility>
 
 namespace llarp
@@ -8,7 +9,7 @@ namespace llarp
   namespace
   {
     static void
-    Flush(std::deque< std::string > lines, FILE *const f)
+    Flush(const std::deque< std::string > &lines, FILE *const f)
     {
       for(const auto &line : lines)
         fprintf(f, "%s\n", line.c_str());
@@ -68,9 +69,9 @@ namespace llarp
   FileLogStream::FlushLinesToDisk(llarp_time_t now)
   {
     FILE *const f = m_File;
-    std::deque< std::string > lines(m_Lines);
-    m_Disk->addJob([=]() { Flush(lines, f); });
-    m_Lines.clear();
+    auto lines    = std::make_shared< std::deque< std::string > >();
+    std::swap(*lines, m_Lines);
+    m_Disk->addJob([lines, f]() { Flush(*lines, f); });
     m_LastFlush = now;
   }
 }  // namespace llarp
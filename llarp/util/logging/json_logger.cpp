@@ -1,4 +1,5 @@
 #include <util/logging/json_logger.hpp>
+#include <util/logging/logger_internal.hpp>
 #include <util/json.hpp>
 
 namespace llarp
@@ -8,7 +9,7 @@ namespace llarp
                            const std::string& nodename, const std::string msg)
   {
     json::Object obj;
-    obj["time"]     = llarp::time_now_ms();
+    obj["time"]     = log_timestamp().now;
     obj["nickname"] = nodename;
     obj["file"]     = std::string(fname);
     obj["line"]     = lineno;
@@ -0,0 +1,184 @@
+#include <util/logging/log_writer.hpp>
+
+#include <util/time.hpp>
+
+#include <algorithm>
+#include <string>
+
+namespace llarp
+{
+  constexpr size_t LogWriter::RingSize;
+
+  /// how long the writer sleeps when there is nothing to print
+  static constexpr auto PollInterval = absl::Milliseconds(10);
+
+  static uint64_t
+  NextWriterID()
+  {
+    static std::atomic< uint64_t > next{0};
+    return ++next;
+  }
+
+  LogWriter::LogWriter() : m_ID(NextWriterID()), m_Running(false)
+  {
+  }
+
+  LogWriter::~LogWriter()
+  {
+    Stop();
+  }
+
+  void
+  LogWriter::Start(ILogStream* stream, std::string nodename)
+  {
+    if(m_Thread.joinable())
+      return;
+    m_Stream   = stream;
+    m_NodeName = std::move(nodename);
+    m_Running.store(true);
+    m_Thread = std::thread([this]() { Run(); });
+  }
+
+  void
+  LogWriter::Stop()
+  {
+    if(!m_Thread.joinable())
+      return;
+    {
+      util::Lock lock(&m_WakeAccess);
+      m_Running.store(false);
+      m_Wake.Signal();
+    }
+    m_Thread.join();
+    // whatever came in while we were stopping
+    PrintQueued();
+    ReportDropped();
+    m_Stream = nullptr;
+  }
+
+  void
+  LogWriter::Run()
+  {
+    util::SetThreadName("llarp-logger");
+    while(m_Running.load())
+    {
+      const size_t printed = PrintQueued();
+      ReportDropped();
+      m_Stream->Tick(time_now_ms());
+      if(printed == 0)
+      {
+        util::Lock lock(&m_WakeAccess);
+        if(m_Running.load())
+          m_Wake.WaitWithTimeout(&m_WakeAccess, PollInterval);
+      }
+    }
+  }
+
+  LogWriter::Ring&
+  LogWriter::ThreadRing()
+  {
+    struct Holder
+    {
+      uint64_t writer = 0;
+      Ring_ptr ring;
+
+      ~Holder()
+      {
+        if(ring)
+          ring->orphaned.store(true, std::memory_order_release);
+      }
+    };
+    static thread_local Holder holder;
+    if(holder.writer != m_ID)
+    {
+      if(holder.ring)
+        holder.ring->orphaned.store(true, std::memory_order_release);
+      holder.ring   = std::make_shared< Ring >();
+      holder.writer = m_ID;
+      util::Lock lock(&m_Access);
+      m_Rings.emplace_back(holder.ring);
+    }
+    return *holder.ring;
+  }
+
+  bool
+  LogWriter::Push(LogLevel lvl, const char* fname, int lineno,
+                  const std::string& msg)
+  {
+    Ring& ring        = ThreadRing();
+    const size_t tail = ring.tail.load(std::memory_order_relaxed);
+    if(tail - ring.head.load(std::memory_order_acquire) >= RingSize)
+    {
+      ring.dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    Record& rec = ring.records[tail % RingSize];
+    rec.lvl     = lvl;
+    rec.fname   = fname;
+    rec.lineno  = lineno;
+    rec.origin  = {std::this_thread::get_id(), time_now_ms()};
+    // slots keep their capacity so this stops allocating once warmed up
+    rec.msg.assign(msg);
+    ring.tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t
+  LogWriter::PrintQueued()
+  {
+    // print without holding the lock so new threads can add their rings
+    {
+      util::Lock lock(&m_Access);
+      m_Printing = m_Rings;
+    }
+    size_t printed = 0;
+    for(const auto& ptr : m_Printing)
+    {
+      Ring& ring        = *ptr;
+      const bool gone   = ring.orphaned.load(std::memory_order_acquire);
+      size_t head       = ring.head.load(std::memory_order_relaxed);
+      const size_t tail = ring.tail.load(std::memory_order_acquire);
+      for(; head != tail; ++head)
+      {
+        const Record& rec  = ring.records[head % RingSize];
+        CurrentLogOrigin() = &rec.origin;
+        m_Stream->AppendLog(rec.lvl, rec.fname, rec.lineno, m_NodeName,
+                            rec.msg);
+        ++printed;
+      }
+      CurrentLogOrigin() = nullptr;
+      ring.head.store(head, std::memory_order_release);
+      // the owner pushed its last line before it marked the ring
+      if(gone)
+      {
+        util::Lock lock(&m_Access);
+        m_DroppedFreed += ring.dropped.load(std::memory_order_relaxed);
+        m_Rings.erase(std::find(m_Rings.begin(), m_Rings.end(), ptr));
+      }
+    }
+    m_Printing.clear();
+    return printed;
+  }
+
+  uint64_t
+  LogWriter::Dropped() const
+  {
+    util::Lock lock(&m_Access);
+    uint64_t dropped = m_DroppedFreed;
+    for(const auto& ring : m_Rings)
+      dropped += ring->dropped.load(std::memory_order_relaxed);
+    return dropped;
+  }
+
+  void
+  LogWriter::ReportDropped()
+  {
+    const uint64_t dropped = Dropped();
+    if(dropped == m_Reported)
+      return;
+    m_Stream->AppendLog(eLogWarn, "logger", __LINE__, m_NodeName,
+                        "dropped " + std::to_string(dropped - m_Reported)
+                            + " log lines, logging too fast");
+    m_Reported = dropped;
+  }
+}  // namespace llarp
@@ -0,0 +1,119 @@
+#ifndef LLARP_UTIL_LOG_WRITER_HPP
+#define LLARP_UTIL_LOG_WRITER_HPP
+
+#include <util/logging/logger_internal.hpp>
+#include <util/logging/logstream.hpp>
+#include <util/thread/threading.hpp>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace llarp
+{
+  /// prints log lines on its own thread.
+  ///
+  /// every thread that logs gets a fixed size ring it alone pushes to, so
+  /// logging a line is a copy into a slot that already has the capacity and
+  /// a store. the writer thread drains the rings, does the expensive prefix
+  /// formatting (timestamps and such) and hands lines to the log stream.
+  /// a full ring drops the line and counts it rather than block the caller.
+  struct LogWriter
+  {
+    static constexpr size_t RingSize = 1024;
+
+    LogWriter();
+
+    ~LogWriter();
+
+    LogWriter(const LogWriter&) = delete;
+
+    LogWriter&
+    operator=(const LogWriter&) = delete;
+
+    /// start printing to stream on our thread, the stream must only be
+    /// touched by us until Stop
+    void
+    Start(ILogStream* stream, std::string nodename);
+
+    /// print what is queued and stop the thread
+    void
+    Stop();
+
+    bool
+    Running() const
+    {
+      return m_Running.load(std::memory_order_relaxed);
+    }
+
+    /// queue a line, returns false if it was dropped, any thread
+    bool
+    Push(LogLevel lvl, const char* fname, int lineno, const std::string& msg);
+
+    /// lines dropped so far because a ring was full
+    uint64_t
+    Dropped() const LOCKS_EXCLUDED(m_Access);
+
+   private:
+    struct Record
+    {
+      LogLevel lvl;
+      const char* fname;
+      int lineno;
+      LogOrigin origin;
+      std::string msg;
+    };
+
+    struct Ring
+    {
+      std::array< Record, RingSize > records;
+      /// next record to print, writer only stores
+      std::atomic< size_t > head{0};
+      /// next record to fill, owning thread only stores
+      std::atomic< size_t > tail{0};
+      std::atomic< uint64_t > dropped{0};
+      /// the owning thread is gone, free once drained
+      std::atomic< bool > orphaned{false};
+    };
+
+    using Ring_ptr = std::shared_ptr< Ring >;
+
+    /// this thread's ring, made on first use
+    Ring&
+    ThreadRing() LOCKS_EXCLUDED(m_Access);
+
+    /// print what is in the rings, returns lines printed
+    size_t
+    PrintQueued() LOCKS_EXCLUDED(m_Access);
+
+    /// print how many lines were dropped since we last said so
+    void
+    ReportDropped();
+
+    void
+    Run();
+
+    /// tells the rings of different writers apart
+    const uint64_t m_ID;
+    ILogStream* m_Stream = nullptr;
+    std::string m_NodeName;
+    std::thread m_Thread;
+    std::atomic< bool > m_Running;
+    uint64_t m_Reported = 0;
+    /// the rings being printed, writer thread only
+    std::vector< Ring_ptr > m_Printing;
+
+    util::Mutex m_WakeAccess;
+    util::Condition m_Wake;
+
+    mutable util::Mutex m_Access;  // protects m_Rings, m_DroppedFreed
+    std::vector< Ring_ptr > m_Rings GUARDED_BY(m_Access);
+    /// drops counted by rings we freed
+    uint64_t m_DroppedFreed GUARDED_BY(m_Access) = 0;
+  };
+}  // namespace llarp
+
+#endif
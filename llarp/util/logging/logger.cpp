@@ -1,5 +1,6 @@
 #include <util/logging/logger.hpp>
 #include <util/logging/logger.h>
+#include <util/logging/log_writer.hpp>
 #include <util/logging/ostream_logger.hpp>
 #if defined(_WIN32)
 #include <util/logging/win32_logger.hpp>
@@ -26,9 +27,126 @@ namespace llarp
   LogContext::LogContext()
       : logStream(std::make_unique< Stream_t >(_LOGSTREAM_INIT))
       , started(llarp::time_now_ms())
+      , m_Writer(std::make_unique< LogWriter >())
   {
   }
 
+  LogContext::~LogContext() = default;
+
+  void
+  LogContext::StartWriter()
+  {
+    m_Writer->Start(logStream.get(), nodeName);
+  }
+
+  void
+  LogContext::StopWriter()
+  {
+    m_Writer->Stop();
+  }
+
+  uint64_t
+  LogContext::DroppedLines() const
+  {
+    return m_Writer->Dropped();
+  }
+
+  void
+  LogContext::Append(LogLevel lvl, const char* fname, int lineno,
+                     const std::string& msg)
+  {
+    if(m_Writer->Running())
+      m_Writer->Push(lvl, fname, lineno, msg);
+    else
+      logStream->AppendLog(lvl, fname, lineno, nodeName, msg);
+  }
+
+  void
+  LogContext::Tick(llarp_time_t now)
+  {
+    // the writer thread ticks the stream itself
+    if(!m_Writer->Running())
+      logStream->Tick(now);
+  }
+
+  namespace
+  {
+    /// appends to a string that keeps its capacity between lines
+    struct LineBuffer : public std::streambuf
+    {
+      std::string line;
+
+      int_type
+      overflow(int_type ch) override
+      {
+        if(ch != traits_type::eof())
+          line.push_back(traits_type::to_char_type(ch));
+        return ch;
+      }
+
+      std::streamsize
+      xsputn(const char* s, std::streamsize n) override
+      {
+        line.append(s, n);
+        return n;
+      }
+    };
+
+    /// lines being built on this thread
+    thread_local size_t t_LineDepth = 0;
+  }  // namespace
+
+  struct LogLineStream
+  {
+    LineBuffer buf;
+    std::ostream out{&buf};
+  };
+
+  LogLineBuilder::LogLineBuilder()
+  {
+    static thread_local LogLineStream stream;
+    if(t_LineDepth++ == 0)
+    {
+      m_Stream = &stream;
+      m_Stream->buf.line.clear();
+      // undo whatever manipulators the last line left behind
+      m_Stream->out.clear();
+      m_Stream->out.flags(std::ios_base::skipws | std::ios_base::dec);
+      m_Stream->out.precision(6);
+      m_Stream->out.width(0);
+      m_Stream->out.fill(' ');
+    }
+    else
+    {
+      m_Nested = std::make_unique< LogLineStream >();
+      m_Stream = m_Nested.get();
+    }
+  }
+
+  LogLineBuilder::~LogLineBuilder()
+  {
+    --t_LineDepth;
+  }
+
+  std::ostream&
+  LogLineBuilder::Stream()
+  {
+    return m_Stream->out;
+  }
+
+  const std::string&
+  LogLineBuilder::Line() const
+  {
+    return m_Stream->buf.line;
+  }
+
+  const LogOrigin*&
+  CurrentLogOrigin()
+  {
+    static thread_local const LogOrigin* origin = nullptr;
+    return origin;
+  }
+
   LogContext&
   LogContext::Instance()
   {
@@ -42,8 +160,9 @@ namespace llarp
 
   log_timestamp::log_timestamp(const char* fmt)
       : format(fmt)
-      , now(llarp::time_now_ms())
-      , delta(llarp::time_now_ms() - LogContext::Instance().started)
+      , now(CurrentLogOrigin() ? CurrentLogOrigin()->when
+                               : llarp::time_now_ms())
+      , delta(now - LogContext::Instance().started)
   {
   }
 
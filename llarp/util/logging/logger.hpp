@@ -4,6 +4,12 @@
 #include <util/time.hpp>
 #include <util/logging/logstream.hpp>
 #include <util/logging/logger_internal.hpp>
+
+/// log calls below this level are compiled out, 0 keeps everything and 1
+/// drops LogDebug
+#ifndef LLARP_COMPILED_LOG_LEVEL
+#define LLARP_COMPILED_LOG_LEVEL 0
+#endif
 /*
 #ifdef _WIN32
 #define VC_EXTRALEAN
@@ -80,10 +86,14 @@ namespace llarp
   };
   */
 
+  struct LogWriter;
+
   struct LogContext
   {
     LogContext();
+    ~LogContext();
     LogLevel minLevel = eLogInfo;
+    /// not to be replaced while the writer thread runs
     ILogStream_ptr logStream;
     std::string nodeName = "lokinet";
 
@@ -91,23 +101,58 @@ namespace llarp
 
     static LogContext&
     Instance();
+
+    /// print log lines on a writer thread from now on instead of on the
+    /// thread logging them
+    void
+    StartWriter();
+
+    /// print what is queued and go back to printing lines where they are
+    /// logged
+    void
+    StopWriter();
+
+    /// lines the writer thread dropped because they came in too fast
+    uint64_t
+    DroppedLines() const;
+
+    /// print a formatted line or queue it for the writer thread
+    void
+    Append(LogLevel lvl, const char* fname, int lineno, const std::string& msg);
+
+    /// called every end of event loop tick
+    void
+    Tick(llarp_time_t now);
+
+   private:
+    std::unique_ptr< LogWriter > m_Writer;
   };
 
   void
   SetLogLevel(LogLevel lvl);
 
+  /** internal, carries the level in the type so it is known at compile
+   * time */
+  template < LogLevel lvl >
+  struct LogAt
+  {
+  };
+
   /** internal */
-  template < typename... TArgs >
+  template < LogLevel lvl, typename... TArgs >
   void
-  _Log(LogLevel lvl, const char* fname, int lineno, TArgs&&... args) noexcept
+  _Log(LogAt< lvl >, const char* fname, int lineno, TArgs&&... args) noexcept
   {
+    // a constant, calls under the compiled level fold away
+    if(int(lvl) < LLARP_COMPILED_LOG_LEVEL)
+      return;
     auto& log = LogContext::Instance();
     if(log.minLevel > lvl)
       return;
 
-    std::stringstream ss;
-    LogAppend(ss, std::forward< TArgs >(args)...);
-    log.logStream->AppendLog(lvl, fname, lineno, log.nodeName, ss.str());
+    LogLineBuilder line;
+    LogAppend(line.Stream(), std::forward< TArgs >(args)...);
+    log.Append(lvl, fname, lineno, line.Line());
   }
   /*
     std::stringstream ss;
@@ -236,14 +281,22 @@ namespace llarp
   */
 }  // namespace llarp
 
-#define LogDebug(...) _Log(llarp::eLogDebug, LOG_TAG, __LINE__, __VA_ARGS__)
-#define LogInfo(...) _Log(llarp::eLogInfo, LOG_TAG, __LINE__, __VA_ARGS__)
-#define LogWarn(...) _Log(llarp::eLogWarn, LOG_TAG, __LINE__, __VA_ARGS__)
-#define LogError(...) _Log(llarp::eLogError, LOG_TAG, __LINE__, __VA_ARGS__)
-#define LogDebugTag(tag, ...) _Log(llarp::eLogDebug, tag, __LINE__, __VA_ARGS__)
-#define LogInfoTag(tag, ...) _Log(llarp::eLogInfo, tag, __LINE__, __VA_ARGS__)
-#define LogWarnTag(tag, ...) _Log(llarp::eLogWarn, tag, __LINE__, __VA_ARGS__)
-#define LogErrorTag(tag, ...) _Log(llarp::eLogError, tag, __LINE__, __VA_ARGS__)
+#define LogDebug(...) \
+  _Log(llarp::LogAt< llarp::eLogDebug >(), LOG_TAG, __LINE__, __VA_ARGS__)
+#define LogInfo(...) \
+  _Log(llarp::LogAt< llarp::eLogInfo >(), LOG_TAG, __LINE__, __VA_ARGS__)
+#define LogWarn(...) \
+  _Log(llarp::LogAt< llarp::eLogWarn >(), LOG_TAG, __LINE__, __VA_ARGS__)
+#define LogError(...) \
+  _Log(llarp::LogAt< llarp::eLogError >(), LOG_TAG, __LINE__, __VA_ARGS__)
+#define LogDebugTag(tag, ...) \
+  _Log(llarp::LogAt< llarp::eLogDebug >(), tag, __LINE__, __VA_ARGS__)
+#define LogInfoTag(tag, ...) \
+  _Log(llarp::LogAt< llarp::eLogInfo >(), tag, __LINE__, __VA_ARGS__)
+#define LogWarnTag(tag, ...) \
+  _Log(llarp::LogAt< llarp::eLogWarn >(), tag, __LINE__, __VA_ARGS__)
+#define LogErrorTag(tag, ...) \
+  _Log(llarp::LogAt< llarp::eLogError >(), tag, __LINE__, __VA_ARGS__)
 
 #ifndef LOG_TAG
 #define LOG_TAG "default"
@@ -7,6 +7,7 @@
 #include <absl/time/time.h>
 #include <ctime>
 #include <iomanip>
+#include <memory>
 #include <sstream>
 #include <thread>
 
@@ -15,23 +16,67 @@ namespace llarp
   /** internal */
   template < typename TArg >
   void
-  LogAppend(std::stringstream& ss, TArg&& arg) noexcept
+  LogAppend(std::ostream& ss, TArg&& arg) noexcept
   {
     ss << std::forward< TArg >(arg);
   }
   /** internal */
   template < typename TArg, typename... TArgs >
   void
-  LogAppend(std::stringstream& ss, TArg&& arg, TArgs&&... args) noexcept
+  LogAppend(std::ostream& ss, TArg&& arg, TArgs&&... args) noexcept
   {
     LogAppend(ss, std::forward< TArg >(arg));
     LogAppend(ss, std::forward< TArgs >(args)...);
   }
 
+  struct LogLineStream;
+
+  /** internal, an emptied stream to format one log line into. the outermost
+   * line on a thread reuses a per thread buffer, a line logged from inside
+   * the operator<< of another one gets its own so it does not write into
+   * the line being built */
+  struct LogLineBuilder
+  {
+    LogLineBuilder();
+
+    ~LogLineBuilder();
+
+    LogLineBuilder(const LogLineBuilder&) = delete;
+
+    LogLineBuilder&
+    operator=(const LogLineBuilder&) = delete;
+
+    std::ostream&
+    Stream();
+
+    /// what was formatted so far
+    const std::string&
+    Line() const;
+
+   private:
+    std::unique_ptr< LogLineStream > m_Nested;
+    LogLineStream* m_Stream;
+  };
+
+  /// the thread and time a line was logged at
+  struct LogOrigin
+  {
+    std::thread::id thread;
+    llarp_time_t when;
+  };
+
+  /// set on a thread printing lines logged by other threads to the origin
+  /// of the line being printed, null when lines are printed where they are
+  /// logged
+  const LogOrigin*&
+  CurrentLogOrigin();
+
   inline std::string
   thread_id_string()
   {
     auto tid = std::this_thread::get_id();
+    if(const LogOrigin* origin = CurrentLogOrigin())
+      tid = origin->thread;
     std::hash< std::thread::id > h;
     uint16_t id = h(tid) % 1000;
 #if defined(ANDROID) || defined(RPI)
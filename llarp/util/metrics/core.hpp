@@ -6,6 +6,8 @@
 #include <util/thread/scheduler.hpp>
 #include <util/thread/threading.hpp>
 
+#include <array>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <utility>
@@ -48,6 +50,267 @@ namespace llarp
       return tags;
     }
 
+    /// Lock free accumulators for the interned tag sets of one collector.
+    /// Threads are spread over a fixed number of lazily made shards, each a
+    /// small open addressed table of records kept in relaxed atomics, so a
+    /// tick is a handful of uncontended atomic operations. A sample racing a
+    /// merge may land its count and its value in different publish periods.
+    /// A slot that saw no ticks for a whole publish period is handed back so
+    /// tag sets that come and go do not use up a shard.
+    template < typename Type >
+    class CollectorShards
+    {
+     public:
+      static constexpr size_t NUM_SHARDS = 8;
+      static constexpr size_t NUM_SLOTS  = 64;
+
+     private:
+      /// key of a slot being handed back, matches no tags
+      static constexpr uint32_t RELEASING = ~uint32_t(0);
+
+      struct Slot
+      {
+        /// interned tags + 1, 0 while the slot is free
+        std::atomic< uint32_t > key{0};
+        /// ticks in progress, a slot is only handed back while this is 0
+        std::atomic< uint32_t > users{0};
+        std::atomic< size_t > count{0};
+        std::atomic< Type > total{0};
+        std::atomic< Type > min{Record< Type >::DEFAULT_MIN()};
+        std::atomic< Type > max{Record< Type >::DEFAULT_MAX()};
+      };
+
+      using Shard = std::array< Slot, NUM_SLOTS >;
+
+      std::array< std::atomic< Shard * >, NUM_SHARDS > m_shards;
+
+      CollectorShards(const CollectorShards &) = delete;
+      CollectorShards &
+      operator=(const CollectorShards &) = delete;
+
+      static size_t
+      threadShard()
+      {
+        static std::atomic< size_t > next{0};
+        static thread_local size_t shard =
+            next.fetch_add(1, std::memory_order_relaxed) % NUM_SHARDS;
+        return shard;
+      }
+
+      Shard &
+      shard(size_t idx)
+      {
+        Shard *ptr = m_shards[idx].load(std::memory_order_acquire);
+        if(ptr)
+        {
+          return *ptr;
+        }
+        auto fresh = std::make_unique< Shard >();
+        if(m_shards[idx].compare_exchange_strong(ptr, fresh.get(),
+                                                 std::memory_order_acq_rel))
+        {
+          return *fresh.release();
+        }
+        return *ptr;
+      }
+
+      static Slot *
+      findOrAdd(Shard &shard, TagsId tags)
+      {
+        const uint32_t key = tags + 1;
+        size_t idx         = (key * 2654435761u) % NUM_SLOTS;
+        for(size_t n = 0; n < NUM_SLOTS; ++n, idx = (idx + 1) % NUM_SLOTS)
+        {
+          Slot &slot   = shard[idx];
+          uint32_t cur = slot.key.load(std::memory_order_relaxed);
+          if(cur == 0
+             && slot.key.compare_exchange_strong(cur, key,
+                                                 std::memory_order_relaxed))
+          {
+            return &slot;
+          }
+          // cur now holds whoever took the slot, maybe a thread with our tags
+          if(cur == key)
+          {
+            return &slot;
+          }
+        }
+        return nullptr;
+      }
+
+      static void
+      add(std::atomic< Type > &field, Type value)
+      {
+        Type cur = field.load(std::memory_order_relaxed);
+        while(!field.compare_exchange_weak(cur, cur + value,
+                                           std::memory_order_relaxed))
+        {
+        }
+      }
+
+      static void
+      lower(std::atomic< Type > &field, Type value)
+      {
+        Type cur = field.load(std::memory_order_relaxed);
+        while(value < cur
+              && !field.compare_exchange_weak(cur, value,
+                                              std::memory_order_relaxed))
+        {
+        }
+      }
+
+      static void
+      raise(std::atomic< Type > &field, Type value)
+      {
+        Type cur = field.load(std::memory_order_relaxed);
+        while(cur < value
+              && !field.compare_exchange_weak(cur, value,
+                                              std::memory_order_relaxed))
+        {
+        }
+      }
+
+      template < typename Func >
+      void
+      forEachSlot(Func func)
+      {
+        for(auto &ptr : m_shards)
+        {
+          Shard *shard = ptr.load(std::memory_order_acquire);
+          if(shard == nullptr)
+          {
+            continue;
+          }
+          for(Slot &slot : *shard)
+          {
+            const uint32_t key = slot.key.load(std::memory_order_relaxed);
+            if(key != 0 && key != RELEASING)
+            {
+              func(key - 1, slot);
+            }
+          }
+        }
+      }
+
+     public:
+      CollectorShards()
+      {
+        for(auto &ptr : m_shards)
+        {
+          ptr.store(nullptr, std::memory_order_relaxed);
+        }
+      }
+
+      ~CollectorShards()
+      {
+        for(auto &ptr : m_shards)
+        {
+          delete ptr.load(std::memory_order_relaxed);
+        }
+      }
+
+      /// Give the slot of `tags` back if nobody is ticking it, leaves it be
+      /// otherwise. Only called from merge, which is serialized by the
+      /// collector.
+      static void
+      release(TagsId tags, Slot &slot)
+      {
+        uint32_t key = tags + 1;
+        // seq_cst against tick: either it sees the slot going or we see it
+        if(!slot.key.compare_exchange_strong(key, RELEASING))
+        {
+          return;
+        }
+        // a tick may also have finished after merge took the count, keep
+        // the slot so the next merge takes that sample
+        if(slot.users.load() != 0 || slot.count.load() != 0)
+        {
+          slot.key.store(tags + 1);
+          return;
+        }
+        const auto order = std::memory_order_relaxed;
+        slot.total.store(0, order);
+        slot.min.store(Record< Type >::DEFAULT_MIN(), order);
+        slot.max.store(Record< Type >::DEFAULT_MAX(), order);
+        slot.key.store(0, std::memory_order_release);
+      }
+
+      /// Returns false if this thread's shard has no room for `tags`
+      bool
+      tick(TagsId tags, Type value)
+      {
+        Shard &own = shard(threadShard());
+        Slot *slot = nullptr;
+        while(true)
+        {
+          slot = findOrAdd(own, tags);
+          if(slot == nullptr)
+          {
+            return false;
+          }
+          slot->users.fetch_add(1);
+          if(slot->key.load() == tags + 1)
+          {
+            break;
+          }
+          // handed back under us, find or take another
+          slot->users.fetch_sub(1);
+        }
+        slot->count.fetch_add(1, std::memory_order_relaxed);
+        add(slot->total, value);
+        lower(slot->min, value);
+        raise(slot->max, value);
+        slot->users.fetch_sub(1, std::memory_order_release);
+        return true;
+      }
+
+      /// Add what the shards hold to `records`, emptying them if `clear`.
+      /// Clearing hands back slots that were not ticked since the last clear.
+      void
+      merge(TaggedRecords< Type > &records, bool clear)
+      {
+        const auto order = std::memory_order_relaxed;
+        forEachSlot([&](TagsId tags, Slot &slot) {
+          const size_t count =
+              clear ? slot.count.exchange(0, order) : slot.count.load(order);
+          if(count == 0)
+          {
+            if(clear)
+            {
+              release(tags, slot);
+            }
+            return;
+          }
+          const Type total =
+              clear ? slot.total.exchange(0, order) : slot.total.load(order);
+          const Type min = clear
+              ? slot.min.exchange(Record< Type >::DEFAULT_MIN(), order)
+              : slot.min.load(order);
+          const Type max = clear
+              ? slot.max.exchange(Record< Type >::DEFAULT_MAX(), order)
+              : slot.max.load(order);
+
+          Record< Type > &rec = records.data[TagTable::lookup(tags)];
+          rec.count() += count;
+          rec.total() += total;
+          rec.min() = std::min(rec.min(), min);
+          rec.max() = std::max(rec.max(), max);
+        });
+      }
+
+      void
+      clear()
+      {
+        const auto order = std::memory_order_relaxed;
+        forEachSlot([&](TagsId, Slot &slot) {
+          slot.count.store(0, order);
+          slot.total.store(0, order);
+          slot.min.store(Record< Type >::DEFAULT_MIN(), order);
+          slot.max.store(Record< Type >::DEFAULT_MAX(), order);
+        });
+      }
+    };
+
     template < typename Type >
     class Collector
     {
@@ -58,6 +321,7 @@ namespace llarp
      private:
       TaggedRecordsType m_records GUARDED_BY(m_mutex);
       mutable util::Mutex m_mutex;  // protects m_records
+      CollectorShards< Type > m_shards;
 
       Collector(const Collector &) = delete;
       Collector &
@@ -80,6 +344,7 @@ namespace llarp
       {
         absl::MutexLock l(&m_mutex);
         m_records.data.clear();
+        m_shards.clear();
       }
 
       TaggedRecordsType
@@ -88,6 +353,7 @@ namespace llarp
         absl::MutexLock l(&m_mutex);
         auto result = m_records;
         m_records.data.clear();
+        m_shards.merge(result, true);
 
         return result;
       }
@@ -96,7 +362,27 @@ namespace llarp
       load()
       {
         absl::MutexLock l(&m_mutex);
-        return m_records;
+        auto result = m_records;
+        m_shards.merge(result, false);
+
+        return result;
+      }
+
+      /// Tick with tags interned through the TagTable, without taking the
+      /// collector lock
+      void
+      tickInterned(Type value, TagsId tags)
+      {
+        if(!m_shards.tick(tags, value))
+        {
+          tick(value, TagTable::lookup(tags));
+        }
+      }
+
+      void
+      tick(Type value)
+      {
+        tickInterned(value, TagTable::UNTAGGED);
       }
 
       template < typename... Args >
@@ -128,6 +414,8 @@ namespace llarp
       set(size_t count, Type total, Type min, Type max, Args... args)
       {
         absl::MutexLock l(&m_mutex);
+        // fold in the shards so they cannot add to what we overwrite
+        m_shards.merge(m_records, true);
         RecordType &rec = fetch(args...);
         rec.count()     = count;
         rec.total()     = total;
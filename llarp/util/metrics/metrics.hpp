@@ -43,6 +43,24 @@ namespace llarp
         }
       }
     }
+
+    /// Tick with tags interned through the TagTable, skips building the tags
+    /// and the collector lock
+    inline void
+    integerTick(string_view category, string_view metric, int val,
+                TagsId tags)
+    {
+      if(DefaultManager::instance())
+      {
+        CollectorRepo< int >& repository =
+            DefaultManager::instance()->intCollectorRepo();
+        IntCollector* collector = repository.defaultCollector(category, metric);
+        if(collector->id().category()->enabled())
+        {
+          collector->tickInterned(val, tags);
+        }
+      }
+    }
   }  // namespace metrics
 }  // namespace llarp
 
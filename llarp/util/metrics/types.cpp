@@ -4,10 +4,74 @@
 
 #include <absl/strings/str_join.h>
 
+#include <cassert>
+#include <map>
+
 namespace llarp
 {
   namespace metrics
   {
+    namespace
+    {
+      struct TagTableData
+      {
+        util::Mutex m_mutex;
+        std::map< Tags, TagsId > m_ids GUARDED_BY(m_mutex);
+        /// keys of m_ids by id
+        std::vector< const Tags * > m_tags GUARDED_BY(m_mutex);
+
+        TagTableData()
+        {
+          util::Lock l(&m_mutex);
+          auto it = m_ids.emplace(Tags(), TagTable::UNTAGGED).first;
+          m_tags.push_back(&it->first);
+        }
+
+        static TagTableData &
+        instance()
+        {
+          static TagTableData data;
+          return data;
+        }
+      };
+    }  // namespace
+
+    constexpr TagsId TagTable::UNTAGGED;
+
+    TagsId
+    TagTable::intern(const Tags &tags)
+    {
+      auto &table = TagTableData::instance();
+      util::Lock l(&table.m_mutex);
+      auto it = table.m_ids.find(tags);
+      if(it != table.m_ids.end())
+      {
+        return it->second;
+      }
+
+      const auto id = static_cast< TagsId >(table.m_tags.size());
+      it            = table.m_ids.emplace(tags, id).first;
+      table.m_tags.push_back(&it->first);
+      return id;
+    }
+
+    Tags
+    TagTable::lookup(TagsId id)
+    {
+      auto &table = TagTableData::instance();
+      util::Lock l(&table.m_mutex);
+      assert(id < table.m_tags.size());
+      return *table.m_tags[id];
+    }
+
+    size_t
+    TagTable::size()
+    {
+      auto &table = TagTableData::instance();
+      util::Lock l(&table.m_mutex);
+      return table.m_tags.size();
+    }
+
     std::ostream &
     FormatSpec::format(std::ostream &stream, double data,
                        const FormatSpec &format)
@@ -475,6 +475,28 @@ namespace llarp
     using TagValue = absl::variant< std::string, double, std::int64_t >;
     using Tags     = std::set< std::pair< Tag, TagValue > >;
 
+    /// A tag set interned by the TagTable
+    using TagsId = uint32_t;
+
+    /// Interns tag sets to small integer ids, so hot paths can build their
+    /// tags once and tick with the id. Ids are process wide and never reused.
+    class TagTable
+    {
+     public:
+      /// id of the empty tag set
+      static constexpr TagsId UNTAGGED = 0;
+
+      static TagsId
+      intern(const Tags &tags);
+
+      static Tags
+      lookup(TagsId id);
+
+      /// number of tag sets interned so far
+      static size_t
+      size();
+    };
+
     template < typename Type >
     using TaggedRecordsData = absl::flat_hash_map< Tags, Record< Type > >;
 
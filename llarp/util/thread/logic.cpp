@@ -56,13 +56,9 @@ namespace llarp
   }
 
   bool
-  Logic::queue_func(std::function< void(void) > f)
+  Logic::queue_func(thread::Task func)
   {
-    if(!this->thread->QueueFunc(f))
-    {
-      // try calling it later if the job queue overflows
-      this->call_later(1, f);
-    }
+    this->thread->QueueTask(std::move(func));
     return true;
   }
 
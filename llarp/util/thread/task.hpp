@@ -0,0 +1,188 @@
+#ifndef LLARP_THREAD_TASK_HPP
+#define LLARP_THREAD_TASK_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace llarp
+{
+  namespace thread
+  {
+    /// a move only void() callable that keeps small functors inline instead
+    /// of allocating like std::function does for anything bigger than two
+    /// pointers. a task fills one cache line.
+    class Task
+    {
+     public:
+      static constexpr size_t InlineSize = 6 * sizeof(void*);
+
+      Task() noexcept = default;
+
+      template < typename Func,
+                 typename = typename std::enable_if< !std::is_same<
+                     typename std::decay< Func >::type, Task >::value >::type >
+      Task(Func&& func)
+      {
+        using F = typename std::decay< Func >::type;
+        Emplace< F >(std::forward< Func >(func));
+      }
+
+      Task(Task&& other) noexcept
+      {
+        MoveFrom(other);
+      }
+
+      Task&
+      operator=(Task&& other) noexcept
+      {
+        if(this != &other)
+        {
+          reset();
+          MoveFrom(other);
+        }
+        return *this;
+      }
+
+      Task(const Task&) = delete;
+
+      Task&
+      operator=(const Task&) = delete;
+
+      ~Task()
+      {
+        reset();
+      }
+
+      explicit operator bool() const
+      {
+        return m_Ops != nullptr;
+      }
+
+      void
+      operator()()
+      {
+        m_Ops->invoke(&m_Storage);
+      }
+
+      void
+      reset()
+      {
+        if(m_Ops)
+        {
+          m_Ops->destroy(&m_Storage);
+          m_Ops = nullptr;
+        }
+      }
+
+      /// true if a functor of type F is kept inline
+      template < typename F >
+      static constexpr bool
+      IsInline()
+      {
+        return sizeof(F) <= InlineSize
+            && alignof(F) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible< F >::value;
+      }
+
+     private:
+      struct Ops
+      {
+        void (*invoke)(void*);
+        /// move construct into dst and destroy src
+        void (*relocate)(void* src, void* dst);
+        void (*destroy)(void*);
+      };
+
+      template < typename F >
+      struct Inline
+      {
+        static void
+        Invoke(void* ptr)
+        {
+          (*static_cast< F* >(ptr))();
+        }
+
+        static void
+        Relocate(void* src, void* dst)
+        {
+          F* f = static_cast< F* >(src);
+          new(dst) F(std::move(*f));
+          f->~F();
+        }
+
+        static void
+        Destroy(void* ptr)
+        {
+          static_cast< F* >(ptr)->~F();
+        }
+
+        static constexpr Ops ops = {&Invoke, &Relocate, &Destroy};
+      };
+
+      template < typename F >
+      struct Heap
+      {
+        static void
+        Invoke(void* ptr)
+        {
+          (**static_cast< F** >(ptr))();
+        }
+
+        static void
+        Relocate(void* src, void* dst)
+        {
+          new(dst) F*(*static_cast< F** >(src));
+        }
+
+        static void
+        Destroy(void* ptr)
+        {
+          delete *static_cast< F** >(ptr);
+        }
+
+        static constexpr Ops ops = {&Invoke, &Relocate, &Destroy};
+      };
+
+      template < typename F, typename Func >
+      typename std::enable_if< IsInline< F >() >::type
+      Emplace(Func&& func)
+      {
+        new(&m_Storage) F(std::forward< Func >(func));
+        m_Ops = &Inline< F >::ops;
+      }
+
+      template < typename F, typename Func >
+      typename std::enable_if< !IsInline< F >() >::type
+      Emplace(Func&& func)
+      {
+        new(&m_Storage) F*(new F(std::forward< Func >(func)));
+        m_Ops = &Heap< F >::ops;
+      }
+
+      void
+      MoveFrom(Task& other) noexcept
+      {
+        if(other.m_Ops)
+        {
+          other.m_Ops->relocate(&other.m_Storage, &m_Storage);
+          m_Ops       = other.m_Ops;
+          other.m_Ops = nullptr;
+        }
+      }
+
+      const Ops* m_Ops = nullptr;
+      typename std::aligned_storage< InlineSize,
+                                     alignof(std::max_align_t) >::type m_Storage;
+    };
+
+    template < typename F >
+    constexpr Task::Ops Task::Inline< F >::ops;
+
+    template < typename F >
+    constexpr Task::Ops Task::Heap< F >::ops;
+  }  // namespace thread
+}  // namespace llarp
+
+#endif
@@ -0,0 +1,157 @@
+#include <util/thread/task_queue.hpp>
+
+namespace llarp
+{
+  namespace thread
+  {
+    constexpr size_t TaskQueue::SegmentSize;
+    constexpr size_t TaskQueue::Alignment;
+
+    TaskQueue::TaskQueue()
+    {
+      m_Head = Allocate();
+      m_Tail.store(m_Head);
+    }
+
+    TaskQueue::~TaskQueue()
+    {
+      Segment* seg = m_Head;
+      while(seg)
+      {
+        Segment* next = seg->next.load();
+        delete seg;
+        seg = next;
+      }
+      for(Segment* retired : m_Retired)
+        delete retired;
+      util::Lock lock(&m_FreeAccess);
+      for(Segment* free : m_Free)
+        delete free;
+    }
+
+    TaskQueue::Segment*
+    TaskQueue::Allocate()
+    {
+      {
+        util::Lock lock(&m_FreeAccess);
+        if(!m_Free.empty())
+        {
+          Segment* seg = m_Free.back();
+          m_Free.pop_back();
+          return seg;
+        }
+      }
+      ++m_Allocated;
+      return new Segment();
+    }
+
+    void
+    TaskQueue::Release(Segment* seg)
+    {
+      // users is left alone, a stale pusher may still bump it and back off
+      seg->claimed.store(0, std::memory_order_relaxed);
+      seg->next.store(nullptr, std::memory_order_relaxed);
+      util::Lock lock(&m_FreeAccess);
+      m_Free.push_back(seg);
+    }
+
+    void
+    TaskQueue::Push(Task task)
+    {
+      while(true)
+      {
+        Segment* seg = m_Tail.load(std::memory_order_acquire);
+        // announce ourselves before checking the segment is still the tail,
+        // pairs with the checks in Recycle so a segment is never reset
+        // under us
+        seg->users.fetch_add(1);
+        if(m_Tail.load() != seg)
+        {
+          seg->users.fetch_sub(1, std::memory_order_release);
+          continue;
+        }
+        const size_t idx = seg->claimed.fetch_add(1, std::memory_order_relaxed);
+        if(idx < SegmentSize)
+        {
+          Slot& slot = seg->slots[idx];
+          slot.task  = std::move(task);
+          slot.ready.store(true, std::memory_order_release);
+          seg->users.fetch_sub(1, std::memory_order_release);
+          return;
+        }
+        // full, link in a next segment if nobody beat us to it and move the
+        // tail along
+        Segment* next = seg->next.load(std::memory_order_acquire);
+        if(next == nullptr)
+        {
+          Segment* fresh = Allocate();
+          if(seg->next.compare_exchange_strong(next, fresh,
+                                               std::memory_order_acq_rel))
+            next = fresh;
+          else
+            Release(fresh);
+        }
+        Segment* expect = seg;
+        m_Tail.compare_exchange_strong(expect, next, std::memory_order_acq_rel);
+        seg->users.fetch_sub(1, std::memory_order_release);
+      }
+    }
+
+    size_t
+    TaskQueue::PopBatch(Task* out, size_t max)
+    {
+      size_t n = 0;
+      while(n < max)
+      {
+        if(m_HeadIdx == SegmentSize)
+        {
+          Segment* next = m_Head->next.load(std::memory_order_acquire);
+          if(next == nullptr)
+            break;
+          m_Retired.push_back(m_Head);
+          m_Head    = next;
+          m_HeadIdx = 0;
+        }
+        Slot& slot = m_Head->slots[m_HeadIdx];
+        // stop at a slot that is claimed but not filled yet to keep order
+        if(!slot.ready.load(std::memory_order_acquire))
+          break;
+        out[n++] = std::move(slot.task);
+        slot.ready.store(false, std::memory_order_relaxed);
+        ++m_HeadIdx;
+      }
+      if(!m_Retired.empty())
+        Recycle();
+      return n;
+    }
+
+    bool
+    TaskQueue::Empty() const
+    {
+      if(m_HeadIdx < SegmentSize)
+        return !m_Head->slots[m_HeadIdx].ready.load(std::memory_order_acquire);
+      const Segment* next = m_Head->next.load(std::memory_order_acquire);
+      return next == nullptr
+          || !next->slots[0].ready.load(std::memory_order_acquire);
+    }
+
+    void
+    TaskQueue::Recycle()
+    {
+      auto itr = m_Retired.begin();
+      while(itr != m_Retired.end())
+      {
+        Segment* seg = *itr;
+        // once the tail has moved on new pushers back off from seg, so no
+        // users left means nobody is touching it
+        if(m_Tail.load() != seg && seg->users.load() == 0)
+        {
+          Release(seg);
+          itr = m_Retired.erase(itr);
+        }
+        else
+          ++itr;
+      }
+    }
+  }  // namespace thread
+}  // namespace llarp
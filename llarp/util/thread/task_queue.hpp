@@ -0,0 +1,102 @@
+#ifndef LLARP_THREAD_TASK_QUEUE_HPP
+#define LLARP_THREAD_TASK_QUEUE_HPP
+
+#include <util/thread/task.hpp>
+#include <util/thread/threading.hpp>
+
+#include <atomic>
+#include <vector>
+
+namespace llarp
+{
+  namespace thread
+  {
+    /// an unbounded lock free queue of tasks, any number of threads push and
+    /// one thread pops.
+    ///
+    /// tasks live in fixed size segments linked head to tail. a push claims
+    /// a slot in the tail segment with one fetch_add, a pusher that finds it
+    /// full links in the next segment. segments the consumer is
+    /// done with go back to a free list once no pusher can still be looking
+    /// at them, so a busy queue stops allocating.
+    class TaskQueue
+    {
+     public:
+      static constexpr size_t SegmentSize = 256;
+      static constexpr size_t Alignment   = 64;
+
+      TaskQueue();
+
+      ~TaskQueue();
+
+      TaskQueue(const TaskQueue&) = delete;
+
+      TaskQueue&
+      operator=(const TaskQueue&) = delete;
+
+      /// never fails, any thread
+      void
+      Push(Task task);
+
+      /// move out up to max tasks in the order they were pushed, returns how
+      /// many, consumer thread only
+      size_t
+      PopBatch(Task* out, size_t max);
+
+      /// consumer thread only
+      bool
+      Empty() const;
+
+      /// segments allocated over our lifetime
+      size_t
+      SegmentsAllocated() const
+      {
+        return m_Allocated.load(std::memory_order_relaxed);
+      }
+
+     private:
+      struct Slot
+      {
+        Task task;
+        std::atomic< bool > ready{false};
+      };
+
+      struct Segment
+      {
+        /// slots handed out, may run past SegmentSize
+        std::atomic< size_t > claimed{0};
+        char claimedPadding[Alignment - sizeof(std::atomic< size_t >)];
+        /// pushers that loaded this segment as the tail and are not done
+        /// with it yet
+        std::atomic< size_t > users{0};
+        std::atomic< Segment* > next{nullptr};
+        Slot slots[SegmentSize];
+      };
+
+      Segment*
+      Allocate() LOCKS_EXCLUDED(m_FreeAccess);
+
+      void
+      Release(Segment* seg) LOCKS_EXCLUDED(m_FreeAccess);
+
+      /// hand back retired segments no pusher is using anymore
+      void
+      Recycle();
+
+      std::atomic< Segment* > m_Tail;
+      char m_TailPadding[Alignment - sizeof(std::atomic< Segment* >)];
+
+      /// consumer side
+      Segment* m_Head;
+      size_t m_HeadIdx = 0;
+      std::vector< Segment* > m_Retired;
+
+      std::atomic< size_t > m_Allocated{0};
+
+      util::Mutex m_FreeAccess;  // protects m_Free
+      std::vector< Segment* > m_Free GUARDED_BY(m_FreeAccess);
+    };
+  }  // namespace thread
+}  // namespace llarp
+
+#endif
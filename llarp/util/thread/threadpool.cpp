@@ -3,6 +3,7 @@
 #include <util/thread/threadpool.h>
 #include <util/thread/thread_pool.hpp>
 
+#include <array>
 #include <cstring>
 #include <functional>
 #include <queue>
@@ -42,8 +43,6 @@ llarp_threadpool_stop(struct llarp_threadpool *pool)
   llarp::LogDebug("threadpool stop");
   if(pool->impl)
     pool->impl->stop();
-  if(pool->jobs)
-    pool->jobs->disable();
 }
 
 void
@@ -77,27 +76,24 @@ llarp_threadpool_queue_job(struct llarp_threadpool *pool,
   else
   {
     // single threaded mode
-    while(pool->jobs->tryPushBack(func) != llarp::thread::QueueReturn::Success)
-    {
-      if(!pool->jobs->enabled())
-        return;
-      if(::getpid() == pool->callingPID)
-        llarp_threadpool_tick(pool);
-      else
-        std::this_thread::sleep_for(std::chrono::microseconds(1000));
-    }
+    pool->jobs->Push(std::move(func));
   }
 }
 
 void
 llarp_threadpool_tick(struct llarp_threadpool *pool)
 {
-  while(pool->size())
+  if(!pool->jobs)
+    return;
+  // take jobs a batch at a time until we find the queue empty
+  std::array< llarp::thread::Task, 64 > batch;
+  size_t n;
+  while((n = pool->jobs->PopBatch(batch.data(), batch.size())))
   {
-    auto job = pool->jobs->tryPopFront();
-    if(job)
+    for(size_t idx = 0; idx < n; ++idx)
     {
-      (*job)();
+      batch[idx]();
+      batch[idx].reset();
     }
   }
 }
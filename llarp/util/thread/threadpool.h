@@ -3,6 +3,7 @@
 
 #include <util/string_view.hpp>
 #include <util/thread/queue.hpp>
+#include <util/thread/task_queue.hpp>
 #include <util/thread/thread_pool.hpp>
 #include <util/thread/threading.hpp>
 
@@ -13,30 +14,18 @@
 struct llarp_threadpool
 {
   std::unique_ptr< llarp::thread::ThreadPool > impl;
-  std::unique_ptr< llarp::thread::Queue< std::function< void(void) > > > jobs;
-  const pid_t callingPID;
+  /// single process mode, never fills up
+  std::unique_ptr< llarp::thread::TaskQueue > jobs;
 
   llarp_threadpool(int workers, llarp::string_view name)
       : impl(std::make_unique< llarp::thread::ThreadPool >(workers,
                                                            workers * 128, name))
       , jobs(nullptr)
-      , callingPID(0)
   {
   }
 
-  llarp_threadpool()
-      : jobs(new llarp::thread::Queue< std::function< void() > >(128))
-      , callingPID(llarp::util::GetPid())
+  llarp_threadpool() : jobs(std::make_unique< llarp::thread::TaskQueue >())
   {
-    jobs->enable();
-  }
-
-  size_t
-  size() const
-  {
-    if(jobs)
-      return jobs->size();
-    return 0;
   }
 
   bool
@@ -45,7 +34,15 @@ struct llarp_threadpool
     if(impl)
       return impl->tryAddJob(f);
 
-    return jobs->tryPushBack(f) == llarp::thread::QueueReturn::Success;
+    jobs->Push(std::move(f));
+    return true;
+  }
+
+  /// single process mode only
+  void
+  QueueTask(llarp::thread::Task task)
+  {
+    jobs->Push(std::move(task));
   }
 };
 
@@ -2,71 +2,289 @@
 
 #include <util/time.hpp>
 
-#include <atomic>
-#include <condition_variable>
-#include <list>
+#include <absl/container/flat_hash_map.h>
+
+#include <array>
 #include <memory>
-#include <queue>
-#include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace llarp
 {
   struct timer
   {
-    void* user;
-    uint64_t called_at;
-    uint64_t started;
-    uint64_t timeout;
+    void* user         = nullptr;
+    uint64_t called_at = 0;
+    uint64_t started   = 0;
+    uint64_t timeout   = 0;
     llarp_timer_handler_func func;
     std::function< void(void) > deferredFunc;
-    bool done;
-    bool canceled;
-
-    timer(llarp_time_t now, uint64_t ms = 0, void* _user = nullptr,
-          llarp_timer_handler_func _func = nullptr)
-        : user(_user)
-        , called_at(0)
-        , started(now)
-        , timeout(ms)
-        , func(std::move(_func))
-        , done(false)
-        , canceled(false)
+    bool canceled = false;
+    uint32_t id   = 0;
+
+    /// intrusive links for the wheel slot or due list we sit in
+    timer* prev   = nullptr;
+    timer* next   = nullptr;
+    uint8_t level = 0;
+    uint8_t slot  = 0;
+
+    void
+    exec();
+
+    llarp_time_t
+    expiresAt() const
     {
+      return started + timeout;
     }
+  };
 
-    ~timer() = default;
+  /// hierarchical timing wheel with 1ms resolution, O(1) insert and remove
+  /// and a tick cost of O(expired) plus one step per 64ms that passed
+  struct TimerWheel
+  {
+    static constexpr size_t LevelBits     = 6;
+    static constexpr size_t SlotsPerLevel = size_t{1} << LevelBits;
+    static constexpr uint64_t SlotMask    = SlotsPerLevel - 1;
+    /// 6 levels of 64 slots cover about 2 years, anything further out
+    /// parks in the top level and is re-filed when it cascades
+    static constexpr size_t Levels = 6;
+    /// level number of the list holding timers due on the next tick
+    static constexpr uint8_t DueLevel = Levels;
+
+    explicit TimerWheel(llarp_time_t now) : m_Time(now)
+    {
+    }
 
+    /// file t by its expiry time
     void
-    exec();
+    Insert(timer* t)
+    {
+      const auto expires = t->expiresAt();
+      if(expires <= m_Time)
+      {
+        MakeDue(t);
+        return;
+      }
+      const uint64_t delta = expires - m_Time;
+      size_t level         = 0;
+      while(level + 1 < Levels && delta >= LevelSpan(level + 1))
+        ++level;
+      uint64_t slot;
+      if(level + 1 == Levels && delta >= LevelSpan(Levels))
+        slot = (m_Time >> (LevelBits * level)) + SlotMask;
+      else
+        slot = expires >> (LevelBits * level);
+      Link(t, level, slot & SlotMask);
+    }
+
+    /// take t out of whatever list it is in and fire it on the next tick
+    void
+    MakeDue(timer* t)
+    {
+      Unlink(t);
+      Link(t, DueLevel, 0);
+    }
+
+    void
+    Remove(timer* t)
+    {
+      Unlink(t);
+    }
+
+    /// move time forward to now and append every timer that expired or
+    /// was made due to hit, in expiry order
+    void
+    Advance(llarp_time_t now, std::vector< timer* >& hit)
+    {
+      if(now < m_Time)
+        Rebase(now);
+      while(m_Time < now)
+      {
+        if(m_Pending == 0)
+        {
+          m_Time = now;
+          break;
+        }
+        const llarp_time_t next = m_Time + 1;
+        if((next & SlotMask) == 0)
+        {
+          // entering a new level 0 block, pull timers down from the levels
+          // above whose slot starts here, highest first
+          m_Time = next;
+          for(size_t level = Levels - 1; level > 0; --level)
+          {
+            if((next & (LevelSpan(level) - 1)) == 0)
+              Cascade(level, (next >> (LevelBits * level)) & SlotMask);
+          }
+          Take(0, next & SlotMask, hit);
+          continue;
+        }
+        // skip straight to the next occupied slot in this block
+        const uint64_t ahead =
+            m_Occupied[0] & (~uint64_t{0} << ((m_Time & SlotMask) + 1));
+        const llarp_time_t target = ahead
+            ? (m_Time & ~SlotMask) + __builtin_ctzll(ahead)
+            : (m_Time | SlotMask);
+        if(target > now)
+        {
+          m_Time = now;
+          break;
+        }
+        m_Time = target;
+        if(ahead)
+          Take(0, target & SlotMask, hit);
+      }
+      while(m_Due)
+      {
+        hit.push_back(m_Due);
+        Unlink(m_Due);
+      }
+    }
+
+    /// the clock went backwards, re-file everything against now
+    void
+    Rebase(llarp_time_t now)
+    {
+      std::vector< timer* > pending;
+      pending.reserve(m_Pending);
+      for(size_t level = 0; level < Levels; ++level)
+      {
+        for(size_t slot = 0; slot < SlotsPerLevel; ++slot)
+        {
+          auto& head = m_Slots[level][slot];
+          while(head)
+          {
+            pending.push_back(head);
+            Unlink(head);
+          }
+        }
+      }
+      m_Time = now;
+      for(auto t : pending)
+        Insert(t);
+    }
+
+    llarp_time_t
+    Now() const
+    {
+      return m_Time;
+    }
+
+    void
+    Clear()
+    {
+      m_Slots    = {};
+      m_Occupied = {};
+      m_Due      = nullptr;
+      m_Pending  = 0;
+    }
+
+   private:
+    static constexpr uint64_t
+    LevelSpan(size_t level)
+    {
+      return uint64_t{1} << (LevelBits * level);
+    }
+
+    timer*&
+    Head(uint8_t level, uint8_t slot)
+    {
+      return level == DueLevel ? m_Due : m_Slots[level][slot];
+    }
+
+    void
+    Link(timer* t, uint8_t level, uint8_t slot)
+    {
+      auto& head = Head(level, slot);
+      t->level   = level;
+      t->slot    = slot;
+      t->prev    = nullptr;
+      t->next    = head;
+      if(head)
+        head->prev = t;
+      head = t;
+      if(level != DueLevel)
+      {
+        m_Occupied[level] |= uint64_t{1} << slot;
+        ++m_Pending;
+      }
+    }
 
-    static void
-    call(void* user)
+    void
+    Unlink(timer* t)
     {
-      static_cast< timer* >(user)->exec();
+      auto& head = Head(t->level, t->slot);
+      if(t->prev)
+        t->prev->next = t->next;
+      else if(head == t)
+        head = t->next;
+      else
+        return;  // not linked anywhere
+      if(t->next)
+        t->next->prev = t->prev;
+      t->prev = nullptr;
+      t->next = nullptr;
+      if(t->level != DueLevel)
+      {
+        --m_Pending;
+        if(head == nullptr)
+          m_Occupied[t->level] &= ~(uint64_t{1} << t->slot);
+      }
     }
 
-    bool
-    operator<(const timer& other) const
+    /// move every timer in a level 0 slot to hit
+    void
+    Take(size_t level, size_t slot, std::vector< timer* >& hit)
     {
-      return (started + timeout) < (other.started + other.timeout);
+      auto& head = m_Slots[level][slot];
+      while(head)
+      {
+        hit.push_back(head);
+        Unlink(head);
+      }
     }
+
+    /// re-file every timer in a higher level slot against the current time
+    void
+    Cascade(size_t level, size_t slot)
+    {
+      auto& head = m_Slots[level][slot];
+      while(head)
+      {
+        auto t = head;
+        Unlink(t);
+        Insert(t);
+      }
+    }
+
+    std::array< std::array< timer*, SlotsPerLevel >, Levels > m_Slots = {};
+    std::array< uint64_t, Levels > m_Occupied                         = {};
+    /// cancelled timers and timers that were already expired when filed
+    timer* m_Due = nullptr;
+    /// last time we advanced to, every timer due at or before it has fired
+    llarp_time_t m_Time;
+    /// number of timers in the wheel slots
+    size_t m_Pending = 0;
   };
 }  // namespace llarp
 
 struct llarp_timer_context
 {
+  /// most idle timer objects kept around for reuse
+  static constexpr size_t MaxIdleTimers = 4096;
+
   llarp::util::Mutex timersMutex;  // protects timers
-  std::unordered_map< uint32_t, std::unique_ptr< llarp::timer > > timers
+  absl::flat_hash_map< uint32_t, std::unique_ptr< llarp::timer > > timers
       GUARDED_BY(timersMutex);
-  std::priority_queue< std::unique_ptr< llarp::timer > > calling;
+  llarp::TimerWheel wheel GUARDED_BY(timersMutex);
+  std::vector< std::unique_ptr< llarp::timer > > idle GUARDED_BY(timersMutex);
   llarp::util::Mutex tickerMutex;
   std::unique_ptr< llarp::util::Condition > ticker;
   absl::Duration nextTickLen = absl::Milliseconds(100);
 
   llarp_time_t m_Now;
 
-  llarp_timer_context()
+  llarp_timer_context() : wheel(llarp::time_now_ms())
   {
     m_Now = llarp::time_now_ms();
   }
@@ -96,6 +314,7 @@ struct llarp_timer_context
     if(itr == timers.end())
       return;
     itr->second->canceled = true;
+    wheel.MakeDue(itr->second.get());
   }
 
   void
@@ -105,8 +324,10 @@ struct llarp_timer_context
     const auto& itr = timers.find(id);
     if(itr == timers.end())
       return;
-    itr->second->func     = nullptr;
-    itr->second->canceled = true;
+    itr->second->func         = nullptr;
+    itr->second->deferredFunc = nullptr;
+    itr->second->canceled     = true;
+    wheel.MakeDue(itr->second.get());
   }
 
   uint32_t
@@ -114,43 +335,112 @@ struct llarp_timer_context
       LOCKS_EXCLUDED(timersMutex)
   {
     llarp::util::Lock lock(&timersMutex);
-
-    const uint32_t id = ++currentId;
-    timers.emplace(
-        id, std::make_unique< llarp::timer >(m_Now, timeout_ms, user, func));
-    return id;
+    auto t  = make_timer(timeout_ms);
+    t->user = user;
+    t->func = std::move(func);
+    return add_timer(std::move(t));
   }
 
   uint32_t
   call_func_later(std::function< void(void) > func, llarp_time_t timeout)
+      LOCKS_EXCLUDED(timersMutex)
   {
     llarp::util::Lock lock(&timersMutex);
-
-    const uint32_t id = ++currentId;
-    timers.emplace(
-        id, std::make_unique< llarp::timer >(m_Now, timeout, nullptr, nullptr));
-    timers[id]->deferredFunc = func;
-    return id;
+    auto t          = make_timer(timeout);
+    t->deferredFunc = std::move(func);
+    return add_timer(std::move(t));
   }
 
   void
   cancel_all() LOCKS_EXCLUDED(timersMutex)
   {
-    std::list< uint32_t > ids;
+    llarp::util::Lock lock(&timersMutex);
+    for(auto& item : timers)
+    {
+      item.second->canceled = true;
+      wheel.MakeDue(item.second.get());
+    }
+  }
+
+  /// remove every timer without calling it
+  void
+  clear() LOCKS_EXCLUDED(timersMutex)
+  {
+    llarp::util::Lock lock(&timersMutex);
+    wheel.Clear();
+    timers.clear();
+    idle.clear();
+  }
 
+  /// advance the wheel to m_Now and take ownership of every timer to call
+  void
+  collect(std::vector< std::unique_ptr< llarp::timer > >& hit)
+      LOCKS_EXCLUDED(timersMutex)
+  {
+    std::vector< llarp::timer* > expired;
+    llarp::util::Lock lock(&timersMutex);
+    wheel.Advance(m_Now, expired);
+    hit.reserve(expired.size());
+    for(auto t : expired)
     {
-      llarp::util::Lock lock(&timersMutex);
+      auto itr = timers.find(t->id);
+      hit.emplace_back(std::move(itr->second));
+      timers.erase(itr);
+    }
+  }
 
-      for(auto& item : timers)
-      {
-        ids.push_back(item.first);
-      }
+  /// hand called timers back for reuse
+  void
+  recycle(std::vector< std::unique_ptr< llarp::timer > >& hit)
+      LOCKS_EXCLUDED(timersMutex)
+  {
+    llarp::util::Lock lock(&timersMutex);
+    for(auto& t : hit)
+    {
+      if(idle.size() >= MaxIdleTimers)
+        break;
+      t->func         = nullptr;
+      t->deferredFunc = nullptr;
+      idle.emplace_back(std::move(t));
     }
+    hit.clear();
+  }
 
-    for(auto id : ids)
+ private:
+  std::unique_ptr< llarp::timer >
+  make_timer(uint64_t timeout) EXCLUSIVE_LOCKS_REQUIRED(timersMutex)
+  {
+    std::unique_ptr< llarp::timer > t;
+    if(idle.empty())
+      t = std::make_unique< llarp::timer >();
+    else
     {
-      cancel(id);
+      t = std::move(idle.back());
+      idle.pop_back();
     }
+    t->user      = nullptr;
+    t->called_at = 0;
+    t->started   = m_Now;
+    t->timeout   = timeout;
+    t->canceled  = false;
+    return t;
+  }
+
+  uint32_t
+  add_timer(std::unique_ptr< llarp::timer > t)
+      EXCLUSIVE_LOCKS_REQUIRED(timersMutex)
+  {
+    // 0 is never a valid id and skip over ids still in use after wrap around
+    do
+    {
+      ++currentId;
+    } while(currentId == 0 || timers.count(currentId));
+    t->id = currentId;
+    if(m_Now < wheel.Now())
+      wheel.Rebase(m_Now);
+    wheel.Insert(t.get());
+    timers.emplace(currentId, std::move(t));
+    return currentId;
   }
 };
 
@@ -193,11 +483,8 @@ llarp_timer_stop(struct llarp_timer_context* t)
 {
   // destroy all timers
   // don't call callbacks on timers
-  {
-    llarp::util::Lock lock(&t->timersMutex);
-    t->timers.clear();
-    t->stop();
-  }
+  t->clear();
+  t->stop();
   if(t->ticker)
     t->ticker->SignalAll();
 }
@@ -222,31 +509,17 @@ llarp_timer_tick_all(struct llarp_timer_context* t)
   if(!t->run())
     return;
 
-  std::list< std::unique_ptr< llarp::timer > > hit;
-  {
-    llarp::util::Lock lock(&t->timersMutex);
-    auto itr = t->timers.begin();
-    while(itr != t->timers.end())
-    {
-      if(t->m_Now - itr->second->started >= itr->second->timeout
-         || itr->second->canceled)
-      {
-        // timer hit
-        hit.emplace_back(std::move(itr->second));
-        itr = t->timers.erase(itr);
-      }
-      else
-        ++itr;
-    }
-  }
+  std::vector< std::unique_ptr< llarp::timer > > hit;
+  t->collect(hit);
   for(const auto& h : hit)
   {
-    if(h->func)
+    if(h->func || h->deferredFunc)
     {
       h->called_at = t->m_Now;
       h->exec();
     }
   }
+  t->recycle(hit);
 }
 
 static void
@@ -302,8 +575,7 @@ namespace llarp
       else
         call(user, timeout, diff);
     }
-    if(deferredFunc)
+    if(deferredFunc && not canceled)
       deferredFunc();
-    done = true;
   }
 }  // namespace llarp
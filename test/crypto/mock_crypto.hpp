@@ -19,6 +19,10 @@ namespace llarp
                    bool(const llarp_buffer_t &, const llarp_buffer_t &,
                         const SharedSecret &, const byte_t *));
 
+      MOCK_METHOD5(onion_batch,
+                   bool(OnionPacket *, size_t, const OnionLayer *, size_t,
+                        bool));
+
       MOCK_METHOD4(dh_client,
                    bool(SharedSecret &, const PubKey &, const SecretKey &,
                         const TunnelNonce &));
@@ -1,6 +1,7 @@
 #include <crypto/crypto_libsodium.hpp>
 
 #include <iostream>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -59,4 +60,65 @@ namespace llarp
     ASSERT_TRUE(c->pqe_decrypt(block, otherShared, pq_keypair_to_secret(keys)));
     ASSERT_TRUE(otherShared == shared);
   }
+
+  struct OnionBatchTest : public ::testing::TestWithParam< bool >
+  {
+    llarp::sodium::CryptoLibSodium crypto;
+    std::vector< SharedSecret > keys;
+    std::vector< ShortHash > nonceXORs;
+    std::vector< OnionLayer > layers;
+
+    void
+    SetUp()
+    {
+      keys.resize(4);
+      nonceXORs.resize(4);
+      for(size_t idx = 0; idx < keys.size(); ++idx)
+      {
+        keys[idx].Randomize();
+        nonceXORs[idx].Randomize();
+        layers.push_back({&keys[idx], &nonceXORs[idx]});
+      }
+    }
+
+    /// what path did before, one xchacha20 pass per layer
+    void
+    Sequential(std::vector< byte_t >& data, TunnelNonce n, bool xorFirst)
+    {
+      llarp_buffer_t buf(data);
+      for(size_t idx = 0; idx < keys.size(); ++idx)
+      {
+        if(xorFirst)
+          n ^= nonceXORs[idx];
+        crypto.xchacha20(buf, keys[idx], n);
+        if(!xorFirst)
+          n ^= nonceXORs[idx];
+      }
+    }
+  };
+
+  TEST_P(OnionBatchTest, TestMatchesSequential)
+  {
+    const bool xorFirst = GetParam();
+    std::vector< std::vector< byte_t > > data, expect;
+    std::vector< OnionPacket > packets;
+    for(const size_t sz : {1, 63, 1000, 1024, 3000})
+    {
+      data.emplace_back(sz);
+      for(size_t idx = 0; idx < sz; ++idx)
+        data.back()[idx] = idx * 7;
+      expect.push_back(data.back());
+      TunnelNonce n;
+      n.Randomize();
+      Sequential(expect.back(), n, xorFirst);
+      packets.push_back({data.back().data(), sz, n});
+    }
+    ASSERT_TRUE(crypto.onion_batch(packets.data(), packets.size(),
+                                   layers.data(), layers.size(), xorFirst));
+    for(size_t idx = 0; idx < data.size(); ++idx)
+      ASSERT_EQ(data[idx], expect[idx]);
+  }
+
+  INSTANTIATE_TEST_CASE_P(TestCryptoOnion, OnionBatchTest,
+                          ::testing::Values(true, false));
 }  // namespace llarp
@@ -0,0 +1,119 @@
+#include <crypto/verify_cache.hpp>
+
+#include <crypto/crypto_libsodium.hpp>
+#include <llarp_test.hpp>
+#include <router_contact.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+using namespace llarp;
+
+struct VerifyCacheTest : public test::LlarpTest< sodium::CryptoLibSodium >
+{
+  VerifyCacheTest()
+  {
+    m_crypto.identity_keygen(secret);
+    body.Randomize();
+    m_crypto.sign(sig, secret, llarp_buffer_t(body));
+  }
+
+  SecretKey secret;
+  AlignedBuffer< 128 > body;
+  Signature sig;
+};
+
+TEST_F(VerifyCacheTest, TestHitSkipsVerify)
+{
+  VerifyCache cache;
+  const llarp_buffer_t buf(body);
+  ASSERT_TRUE(cache.Verify(secret.toPublic(), buf, sig, 0));
+  ASSERT_EQ(cache.Misses(), 1u);
+  ASSERT_TRUE(cache.Verify(secret.toPublic(), buf, sig, 1));
+  ASSERT_EQ(cache.Hits(), 1u);
+  ASSERT_EQ(cache.size(), 1u);
+
+  // bad signatures are checked every time and never kept
+  Signature bad = sig;
+  bad[0] ^= 1;
+  ASSERT_FALSE(cache.Verify(secret.toPublic(), buf, bad, 1));
+  ASSERT_FALSE(cache.Verify(secret.toPublic(), buf, bad, 1));
+  ASSERT_EQ(cache.Misses(), 3u);
+  ASSERT_EQ(cache.size(), 1u);
+
+  // same signature over something else is not a hit
+  AlignedBuffer< 128 > other = body;
+  other[0] ^= 1;
+  ASSERT_FALSE(cache.Verify(secret.toPublic(), llarp_buffer_t(other), sig, 1));
+  ASSERT_EQ(cache.Hits(), 1u);
+}
+
+TEST_F(VerifyCacheTest, TestExpiresAndBounded)
+{
+  VerifyCache cache(VerifyCache::Shards, 100);
+  const llarp_buffer_t buf(body);
+  ASSERT_TRUE(cache.Verify(secret.toPublic(), buf, sig, 0));
+  ASSERT_TRUE(cache.Verify(secret.toPublic(), buf, sig, 99));
+  ASSERT_EQ(cache.Hits(), 1u);
+  ASSERT_TRUE(cache.Verify(secret.toPublic(), buf, sig, 100));
+  ASSERT_EQ(cache.Hits(), 1u);
+  ASSERT_EQ(cache.size(), 1u);
+
+  // one entry per shard
+  for(size_t idx = 0; idx < 100; ++idx)
+  {
+    body.Randomize();
+    m_crypto.sign(sig, secret, llarp_buffer_t(body));
+    ASSERT_TRUE(cache.Verify(secret.toPublic(), llarp_buffer_t(body), sig, 0));
+    ASSERT_LE(cache.size(), VerifyCache::Shards);
+  }
+}
+
+TEST_F(VerifyCacheTest, TestDecodedRouterContact)
+{
+  SecretKey enc;
+  m_crypto.encryption_keygen(enc);
+  RouterContact rc;
+  rc.enckey = enc.toPublic();
+  rc.SetNick("verifycache");
+  ASSERT_TRUE(rc.Sign(secret));
+
+  std::array< byte_t, MAX_RC_SIZE > tmp;
+  llarp_buffer_t buf(tmp);
+  ASSERT_TRUE(rc.BEncode(&buf));
+  buf.sz  = buf.cur - buf.base;
+  buf.cur = buf.base;
+
+  VerifyCache::Default().Clear();
+  for(size_t idx = 0; idx < 3; ++idx)
+  {
+    RouterContact decoded;
+    llarp_buffer_t copy(buf.base, buf.base, buf.sz);
+    ASSERT_TRUE(decoded.BDecode(&copy));
+    ASSERT_TRUE(decoded.Verify(time_now_ms()));
+  }
+  ASSERT_EQ(VerifyCache::Default().Misses(), 1u);
+  ASSERT_EQ(VerifyCache::Default().Hits(), 2u);
+
+  // a field changed after decoding is checked, not what was decoded
+  RouterContact changed;
+  {
+    llarp_buffer_t copy(buf.base, buf.base, buf.sz);
+    ASSERT_TRUE(changed.BDecode(&copy));
+  }
+  ASSERT_TRUE(changed.Verify(time_now_ms()));
+  changed.last_updated += 1;
+  ASSERT_FALSE(changed.Verify(time_now_ms()));
+
+  // so does a change on the wire
+  const std::string nick("verifycache");
+  auto itr = std::search(tmp.begin(), tmp.end(), nick.begin(), nick.end());
+  ASSERT_NE(itr, tmp.end());
+  *itr = 'V';
+  RouterContact tampered;
+  llarp_buffer_t copy(buf.base, buf.base, buf.sz);
+  ASSERT_TRUE(tampered.BDecode(&copy));
+  ASSERT_FALSE(tampered.Verify(time_now_ms()));
+  VerifyCache::Default().Clear();
+}
@@ -2,6 +2,9 @@
 #include <dht/key.hpp>
 #include <dht/node.hpp>
 
+#include <algorithm>
+#include <random>
+
 #include <gtest/gtest.h>
 
 using Key_t    = llarp::dht::Key_t;
@@ -13,8 +16,7 @@ class TestDhtBucket : public ::testing::Test
  public:
   TestDhtBucket() : randInt(0)
   {
-    us.Fill(16);
-    nodes = std::make_unique< Bucket_t >(us, [&]() { return randInt++; });
+    nodes = std::make_unique< Bucket_t >([&]() { return randInt++; });
     size_t numNodes = 10;
     byte_t fill     = 1;
     while(numNodes)
@@ -29,7 +31,6 @@ class TestDhtBucket : public ::testing::Test
 
   uint64_t randInt;
 
-  llarp::dht::Key_t us;
   std::unique_ptr< Bucket_t > nodes;
 };
 
@@ -368,3 +369,68 @@ TEST_F(TestDhtBucket, TestBucketRandomized_1000)
     }
   }
 }
+
+/// closest n keys to target not in exclude the slow way
+static std::set< Key_t >
+NearestByScan(const std::vector< Key_t >& keys, const Key_t& target,
+              size_t n, const std::set< Key_t >& exclude)
+{
+  std::vector< Key_t > sorted;
+  for(const auto& k : keys)
+  {
+    if(exclude.count(k) == 0)
+      sorted.emplace_back(k);
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [&](const Key_t& a, const Key_t& b) {
+              return (a ^ target) < (b ^ target);
+            });
+  sorted.resize(std::min(n, sorted.size()));
+  return {sorted.begin(), sorted.end()};
+}
+
+TEST_F(TestDhtBucket, get_many_near_excluding_matches_scan)
+{
+  nodes->Clear();
+  std::mt19937_64 rng(42);
+  std::vector< Key_t > keys;
+  for(size_t idx = 0; idx < 3000; ++idx)
+  {
+    Value_t v;
+    for(auto& b : v.ID)
+      b = rng();
+    // some keys share a long prefix so the scan has to look past it
+    if(idx % 3 == 0)
+      std::fill_n(v.ID.begin(), 10, 0xAB);
+    keys.emplace_back(v.ID);
+    nodes->PutNode(v);
+  }
+  // take some out again so the table has been shuffled around
+  for(size_t idx = 0; idx < 300; ++idx)
+  {
+    nodes->DelNode(keys.back());
+    keys.pop_back();
+    std::swap(keys[idx * 7], keys.back());
+  }
+  ASSERT_EQ(nodes->size(), keys.size());
+
+  for(size_t round = 0; round < 50; ++round)
+  {
+    Key_t target;
+    for(auto& b : target)
+      b = rng();
+    if(round % 2)
+      std::fill_n(target.begin(), 8, 0xAB);
+    std::set< Key_t > exclude;
+    for(size_t idx = 0; idx < round; ++idx)
+      exclude.insert(keys[rng() % keys.size()]);
+    const size_t n = 1 + round % 8;
+    std::set< Key_t > result;
+    ASSERT_TRUE(nodes->GetManyNearExcluding(target, result, n, exclude));
+    ASSERT_EQ(result, NearestByScan(keys, target, n, exclude));
+    Key_t closest;
+    ASSERT_TRUE(nodes->FindCloseExcluding(target, closest, exclude));
+    ASSERT_EQ(std::set< Key_t >{closest},
+              NearestByScan(keys, target, 1, exclude));
+  }
+}
@@ -0,0 +1,126 @@
+#include <dht/introset_store.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace llarp;
+
+using Key_t = dht::Key_t;
+
+class TestDhtIntroSetStore : public ::testing::Test
+{
+ public:
+  TestDhtIntroSetStore() : store([&]() { return randInt++; })
+  {
+  }
+
+  /// introset for key with topic, published at t and expiring at expires
+  static dht::ISNode
+  MakeNode(byte_t key, const std::string& topic, llarp_time_t t,
+           llarp_time_t expires)
+  {
+    dht::ISNode node;
+    node.ID = KeyOf(key);
+    // introsets order by address
+    node.introset.A.m_CachedAddr.Fill(key);
+    node.introset.topic = service::Tag(topic);
+    node.introset.T     = t;
+    node.introset.I.emplace_back();
+    node.introset.I.back().expiresAt = expires;
+    return node;
+  }
+
+  static Key_t
+  KeyOf(byte_t key)
+  {
+    Key_t k;
+    k.Fill(key);
+    return k;
+  }
+
+  std::set< llarp_time_t >
+  FindAll(const std::string& topic,
+          const std::set< service::IntroSet >& exclude = {})
+  {
+    std::set< llarp_time_t > found;
+    for(const auto& introset : store.FindRandomWithTagExcluding(
+            service::Tag(topic), store.size(), exclude))
+    {
+      EXPECT_EQ(introset.topic, service::Tag(topic));
+      found.insert(introset.T);
+    }
+    return found;
+  }
+
+  uint64_t randInt = 0;
+  dht::IntroSetStore store;
+};
+
+TEST_F(TestDhtIntroSetStore, TestFindByTag)
+{
+  for(byte_t idx = 1; idx <= 10; ++idx)
+    store.PutNode(MakeNode(idx, idx % 2 ? "odd" : "even", idx, 1000));
+  ASSERT_EQ(store.size(), 10u);
+
+  ASSERT_EQ(FindAll("odd"), (std::set< llarp_time_t >{1, 3, 5, 7, 9}));
+  ASSERT_EQ(FindAll("even"), (std::set< llarp_time_t >{2, 4, 6, 8, 10}));
+  ASSERT_TRUE(FindAll("none").empty());
+
+  // max is respected from wherever we start
+  for(size_t n = 0; n < 5; ++n)
+  {
+    ASSERT_EQ(
+        store.FindRandomWithTagExcluding(service::Tag("odd"), 2, {}).size(),
+        2u);
+  }
+
+  const std::set< service::IntroSet > exclude{
+      *store.GetIntroSet(KeyOf(3)), *store.GetIntroSet(KeyOf(7))};
+  ASSERT_EQ(FindAll("odd", exclude), (std::set< llarp_time_t >{1, 5, 9}));
+}
+
+TEST_F(TestDhtIntroSetStore, TestNewerReplaces)
+{
+  const auto node = MakeNode(1, "old", 10, 100);
+  store.PutNode(node);
+  // older one is ignored
+  store.PutNode(MakeNode(1, "older", 5, 50));
+  ASSERT_EQ(FindAll("old"), std::set< llarp_time_t >{10});
+  ASSERT_TRUE(FindAll("older").empty());
+
+  store.PutNode(MakeNode(1, "new", 20, 200));
+  ASSERT_EQ(store.size(), 1u);
+  ASSERT_TRUE(FindAll("old").empty());
+  ASSERT_EQ(FindAll("new"), std::set< llarp_time_t >{20});
+
+  // expires with the new introset not the old one
+  ASSERT_EQ(store.RemoveExpired(150), 0u);
+  ASSERT_TRUE(store.HasNode(node.ID));
+  ASSERT_EQ(store.RemoveExpired(201), 1u);
+  ASSERT_FALSE(store.HasNode(node.ID));
+  ASSERT_TRUE(FindAll("new").empty());
+}
+
+TEST_F(TestDhtIntroSetStore, TestRemoveKeepsIndex)
+{
+  for(byte_t idx = 1; idx <= 20; ++idx)
+    store.PutNode(MakeNode(idx, "tag", idx, 100 + idx));
+
+  std::set< llarp_time_t > expected;
+  for(llarp_time_t t = 1; t <= 20; ++t)
+    expected.insert(t);
+
+  // take some out of the middle and the back
+  for(byte_t idx : {byte_t(20), byte_t(1), byte_t(7), byte_t(13)})
+  {
+    store.DelNode(KeyOf(idx));
+    expected.erase(idx);
+    ASSERT_EQ(FindAll("tag"), expected);
+  }
+
+  // soonest to expire go first
+  ASSERT_EQ(store.RemoveExpired(106), 4u);
+  for(llarp_time_t t = 1; t <= 5; ++t)
+    expected.erase(t);
+  ASSERT_EQ(FindAll("tag"), expected);
+  ASSERT_EQ(store.size(), expected.size());
+}
@@ -134,8 +134,10 @@ TEST_F(TestDhtServiceAddressLookup, get_next_peer)
   {
     uint64_t randVal = 0;
 
-    dht::Bucket< dht::RCNode > nodes(ourKey, [&]() { return randVal++; });
-    nodes.nodes.emplace(makeBuf< dht::Key_t >(0x03), dht::RCNode());
+    dht::Bucket< dht::RCNode > nodes([&]() { return randVal++; });
+    dht::RCNode node;
+    node.ID = makeBuf< dht::Key_t >(0x03);
+    nodes.PutNode(node);
     EXPECT_CALL(context, Nodes()).WillOnce(Return(&nodes));
     ASSERT_TRUE(serviceAddressLookup->GetNextPeer(key, exclude));
   }
@@ -0,0 +1,252 @@
+#include <exit/policy_classifier.hpp>
+
+#include <net/ip.hpp>
+#include <util/endian.hpp>
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+using namespace llarp;
+
+struct ExitPolicyClassifierTest : public ::testing::Test
+{
+  void
+  AddRule(const std::string& rule, bool drop)
+  {
+    exit::Policy policy;
+    IPRange range;
+    ASSERT_TRUE(exit::PolicyClassifier::ParseRule(rule, policy, range));
+    policy.drop = drop;
+    classifier.Add(policy, range);
+    classifier.Compile();
+  }
+
+  /// ipv4 packet from us to remote:port
+  static std::vector< byte_t >
+  MakeV4(const std::string& remote, uint8_t proto, uint16_t port)
+  {
+    std::vector< byte_t > pkt(40, 0);
+    pkt[0] = 0x45;
+    pkt[9] = proto;
+    huint32_t ip;
+    EXPECT_TRUE(ip.FromString(remote));
+    htobe32buf(pkt.data() + 12, 0x0a000002);
+    htobe32buf(pkt.data() + 16, ip.h);
+    htobe16buf(pkt.data() + 20, 40000);
+    htobe16buf(pkt.data() + 22, port);
+    return pkt;
+  }
+
+  /// put an 8 byte ipv6 extension header in front of the upper layer
+  static void
+  AddExtension(std::vector< byte_t >& pkt, uint8_t type)
+  {
+    std::vector< byte_t > ext(8, 0);
+    ext[0] = pkt[6];
+    pkt[6] = type;
+    pkt.insert(pkt.begin() + 40, ext.begin(), ext.end());
+  }
+
+  /// ipv6 packet from us to remote:port
+  static std::vector< byte_t >
+  MakeV6(const std::string& remote, uint8_t proto, uint16_t port)
+  {
+    std::vector< byte_t > pkt(60, 0);
+    pkt[0] = 0x60;
+    pkt[6] = proto;
+    huint128_t ip;
+    EXPECT_TRUE(ip.FromString(remote));
+    const in6_addr addr = net::IPPacket::HUIntToIn6(ip);
+    std::copy_n(addr.s6_addr, 16, pkt.begin() + 24);
+    htobe16buf(pkt.data() + 40, 40000);
+    htobe16buf(pkt.data() + 42, port);
+    return pkt;
+  }
+
+  bool
+  Outbound(const std::vector< byte_t >& pkt) const
+  {
+    return classifier.AllowOutbound(llarp_buffer_t(pkt));
+  }
+
+  exit::PolicyClassifier classifier;
+};
+
+TEST_F(ExitPolicyClassifierTest, TestParseRule)
+{
+  exit::Policy policy;
+  IPRange range;
+  ASSERT_TRUE(exit::PolicyClassifier::ParseRule("tcp:25", policy, range));
+  ASSERT_EQ(policy.proto, 6u);
+  ASSERT_EQ(policy.port, 25u);
+  ASSERT_TRUE(range.ContainsV4(huint32_t{0x01020304}));
+
+  ASSERT_TRUE(exit::PolicyClassifier::ParseRule("udp:* 10.0.0.0/8", policy,
+                                                range));
+  ASSERT_EQ(policy.proto, 17u);
+  ASSERT_EQ(policy.port, 0u);
+  ASSERT_TRUE(range.ContainsV4(huint32_t{0x0a010203}));
+  ASSERT_FALSE(range.ContainsV4(huint32_t{0x0b010203}));
+
+  ASSERT_TRUE(exit::PolicyClassifier::ParseRule("fc00::/7", policy, range));
+  ASSERT_EQ(policy.proto, 0u);
+
+  ASSERT_FALSE(exit::PolicyClassifier::ParseRule("", policy, range));
+  ASSERT_FALSE(exit::PolicyClassifier::ParseRule("tcp:70000", policy, range));
+  ASSERT_FALSE(exit::PolicyClassifier::ParseRule("bogus", policy, range));
+  ASSERT_FALSE(
+      exit::PolicyClassifier::ParseRule("10.0.0.0/33", policy, range));
+}
+
+TEST_F(ExitPolicyClassifierTest, TestEmptyAllowsAll)
+{
+  ASSERT_TRUE(classifier.Empty());
+  ASSERT_TRUE(Outbound(MakeV4("1.2.3.4", 6, 25)));
+  ASSERT_TRUE(Outbound(MakeV6("2001:db8::1", 17, 53)));
+}
+
+TEST_F(ExitPolicyClassifierTest, TestBlacklist)
+{
+  AddRule("tcp:25", true);
+  AddRule("10.0.0.0/8", true);
+  AddRule("udp:53 192.168.0.0/16", true);
+
+  ASSERT_FALSE(Outbound(MakeV4("1.2.3.4", 6, 25)));
+  ASSERT_TRUE(Outbound(MakeV4("1.2.3.4", 6, 80)));
+  ASSERT_TRUE(Outbound(MakeV4("1.2.3.4", 17, 25)));
+  ASSERT_FALSE(Outbound(MakeV6("2001:db8::1", 6, 25)));
+
+  ASSERT_FALSE(Outbound(MakeV4("10.20.30.40", 6, 80)));
+  ASSERT_FALSE(Outbound(MakeV4("10.20.30.40", 1, 0)));
+  ASSERT_TRUE(Outbound(MakeV4("11.20.30.40", 1, 0)));
+
+  ASSERT_FALSE(Outbound(MakeV4("192.168.1.1", 17, 53)));
+  ASSERT_TRUE(Outbound(MakeV4("192.168.1.1", 17, 54)));
+  ASSERT_TRUE(Outbound(MakeV4("192.169.1.1", 17, 53)));
+
+  // inbound checks the source
+  auto inbound = MakeV4("1.1.1.1", 6, 80);
+  htobe32buf(inbound.data() + 12, 0x0a010101);
+  ASSERT_FALSE(classifier.AllowInbound(llarp_buffer_t(inbound)));
+
+  // a bad header length is dropped rather than read for ports
+  auto shortHeader = MakeV4("1.2.3.4", 6, 80);
+  shortHeader[0]   = 0x44;
+  ASSERT_FALSE(Outbound(shortHeader));
+}
+
+TEST_F(ExitPolicyClassifierTest, TestExtensionHeaders)
+{
+  AddRule("tcp:25", true);
+
+  // the port is found behind any extension headers
+  for(const uint8_t type : {0, 43, 44, 60})
+  {
+    auto pkt = MakeV6("2001:db8::1", 6, 25);
+    AddExtension(pkt, type);
+    AddExtension(pkt, 60);
+    ASSERT_FALSE(Outbound(pkt)) << int(type);
+  }
+  auto pkt = MakeV6("2001:db8::1", 6, 80);
+  AddExtension(pkt, 60);
+  ASSERT_TRUE(Outbound(pkt));
+
+  // a chain running off the end of the packet is dropped
+  pkt[41] = 200;
+  ASSERT_FALSE(Outbound(pkt));
+}
+
+TEST_F(ExitPolicyClassifierTest, TestFragments)
+{
+  AddRule("tcp:443", false);
+  AddRule("udp:*", false);
+
+  // later fragments have no ports, so they only pass when every port would
+  auto v4 = MakeV4("1.2.3.4", 6, 443);
+  htobe16buf(v4.data() + 6, 100);
+  ASSERT_FALSE(Outbound(v4));
+  v4[9] = 17;
+  ASSERT_TRUE(Outbound(v4));
+
+  auto v6 = MakeV6("2001:db8::1", 6, 443);
+  AddExtension(v6, 44);
+  ASSERT_TRUE(Outbound(v6));
+  htobe16buf(v6.data() + 42, 100 << 3);
+  ASSERT_FALSE(Outbound(v6));
+  v6[40] = 17;
+  ASSERT_TRUE(Outbound(v6));
+
+  // a blacklisted port fails closed too
+  AddRule("tcp:25", true);
+  AddRule("tcp:*", false);
+  v4[9] = 6;
+  ASSERT_FALSE(Outbound(v4));
+}
+
+TEST_F(ExitPolicyClassifierTest, TestWhitelist)
+{
+  AddRule("tcp:443", false);
+  AddRule("udp:*", false);
+  AddRule("fc00::/7", false);
+  AddRule("udp:53 8.8.0.0/16", true);
+
+  ASSERT_TRUE(Outbound(MakeV4("1.2.3.4", 6, 443)));
+  ASSERT_FALSE(Outbound(MakeV4("1.2.3.4", 6, 80)));
+  ASSERT_FALSE(Outbound(MakeV4("1.2.3.4", 1, 0)));
+  ASSERT_TRUE(Outbound(MakeV4("1.2.3.4", 17, 53)));
+  ASSERT_FALSE(Outbound(MakeV4("8.8.8.8", 17, 53)));
+  ASSERT_TRUE(Outbound(MakeV4("8.8.8.8", 17, 123)));
+
+  ASSERT_TRUE(Outbound(MakeV6("fd00::1", 6, 80)));
+  ASSERT_FALSE(Outbound(MakeV6("2001:db8::1", 6, 80)));
+  ASSERT_TRUE(Outbound(MakeV6("2001:db8::1", 6, 443)));
+
+  // malformed packets do not get through
+  ASSERT_FALSE(Outbound(std::vector< byte_t >(10, 0x45)));
+}
+
+TEST_F(ExitPolicyClassifierTest, TestMatchesRules)
+{
+  // compare the compiled tables against the rules checked one by one
+  const std::vector< std::pair< std::string, bool > > rules = {
+      {"tcp:443", false},      {"udp:*", false},
+      {"10.0.0.0/8", false},   {"tcp:22 10.1.0.0/16", true},
+      {"10.1.2.0/24", true},   {"udp:53 10.0.0.0/8", true},
+      {"icmp 10.1.2.3/32", false}};
+  std::vector< std::pair< exit::Policy, IPRange > > parsed;
+  for(const auto& rule : rules)
+  {
+    AddRule(rule.first, rule.second);
+    exit::Policy policy;
+    IPRange range;
+    exit::PolicyClassifier::ParseRule(rule.first, policy, range);
+    policy.drop = rule.second;
+    parsed.emplace_back(policy, range);
+  }
+
+  std::mt19937 rng(1);
+  const uint8_t protos[] = {1, 6, 17, 47};
+  const uint16_t ports[] = {22, 53, 80, 443};
+  for(size_t idx = 0; idx < 10000; ++idx)
+  {
+    const huint32_t ip{uint32_t(0x0a000000 | (rng() & 0x0103ffff))};
+    const uint8_t proto = protos[rng() % 4];
+    const uint16_t port = (proto == 6 || proto == 17) ? ports[rng() % 4] : 0;
+    bool white = false;
+    bool black = false;
+    for(const auto& rule : parsed)
+    {
+      const exit::Policy& policy = rule.first;
+      if(!rule.second.ContainsV4(ip)
+         || (policy.proto && policy.proto != proto)
+         || (policy.port && policy.port != port))
+        continue;
+      (policy.drop ? black : white) = true;
+    }
+    ASSERT_EQ(classifier.Allow(net::IPPacket::ExpandV4(ip), proto, port),
+              white && !black)
+        << ip << " " << int(proto) << " " << port;
+  }
+}
@@ -0,0 +1,97 @@
+#include <iwp/congestion.hpp>
+
+#include <gtest/gtest.h>
+
+using CongestionControl = llarp::iwp::CongestionControl;
+
+TEST(IWPCongestion, SlowStartGrowsPerAck)
+{
+  CongestionControl cc;
+  ASSERT_EQ(cc.Window(), CongestionControl::InitialWindow);
+  cc.OnAcked(4);
+  ASSERT_EQ(cc.Window(), CongestionControl::InitialWindow + 4);
+}
+
+TEST(IWPCongestion, FastRetransmitHalvesOncePerWindow)
+{
+  CongestionControl cc;
+  cc.OnAcked(8);
+  ASSERT_EQ(cc.Window(), 16u);
+  uint64_t first = 0;
+  for(size_t idx = 0; idx < 8; ++idx)
+  {
+    const auto seqno = cc.OnSent(false);
+    if(idx == 0)
+      first = seqno;
+  }
+  cc.OnFastRetransmit(first, 1);
+  ASSERT_EQ(cc.Window(), 8u);
+  // a second loss from the same window does not back off again
+  cc.OnFastRetransmit(first + 1, 1);
+  ASSERT_EQ(cc.Window(), 8u);
+  // once in congestion avoidance we grow by one per window acked
+  cc.OnAcked(8);
+  ASSERT_EQ(cc.Window(), 9u);
+}
+
+TEST(IWPCongestion, TimeoutCollapsesWindowAndBacksOff)
+{
+  CongestionControl cc;
+  cc.OnRTTSample(100);
+  const auto rto = cc.RTO();
+  ASSERT_GE(rto, CongestionControl::MinRTO);
+  cc.OnTimeout(3);
+  ASSERT_EQ(cc.Window(), CongestionControl::MinWindow);
+  ASSERT_EQ(cc.RTO(), std::min(rto * 2, CongestionControl::MaxRTO));
+}
+
+TEST(IWPCongestion, RTTEstimator)
+{
+  CongestionControl cc;
+  cc.OnRTTSample(100);
+  ASSERT_EQ(cc.SRTT(), 100u);
+  // never sooner than the receiver may hold back its acks
+  ASSERT_EQ(cc.RTO(), 100u + CongestionControl::MaxAckDelay);
+  for(int i = 0; i < 64; ++i)
+    cc.OnRTTSample(20);
+  ASSERT_LT(cc.SRTT(), 30u);
+  ASSERT_EQ(cc.RTO(), cc.SRTT() + CongestionControl::MaxAckDelay);
+  // a jittery path backs off past the ack delay
+  cc.OnRTTSample(600);
+  ASSERT_GT(cc.RTO(), cc.SRTT() + CongestionControl::MaxAckDelay);
+}
+
+TEST(IWPCongestion, WindowAndPacingLimitSends)
+{
+  CongestionControl cc;
+  cc.OnRTTSample(100);
+  const llarp_time_t now = 1000;
+  ASSERT_FALSE(cc.CanSend(cc.Window(), now));
+  size_t sent = 0;
+  while(cc.CanSend(sent, now))
+  {
+    cc.OnSent(false);
+    ++sent;
+  }
+  // pacer lets half a window out at once
+  ASSERT_EQ(sent, CongestionControl::InitialWindow / 2);
+  // after a full round trip we may send again
+  ASSERT_TRUE(cc.CanSend(0, now + cc.SRTT()));
+}
+
+TEST(IWPCongestion, NextSendAtMatchesPacer)
+{
+  CongestionControl cc;
+  cc.OnRTTSample(100);
+  const llarp_time_t now = 1000;
+  size_t sent = 0;
+  while(cc.CanSend(sent, now))
+  {
+    cc.OnSent(false);
+    ++sent;
+  }
+  const auto next = cc.NextSendAt(now);
+  ASSERT_GT(next, now);
+  ASSERT_FALSE(cc.CanSend(0, next - 1));
+  ASSERT_TRUE(cc.CanSend(0, next));
+}
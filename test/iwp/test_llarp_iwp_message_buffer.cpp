@@ -0,0 +1,54 @@
+#include <iwp/message_buffer.hpp>
+
+#include <crypto/crypto_libsodium.hpp>
+#include <llarp_test.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace llarp;
+using namespace llarp::iwp;
+
+struct IWPMessageBufferTest : public test::LlarpTest< sodium::CryptoLibSodium >
+{
+};
+
+TEST_F(IWPMessageBufferTest, TestAppendAndResizeBounds)
+{
+  PacketBuffer pkt;
+  ASSERT_TRUE(pkt.Resize(MaxPacketSize));
+  ASSERT_FALSE(pkt.Resize(MaxPacketSize + 1));
+  ASSERT_EQ(pkt.size(), MaxPacketSize);
+
+  const byte_t b = 0;
+  ASSERT_FALSE(pkt.Append(&b, 1));
+  ASSERT_EQ(pkt.size(), MaxPacketSize);
+
+  // padding a packet that is already full fails and leaves it alone
+  ASSERT_FALSE(AddRandomPadding(pkt));
+  ASSERT_EQ(pkt.size(), MaxPacketSize);
+
+  ASSERT_TRUE(pkt.Resize(0));
+  ASSERT_TRUE(AddRandomPadding(pkt));
+  ASSERT_GE(pkt.size(), PaddingMin);
+  ASSERT_LT(pkt.size(), PaddingMin + PaddingVariance);
+}
+
+TEST_F(IWPMessageBufferTest, TestSendFragmentFits)
+{
+  std::vector< byte_t > body(MAX_LINK_MSG_SIZE, 0x55);
+  OutboundMessage msg{1, llarp_buffer_t(body), 0, nullptr};
+  size_t sent = 0;
+  for(size_t idx = 0; idx < msg.NumFragments(); ++idx)
+  {
+    ASSERT_TRUE(msg.SendFragment(idx, idx, 0, [&](const llarp_buffer_t &pkt) {
+      ASSERT_LE(pkt.sz, FragmentHeaderSize + FragmentSize);
+      ++sent;
+    }));
+  }
+  ASSERT_EQ(sent, msg.NumFragments());
+  ASSERT_EQ(msg.InFlight(), msg.NumFragments());
+
+  PacketBuffer xmit;
+  ASSERT_TRUE(msg.XMIT(xmit));
+  ASSERT_TRUE(AddRandomPadding(xmit));
+}
@@ -15,7 +15,9 @@
 using namespace ::llarp;
 using namespace ::testing;
 
-struct LinkLayerTest : public test::LlarpTest< llarp::sodium::CryptoLibSodium >
+/// parameter is how many net threads each link uses
+struct LinkLayerTest : public test::LlarpTest< llarp::sodium::CryptoLibSodium >,
+                       public WithParamInterface< size_t >
 {
   static constexpr uint16_t AlicePort = 5000;
   static constexpr uint16_t BobPort   = 6000;
@@ -169,7 +171,7 @@ struct LinkLayerTest : public test::LlarpTest< llarp::sodium::CryptoLibSodium >
   }
 };
 
-TEST_F(LinkLayerTest, TestIWP)
+TEST_P(LinkLayerTest, TestIWP)
 {
 #ifdef WIN32
     GTEST_SKIP();
@@ -252,6 +254,8 @@ TEST_F(LinkLayerTest, TestIWP)
       [&](ILinkSession* session) { ASSERT_FALSE(session->IsEstablished()); },
       [&](RouterID router) { ASSERT_EQ(router, Alice.GetRouterID()); });
 
+  Alice.link->SetNetThreads(GetParam());
+  Bob.link->SetNetThreads(GetParam());
   ASSERT_TRUE(Alice.Start(m_logic, netLoop, AlicePort));
   ASSERT_TRUE(Bob.Start(m_logic, netLoop, BobPort));
 
@@ -261,3 +265,5 @@ TEST_F(LinkLayerTest, TestIWP)
   ASSERT_TRUE(Bob.gotLIM);
 #endif
 };
+
+INSTANTIATE_TEST_CASE_P(TestLinkLayer, LinkLayerTest, Values(1, 4));
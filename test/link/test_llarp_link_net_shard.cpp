@@ -0,0 +1,142 @@
+#include <link/net_shard.hpp>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <thread>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace ::llarp;
+
+#ifndef _WIN32
+struct NetShardTest : public ::testing::Test
+{
+  static constexpr uint16_t Port = 7300;
+
+  Addr addr{"127.0.0.1", Port};
+  std::atomic< size_t > notified{0};
+  std::vector< int > fds;
+
+  void
+  TearDown() override
+  {
+    for(const int fd : fds)
+      ::close(fd);
+  }
+
+  std::unique_ptr< NetShard >
+  MakeShard()
+  {
+    auto shard = std::make_unique< NetShard >([&]() { ++notified; });
+    if(!shard->Bind(addr) || !shard->Start("net-shard-test"))
+      return nullptr;
+    return shard;
+  }
+
+  /// a plain udp socket on an ephemeral loopback port
+  int
+  MakeSocket()
+  {
+    const int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in local{};
+    local.sin_family      = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(fd, (const sockaddr*)&local, sizeof(local));
+    timeval tv{2, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    fds.push_back(fd);
+    return fd;
+  }
+
+  static uint16_t
+  PortOf(int fd)
+  {
+    sockaddr_in local{};
+    socklen_t len = sizeof(local);
+    ::getsockname(fd, (sockaddr*)&local, &len);
+    return ntohs(local.sin_port);
+  }
+};
+
+TEST_F(NetShardTest, TestShardsSharePort)
+{
+  constexpr size_t Sources   = 16;
+  constexpr size_t PerSource = 8;
+  std::vector< std::unique_ptr< NetShard > > shards;
+  shards.emplace_back(MakeShard());
+  shards.emplace_back(MakeShard());
+  ASSERT_NE(shards[0], nullptr);
+  ASSERT_NE(shards[1], nullptr);
+
+  std::map< uint16_t, int > sources;
+  for(size_t src = 0; src < Sources; ++src)
+  {
+    const int fd = MakeSocket();
+    sources.emplace(PortOf(fd), fd);
+    for(uint32_t seq = 0; seq < PerSource; ++seq)
+    {
+      ASSERT_EQ(::sendto(fd, &seq, sizeof(seq), 0, addr, addr.SockLen()),
+                ssize_t(sizeof(seq)));
+    }
+  }
+
+  // remote port -> (shard, next sequence number)
+  std::map< uint16_t, std::pair< size_t, uint32_t > > seen;
+  size_t got          = 0;
+  const auto deadline = std::chrono::steady_clock::now()
+      + std::chrono::seconds(5);
+  PacketBatch batch;
+  while(got < Sources * PerSource
+        && std::chrono::steady_clock::now() < deadline)
+  {
+    for(size_t idx = 0; idx < shards.size(); ++idx)
+    {
+      shards[idx]->TakeReceived(batch);
+      batch.ForEach([&](const Addr& from, const byte_t* ptr, size_t sz) {
+        ASSERT_EQ(sz, sizeof(uint32_t));
+        uint32_t seq;
+        std::memcpy(&seq, ptr, sz);
+        auto itr = seen.emplace(from.port(), std::make_pair(idx, 0u)).first;
+        // a remote sticks to one shard and its packets stay in order
+        ASSERT_EQ(itr->second.first, idx);
+        ASSERT_EQ(itr->second.second, seq);
+        ++itr->second.second;
+        ++got;
+      });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(got, Sources * PerSource);
+  ASSERT_EQ(seen.size(), Sources);
+  ASSERT_GT(notified.load(), 0u);
+}
+
+TEST_F(NetShardTest, TestSendFromShard)
+{
+  auto shard = MakeShard();
+  ASSERT_NE(shard, nullptr);
+  const int fd = MakeSocket();
+  const Addr to("127.0.0.1", PortOf(fd));
+  const uint32_t value = 1337;
+  shard->QueueSend(to, llarp_buffer_t(&value, sizeof(value)));
+  shard->Flush();
+
+  uint32_t got = 0;
+  sockaddr_in from{};
+  socklen_t len = sizeof(from);
+  ASSERT_EQ(::recvfrom(fd, &got, sizeof(got), 0, (sockaddr*)&from, &len),
+            ssize_t(sizeof(got)));
+  ASSERT_EQ(got, value);
+  // sent from the shared port
+  ASSERT_EQ(ntohs(from.sin_port), addr.port());
+}
+#endif
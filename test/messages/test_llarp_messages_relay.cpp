@@ -0,0 +1,127 @@
+#include <messages/relay.hpp>
+
+#include <array>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace ::llarp;
+
+struct RelayViewTest : public ::testing::Test
+{
+  std::array< byte_t, MAX_LINK_MSG_SIZE > tmp;
+  llarp_buffer_t buf{tmp};
+
+  template < typename Msg_t >
+  Msg_t
+  MakeMessage(size_t sz)
+  {
+    Msg_t msg;
+    msg.pathid.Fill(1);
+    msg.Y.Fill(2);
+    msg.X = Encrypted< MAX_LINK_MSG_SIZE - 128 >(sz);
+    msg.X.Fill(3);
+    return msg;
+  }
+
+  /// decode like the link message parser does, which eats the 'a' key
+  static bool
+  Decode(ILinkMessage& msg, llarp_buffer_t* b)
+  {
+    return bencode_read_dict(
+        [&msg](llarp_buffer_t* val, llarp_buffer_t* key) -> bool {
+          if(key == nullptr)
+            return true;
+          llarp_buffer_t str;
+          if(*key == "a")
+            return bencode_read_string(val, &str);
+          return msg.DecodeKey(*key, val);
+        },
+        b);
+  }
+
+  template < typename Msg_t >
+  void
+  Encode(const Msg_t& msg)
+  {
+    buf.cur = buf.base;
+    ASSERT_TRUE(msg.BEncode(&buf));
+    buf.sz  = buf.cur - buf.base;
+    buf.cur = buf.base;
+  }
+};
+
+TEST_F(RelayViewTest, ParsesUpstreamInPlace)
+{
+  const auto msg = MakeMessage< RelayUpstreamMessage >(1024);
+  Encode(msg);
+  RelayMessageView view;
+  ASSERT_TRUE(view.Parse(buf));
+  ASSERT_EQ(view.type, 'u');
+  ASSERT_EQ(view.msg.base, buf.base);
+  ASSERT_EQ(view.msg.sz, buf.sz);
+  ASSERT_TRUE(std::equal(msg.pathid.begin(), msg.pathid.end(), view.pathid));
+  ASSERT_TRUE(std::equal(msg.Y.begin(), msg.Y.end(), view.nonce));
+  ASSERT_EQ(view.X.sz, msg.X.size());
+  ASSERT_TRUE(view.X.base > buf.base && view.X.base < buf.base + buf.sz);
+  ASSERT_TRUE(std::equal(msg.X.data(), msg.X.data() + msg.X.size(),
+                         view.X.base));
+}
+
+TEST_F(RelayViewTest, PatchedBufferDecodes)
+{
+  const auto msg = MakeMessage< RelayDownstreamMessage >(512);
+  Encode(msg);
+  RelayMessageView view;
+  ASSERT_TRUE(view.Parse(buf));
+  ASSERT_EQ(view.type, 'd');
+  std::fill_n(view.pathid, PathID_t::SIZE, 9);
+  std::fill_n(view.nonce, TunnelNonce::SIZE, 8);
+  std::fill_n(view.X.base, view.X.sz, 7);
+
+  RelayDownstreamMessage decoded;
+  ASSERT_TRUE(Decode(decoded, &buf));
+  PathID_t pathid;
+  pathid.Fill(9);
+  TunnelNonce Y;
+  Y.Fill(8);
+  ASSERT_EQ(decoded.pathid, pathid);
+  ASSERT_EQ(decoded.Y, Y);
+  ASSERT_EQ(decoded.X.size(), 512u);
+  ASSERT_EQ(decoded.X.data()[0], 7);
+}
+
+TEST_F(RelayViewTest, RejectsOtherLayouts)
+{
+  RelayMessageView view;
+  auto msg = MakeMessage< RelayUpstreamMessage >(128);
+  Encode(msg);
+  // trailing garbage
+  tmp[buf.sz] = 'e';
+  llarp_buffer_t longer(buf.base, buf.base, buf.sz + 1);
+  ASSERT_FALSE(view.Parse(longer));
+  // truncated
+  llarp_buffer_t shorter(buf.base, buf.base, buf.sz - 1);
+  ASSERT_FALSE(view.Parse(shorter));
+  // not a relay message
+  const std::string discard = "d1:a1:x1:pi0ee";
+  const llarp_buffer_t other(discard);
+  ASSERT_FALSE(view.Parse(other));
+  // payload too big for the decoded message
+  std::vector< byte_t > big(MAX_LINK_MSG_SIZE + 256);
+  llarp_buffer_t bigbuf(big);
+  const std::string head = "d1:a1:u1:p16:";
+  std::copy(head.begin(), head.end(), bigbuf.cur);
+  bigbuf.cur += head.size() + PathID_t::SIZE;
+  ASSERT_TRUE(bencode_write_bytestring(&bigbuf, "v", 1));
+  ASSERT_TRUE(bencode_write_uint64(&bigbuf, LLARP_PROTO_VERSION));
+  ASSERT_TRUE(bencode_write_bytestring(&bigbuf, "x", 1));
+  ASSERT_TRUE(bencode_write_bytestring(&bigbuf, big.data(),
+                                       MAX_LINK_MSG_SIZE - 127));
+  ASSERT_TRUE(bencode_write_bytestring(&bigbuf, "y", 1));
+  ASSERT_TRUE(bencode_write_bytestring(&bigbuf, big.data(), 32));
+  ASSERT_TRUE(bencode_end(&bigbuf));
+  bigbuf.sz  = bigbuf.cur - bigbuf.base;
+  bigbuf.cur = bigbuf.base;
+  ASSERT_FALSE(view.Parse(bigbuf));
+}
@@ -0,0 +1,100 @@
+#include <net/ip_pool.hpp>
+
+#include <limits>
+
+#include <gtest/gtest.h>
+
+using llarp::huint128_t;
+using llarp::net::IPPool;
+
+struct TestIPPool : public ::testing::Test
+{
+  IPPool pool;
+
+  static huint128_t
+  IP(uint64_t n)
+  {
+    return huint128_t{n};
+  }
+
+  void
+  SetUp() override
+  {
+    // hands out 11, 12, 13
+    pool.Init(IP(10), IP(14));
+  }
+
+  huint128_t
+  Allocate(llarp_time_t now, bool expectEvict = false)
+  {
+    huint128_t ip{0};
+    bool evicted = !expectEvict;
+    EXPECT_TRUE(pool.Allocate(ip, evicted, now));
+    EXPECT_EQ(evicted, expectEvict);
+    return ip;
+  }
+};
+
+TEST_F(TestIPPool, TestInOrder)
+{
+  ASSERT_FALSE(pool.Contains(IP(10)));
+  ASSERT_TRUE(pool.Contains(IP(13)));
+  ASSERT_FALSE(pool.Contains(IP(14)));
+  ASSERT_EQ(Allocate(1), IP(11));
+  ASSERT_EQ(Allocate(2), IP(12));
+  ASSERT_EQ(pool.NextUnused(), IP(13));
+  ASSERT_EQ(pool.LastActive(IP(12)), 2u);
+  ASSERT_EQ(pool.LastActive(IP(13)), 0u);
+}
+
+TEST_F(TestIPPool, TestEvictsLeastRecent)
+{
+  Allocate(1);
+  Allocate(2);
+  Allocate(3);
+  pool.Touch(IP(11), 4);
+  ASSERT_EQ(Allocate(5, true), IP(12));
+  ASSERT_EQ(Allocate(6, true), IP(13));
+  ASSERT_EQ(Allocate(7, true), IP(11));
+  ASSERT_EQ(pool.LastActive(IP(11)), 7u);
+}
+
+TEST_F(TestIPPool, TestReleaseReuses)
+{
+  Allocate(1);
+  Allocate(2);
+  Allocate(3);
+  pool.Release(IP(12));
+  ASSERT_EQ(pool.LastActive(IP(12)), 0u);
+  ASSERT_EQ(Allocate(4), IP(12));
+}
+
+TEST_F(TestIPPool, TestPinned)
+{
+  // pinned ahead of use and after
+  pool.Pin(IP(12));
+  ASSERT_EQ(pool.LastActive(IP(12)),
+            std::numeric_limits< llarp_time_t >::max());
+  ASSERT_EQ(Allocate(1), IP(11));
+  ASSERT_EQ(Allocate(2), IP(13));
+  pool.Pin(IP(11));
+  ASSERT_EQ(Allocate(3, true), IP(13));
+
+  pool.Pin(IP(13));
+  huint128_t ip{0};
+  bool evicted = false;
+  ASSERT_FALSE(pool.Allocate(ip, evicted, 4));
+
+  pool.Release(IP(12));
+  ASSERT_EQ(Allocate(5), IP(12));
+}
+
+TEST_F(TestIPPool, TestEmptyRange)
+{
+  pool.Init(IP(10), IP(11));
+  huint128_t ip{0};
+  bool evicted = false;
+  ASSERT_FALSE(pool.Allocate(ip, evicted, 1));
+  ASSERT_FALSE(pool.Contains(IP(10)));
+  ASSERT_FALSE(pool.Contains(IP(11)));
+}
@@ -0,0 +1,124 @@
+#include <path/pathbuilder.hpp>
+
+#include <crypto/crypto.hpp>
+#include <crypto/crypto_libsodium.hpp>
+#include <crypto/key_pool.hpp>
+#include <llarp_test.hpp>
+#include <messages/relay_commit.hpp>
+#include <path/path.hpp>
+#include <util/thread/thread_pool.hpp>
+
+#include <set>
+
+#include <gtest/gtest.h>
+
+using namespace llarp;
+
+struct PathBuilderTest : public test::LlarpTest< sodium::CryptoLibSodium >
+{
+  std::vector< SecretKey > hopKeys;
+  path::Path::HopList hops;
+
+  PathBuilderTest() : hopKeys(path::default_len), hops(path::default_len)
+  {
+    for(size_t idx = 0; idx < hops.size(); ++idx)
+    {
+      m_crypto.encryption_keygen(hopKeys[idx]);
+      hops[idx].rc.enckey = seckey_topublic(hopKeys[idx]);
+      hops[idx].rc.pubkey.Randomize();
+      hops[idx].txID.Randomize();
+      hops[idx].rxID.Randomize();
+    }
+  }
+
+  const path::PathHopConfig*
+  Next(size_t idx) const
+  {
+    return idx + 1 < hops.size() ? &hops[idx + 1] : nullptr;
+  }
+};
+
+TEST_F(PathBuilderTest, TestSealHopRecord)
+{
+  std::array< EncryptedFrame, path::max_len > frames;
+  for(size_t idx = 0; idx < hops.size(); ++idx)
+  {
+    frames[idx].Randomize();
+    ASSERT_TRUE(
+        path::SealHopRecord(hops[idx], Next(idx), frames[idx], SecretKey{}));
+  }
+
+  for(size_t idx = 0; idx < hops.size(); ++idx)
+  {
+    const auto& hop = hops[idx];
+    ASSERT_TRUE(frames[idx].DecryptInPlace(hopKeys[idx]));
+    auto buf = frames[idx].Buffer();
+    buf->cur = buf->base + EncryptedFrameOverheadSize;
+    LR_CommitRecord record;
+    ASSERT_TRUE(record.BDecode(buf));
+    ASSERT_EQ(record.txid, hop.txID);
+    ASSERT_EQ(record.rxid, hop.rxID);
+    ASSERT_EQ(record.commkey, PubKey(seckey_topublic(hop.commkey)));
+    const auto next = Next(idx);
+    ASSERT_EQ(record.nextHop, next ? next->rc.pubkey : hop.rc.pubkey);
+    ASSERT_EQ(record.nextRC != nullptr, next != nullptr);
+
+    // the hop derives the same shared key we did
+    SharedSecret shared;
+    ASSERT_TRUE(m_crypto.dh_server(shared, record.commkey, hopKeys[idx],
+                                   record.tunnelNonce));
+    ASSERT_EQ(shared, hop.shared);
+  }
+}
+
+TEST_F(PathBuilderTest, TestKeyPool)
+{
+  auto pool = std::make_shared< EncryptionKeyPool >(8, nullptr);
+  ASSERT_EQ(pool->Size(), 0u);
+  SecretKey key;
+  ASSERT_FALSE(pool->Take(key));
+  ASSERT_TRUE(key.IsZero());
+
+  pool->Refill();
+  ASSERT_EQ(pool->Size(), 8u);
+  std::set< SecretKey > taken;
+  for(size_t idx = 0; idx < 8; ++idx)
+  {
+    ASSERT_TRUE(pool->Take(key));
+    ASSERT_FALSE(key.IsZero());
+    ASSERT_EQ(key.toPublic(), PubKey(seckey_topublic(key)));
+    taken.insert(key);
+  }
+  ASSERT_EQ(taken.size(), 8u);
+  ASSERT_FALSE(pool->Take(key));
+
+  // a pooled key is used as given
+  pool->Refill();
+  auto& hop = hops.back();
+  ASSERT_TRUE(pool->Take(hop.commkey));
+  const SecretKey commkey = hop.commkey;
+  EncryptedFrame frame;
+  ASSERT_TRUE(pool->Take(key));
+  ASSERT_TRUE(path::SealHopRecord(hop, nullptr, frame, key));
+  ASSERT_EQ(hop.commkey, commkey);
+}
+
+TEST_F(PathBuilderTest, TestKeyPoolRefillsOnWorker)
+{
+  auto worker = std::make_shared< thread::ThreadPool >(1, 16, "test");
+  ASSERT_TRUE(worker->start());
+  auto pool = std::make_shared< EncryptionKeyPool >(8, worker);
+  ASSERT_TRUE(pool->ScheduleRefill());
+  worker->drain();
+  ASSERT_EQ(pool->Size(), 8u);
+  // nothing to do until we drop below half
+  SecretKey key;
+  for(size_t idx = 0; idx < 4; ++idx)
+    ASSERT_TRUE(pool->Take(key));
+  ASSERT_FALSE(pool->ScheduleRefill());
+  ASSERT_TRUE(pool->Take(key));
+  ASSERT_TRUE(pool->ScheduleRefill());
+  worker->drain();
+  ASSERT_EQ(pool->Size(), 8u);
+  worker->stop();
+}
@@ -0,0 +1,119 @@
+#include <path/transit_hop_table.hpp>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using llarp::path::TransitHop;
+using llarp::path::TransitHop_ptr;
+using llarp::path::TransitHopTable;
+
+struct TransitHopTableTest : public ::testing::Test
+{
+  TransitHopTable table;
+
+  static TransitHop_ptr
+  MakeHop(llarp_time_t started, llarp_time_t lifetime = 1000)
+  {
+    auto hop = std::make_shared< TransitHop >();
+    hop->info.txID.Randomize();
+    hop->info.rxID.Randomize();
+    hop->info.upstream.Randomize();
+    hop->info.downstream.Randomize();
+    hop->started  = started;
+    hop->lifetime = lifetime;
+    return hop;
+  }
+
+  static bool
+  Any(const TransitHop&)
+  {
+    return true;
+  }
+};
+
+TEST_F(TransitHopTableTest, FindsByEitherIdAndNeighbour)
+{
+  auto hop        = MakeHop(0);
+  const auto info = hop->info;
+  table.Put(hop);
+  ASSERT_EQ(table.Get(info.txID, info.downstream, Any), hop);
+  ASSERT_EQ(table.Get(info.rxID, info.upstream, Any), hop);
+  ASSERT_EQ(table.Get(info.txID, info.upstream, Any), hop);
+  ASSERT_EQ(table.Get(info.rxID, info.downstream, Any), hop);
+
+  llarp::RouterID other;
+  other.Randomize();
+  ASSERT_EQ(table.Get(info.txID, other, Any), nullptr);
+  auto none = [](const TransitHop&) { return false; };
+  ASSERT_EQ(table.Get(info.txID, info.downstream, none), nullptr);
+}
+
+TEST_F(TransitHopTableTest, ExpiresByLifetime)
+{
+  auto early = MakeHop(0, 100);
+  auto late  = MakeHop(0, 200);
+  table.Put(early);
+  table.Put(late);
+  table.Expire(99);
+  ASSERT_EQ(table.Size(), 2u);
+  table.Expire(100);
+  ASSERT_EQ(table.Size(), 1u);
+  ASSERT_EQ(table.Get(early->info.txID, early->info.downstream, Any), nullptr);
+  ASSERT_EQ(table.Get(late->info.txID, late->info.downstream, Any), late);
+}
+
+TEST_F(TransitHopTableTest, SkipsDestroyedHopsBeforeSweep)
+{
+  auto hop        = MakeHop(0);
+  const auto info = hop->info;
+  table.Put(hop);
+  hop->destroy = true;
+  // still held until an expiry pass reaches it, but no longer routable
+  ASSERT_EQ(table.Size(), 1u);
+  ASSERT_EQ(table.Get(info.txID, info.downstream, Any), nullptr);
+  ASSERT_EQ(table.Get(info.rxID, info.upstream, Any), nullptr);
+}
+
+TEST_F(TransitHopTableTest, SweepsDestroyedHops)
+{
+  std::vector< TransitHop_ptr > hops;
+  for(size_t idx = 0; idx < TransitHopTable::SweepBatch * 2; ++idx)
+  {
+    hops.emplace_back(MakeHop(idx));
+    table.Put(hops.back());
+  }
+  for(auto& hop : hops)
+    hop->destroy = true;
+  table.Expire(0);
+  table.Expire(0);
+  ASSERT_EQ(table.Size(), 0u);
+  for(const auto& hop : hops)
+  {
+    ASSERT_EQ(table.Get(hop->info.txID, hop->info.downstream, Any), nullptr);
+    ASSERT_EQ(table.Get(hop->info.rxID, hop->info.upstream, Any), nullptr);
+  }
+}
+
+TEST_F(TransitHopTableTest, GrowsAndShrinks)
+{
+  std::vector< TransitHop_ptr > hops;
+  for(size_t idx = 0; idx < 5000; ++idx)
+  {
+    hops.emplace_back(MakeHop(idx % 10));
+    table.Put(hops.back());
+  }
+  for(const auto& hop : hops)
+  {
+    ASSERT_EQ(table.Get(hop->info.txID, hop->info.downstream, Any), hop);
+    ASSERT_EQ(table.Get(hop->info.rxID, hop->info.upstream, Any), hop);
+  }
+  table.Expire(1005);
+  ASSERT_EQ(table.Size(), 2000u);
+  for(const auto& hop : hops)
+  {
+    const auto found =
+        table.Get(hop->info.txID, hop->info.downstream, Any) != nullptr;
+    ASSERT_EQ(found, hop->started > 5);
+  }
+}
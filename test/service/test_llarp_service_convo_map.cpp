@@ -0,0 +1,151 @@
+#include <service/convo_map.hpp>
+
+#include <crypto/crypto.hpp>
+#include <crypto/crypto_libsodium.hpp>
+#include <llarp_test.hpp>
+#include <service/identity.hpp>
+
+#include <random>
+
+#include <gtest/gtest.h>
+
+using namespace llarp;
+
+struct ConvoMapTest : public test::LlarpTest< sodium::CryptoLibSodium >
+{
+  static constexpr llarp_time_t lifetime = path::default_lifetime * 2;
+
+  service::ConvoMap convos;
+  service::Identity alice, bob;
+
+  ConvoMapTest()
+  {
+    alice.RegenerateKeys();
+    bob.RegenerateKeys();
+  }
+
+  static service::ConvoTag
+  MakeTag()
+  {
+    service::ConvoTag tag;
+    tag.Randomize();
+    return tag;
+  }
+
+  service::ConvoTag
+  Put(const service::ServiceInfo& remote, llarp_time_t now,
+      bool inbound = false)
+  {
+    const auto tag = MakeTag();
+    convos.Put(tag, [&](service::Session& s, bool created) {
+      EXPECT_TRUE(created);
+      s.remote   = remote;
+      s.inbound  = inbound;
+      s.lastUsed = now;
+      // intro outlives the idle timeout
+      s.intro.expiresAt = now + lifetime * 2;
+    });
+    return tag;
+  }
+};
+
+TEST_F(ConvoMapTest, TestTagsByAddress)
+{
+  const auto a1 = Put(alice.pub, 1000);
+  const auto a2 = Put(alice.pub, 1000);
+  const auto b1 = Put(bob.pub, 1000);
+  ASSERT_EQ(convos.Size(), 3u);
+
+  std::set< service::ConvoTag > tags;
+  ASSERT_TRUE(convos.GetTagsFor(alice.pub.Addr(), tags));
+  ASSERT_EQ(tags, (std::set< service::ConvoTag >{a1, a2}));
+  // nothing new the second time
+  ASSERT_FALSE(convos.GetTagsFor(alice.pub.Addr(), tags));
+
+  // changing the remote moves the tag
+  ASSERT_TRUE(
+      convos.Visit(a2, [&](service::Session& s) { s.remote = bob.pub; }));
+  tags.clear();
+  ASSERT_TRUE(convos.GetTagsFor(bob.pub.Addr(), tags));
+  ASSERT_EQ(tags, (std::set< service::ConvoTag >{a2, b1}));
+
+  ASSERT_TRUE(convos.Erase(a1));
+  ASSERT_FALSE(convos.Erase(a1));
+  tags.clear();
+  ASSERT_FALSE(convos.GetTagsFor(alice.pub.Addr(), tags));
+  ASSERT_EQ(convos.Find(a1), nullptr);
+  ASSERT_NE(convos.Find(b1), nullptr);
+  ASSERT_FALSE(convos.Visit(a1, [](service::Session&) {}));
+}
+
+TEST_F(ConvoMapTest, TestHasInbound)
+{
+  const auto tag = Put(alice.pub, 1000);
+  ASSERT_FALSE(convos.HasInbound(alice.pub.Addr()));
+  Put(alice.pub, 1000, true);
+  ASSERT_TRUE(convos.HasInbound(alice.pub.Addr()));
+  ASSERT_FALSE(convos.HasInbound(bob.pub.Addr()));
+
+  // put on an existing tag keeps it
+  convos.Put(tag, [](service::Session& s, bool created) {
+    ASSERT_FALSE(created);
+    s.inbound = true;
+  });
+  ASSERT_EQ(convos.Size(), 2u);
+}
+
+TEST_F(ConvoMapTest, TestExpireIdle)
+{
+  const auto tag = Put(alice.pub, 1000);
+  Put(bob.pub, 2000);
+
+  std::vector< service::ConvoTag > expired;
+  const auto visit = [&](const service::ConvoTag& t) {
+    expired.emplace_back(t);
+  };
+  convos.Expire(1000 + lifetime, visit);
+  ASSERT_TRUE(expired.empty());
+
+  // touching it pushes it back
+  ASSERT_TRUE(
+      convos.Visit(tag, [](service::Session& s) { s.lastUsed = 1500; }));
+  convos.Expire(1001 + lifetime, visit);
+  ASSERT_TRUE(expired.empty());
+
+  convos.Expire(1501 + lifetime, visit);
+  ASSERT_EQ(expired, std::vector< service::ConvoTag >{tag});
+  ASSERT_EQ(convos.Size(), 1u);
+  std::set< service::ConvoTag > tags;
+  ASSERT_FALSE(convos.GetTagsFor(alice.pub.Addr(), tags));
+}
+
+TEST_F(ConvoMapTest, TestExpireMatchesIsExpired)
+{
+  // random idle times and intro expiries, after every step the map must
+  // hold exactly the sessions IsExpired keeps
+  std::mt19937_64 rng(42);
+  std::uniform_int_distribution< llarp_time_t > dist(0, lifetime * 2);
+  std::vector< service::ConvoTag > all;
+  for(size_t idx = 0; idx < 200; ++idx)
+  {
+    all.emplace_back(MakeTag());
+    convos.Put(all.back(), [&](service::Session& s, bool) {
+      s.remote          = idx % 2 ? alice.pub : bob.pub;
+      s.lastUsed        = dist(rng);
+      s.intro.expiresAt = dist(rng);
+    });
+  }
+  std::vector< service::Session > sessions;
+  for(const auto& tag : all)
+    sessions.emplace_back(*convos.Find(tag));
+
+  for(llarp_time_t now = 0; now <= lifetime * 4; now += lifetime / 16)
+  {
+    convos.Expire(now, [](const service::ConvoTag&) {});
+    for(size_t idx = 0; idx < all.size(); ++idx)
+    {
+      ASSERT_EQ(convos.Contains(all[idx]), !sessions[idx].IsExpired(now))
+          << "now=" << now;
+    }
+  }
+}
@@ -44,6 +44,43 @@ TEST_F(HiddenServiceTest, TestGenerateIntroSet)
   ASSERT_TRUE(I.Verify(now));
 }
 
+struct IntroSetResignTest
+    : public test::LlarpTest< sodium::CryptoLibSodium >
+{
+};
+
+TEST_F(IntroSetResignTest, TestResignAfterDecode)
+{
+  service::Identity ident;
+  ident.RegenerateKeys();
+  const auto now = time_now_ms();
+  service::IntroSet I;
+  for(size_t idx = 0; idx < 2; ++idx)
+  {
+    service::Introduction intro;
+    intro.expiresAt = now + (path::default_lifetime / 2);
+    intro.router.Randomize();
+    intro.pathID.Randomize();
+    I.I.emplace_back(std::move(intro));
+  }
+  ASSERT_TRUE(ident.SignIntroSet(I, now));
+
+  std::array< byte_t, service::MAX_INTROSET_SIZE > tmp;
+  llarp_buffer_t buf(tmp);
+  ASSERT_TRUE(I.BEncode(&buf));
+  buf.sz  = buf.cur - buf.base;
+  buf.cur = buf.base;
+  service::IntroSet decoded;
+  ASSERT_TRUE(decoded.BDecode(&buf));
+  ASSERT_TRUE(decoded.Verify(now));
+
+  // what is checked is the fields as they are now, not what was decoded
+  decoded.I.pop_back();
+  ASSERT_FALSE(decoded.Verify(now));
+  ASSERT_TRUE(ident.SignIntroSet(decoded, now + 1));
+  ASSERT_TRUE(decoded.Verify(now + 1));
+}
+
 TEST_F(HiddenServiceTest, TestAddressToFromString)
 {
   auto str = ident.pub.Addr().ToString();
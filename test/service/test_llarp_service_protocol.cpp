@@ -0,0 +1,102 @@
+#include <crypto/crypto.hpp>
+#include <crypto/crypto_libsodium.hpp>
+#include <llarp_test.hpp>
+#include <service/identity.hpp>
+#include <service/protocol.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace llarp;
+
+struct ProtocolFrameTest : public test::LlarpTest< sodium::CryptoLibSodium >
+{
+  service::Identity ident;
+  SharedSecret sessionKey;
+  service::ProtocolMessage msg;
+
+  ProtocolFrameTest()
+  {
+    ident.RegenerateKeys();
+    sessionKey.Randomize();
+    msg.tag.Randomize();
+    msg.sender = ident.pub;
+    msg.seqno  = 1;
+    std::vector< byte_t > payload(1024, 'x');
+    msg.PutBuffer(llarp_buffer_t(payload));
+  }
+
+  service::ProtocolFrame
+  MakeFrame()
+  {
+    service::ProtocolFrame frame;
+    frame.N.Randomize();
+    frame.T = msg.tag;
+    frame.F.Randomize();
+    return frame;
+  }
+
+  /// encode and decode like the frame went over the wire
+  static bool
+  Transfer(const service::ProtocolFrame& frame, service::ProtocolFrame& out)
+  {
+    std::array< byte_t, service::MAX_PROTOCOL_MESSAGE_SIZE > tmp;
+    llarp_buffer_t buf(tmp);
+    if(!frame.BEncode(&buf))
+      return false;
+    buf.sz  = buf.cur - buf.base;
+    buf.cur = buf.base;
+    return out.BDecode(&buf);
+  }
+};
+
+TEST_F(ProtocolFrameTest, TestSigned)
+{
+  auto frame = MakeFrame();
+  ASSERT_TRUE(frame.EncryptAndSign(msg, sessionKey, ident));
+  ASSERT_TRUE(frame.M.IsZero());
+
+  service::ProtocolFrame other;
+  ASSERT_TRUE(Transfer(frame, other));
+  ASSERT_EQ(frame, other);
+  ASSERT_TRUE(other.Verify(ident.pub));
+
+  service::ProtocolMessage inner;
+  ASSERT_TRUE(other.DecryptPayloadInto(sessionKey, inner));
+  ASSERT_EQ(inner.payload, msg.payload);
+  ASSERT_EQ(inner.version, service::eProtocolVersionFrameMAC);
+
+  other.F.Randomize();
+  ASSERT_FALSE(other.Verify(ident.pub));
+}
+
+TEST_F(ProtocolFrameTest, TestMAC)
+{
+  auto frame = MakeFrame();
+  ASSERT_TRUE(frame.EncryptAndMAC(msg, sessionKey));
+  ASSERT_FALSE(frame.M.IsZero());
+  ASSERT_TRUE(frame.Z.IsZero());
+
+  service::ProtocolFrame other;
+  ASSERT_TRUE(Transfer(frame, other));
+  ASSERT_EQ(frame, other);
+  ASSERT_TRUE(other.VerifyMAC(sessionKey));
+
+  service::ProtocolMessage inner;
+  ASSERT_TRUE(other.DecryptPayloadInto(sessionKey, inner));
+  ASSERT_EQ(inner.payload, msg.payload);
+
+  SharedSecret wrongKey;
+  wrongKey.Randomize();
+  ASSERT_FALSE(other.VerifyMAC(wrongKey));
+
+  other.D.data()[0] ^= 1;
+  ASSERT_FALSE(other.VerifyMAC(sessionKey));
+}
+
+TEST_F(ProtocolFrameTest, TestMACIsNotSignature)
+{
+  // a frame with a mac never passes for a signed one
+  auto frame = MakeFrame();
+  ASSERT_TRUE(frame.EncryptAndMAC(msg, sessionKey));
+  ASSERT_FALSE(frame.Verify(ident.pub));
+}
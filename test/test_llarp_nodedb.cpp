@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+
+#include <crypto/crypto.hpp>
+#include <crypto/crypto_libsodium.hpp>
+#include <llarp_test.hpp>
+#include <nodedb.hpp>
+#include <router_contact.hpp>
+#include <util/thread/thread_pool.hpp>
+#include <util/time.hpp>
+
+#include <algorithm>
+#include <map>
+
+using namespace ::llarp;
+
+struct NodeDBTest : public ::testing::Test
+{
+  std::shared_ptr< thread::ThreadPool > disk =
+      std::make_shared< thread::ThreadPool >(1, 1024, "disk");
+  llarp_nodedb db{disk};
+
+  void
+  SetUp() override
+  {
+    disk->start();
+  }
+
+  void
+  TearDown() override
+  {
+    disk->stop();
+  }
+
+  static RouterContact
+  MakeRC(bool exit = false)
+  {
+    RouterContact rc;
+    rc.pubkey.Randomize();
+    rc.enckey.Randomize();
+    rc.last_updated = time_now_ms();
+    rc.addrs.emplace_back();
+    if(exit)
+      rc.exits.emplace_back(rc.pubkey, nuint32_t{50000});
+    return rc;
+  }
+
+  std::vector< RouterID >
+  Fill(size_t n)
+  {
+    std::vector< RouterID > ids;
+    for(size_t idx = 0; idx < n; ++idx)
+    {
+      const RouterContact rc = MakeRC();
+      db.Put(rc);
+      ids.emplace_back(rc.pubkey);
+    }
+    return ids;
+  }
+};
+
+TEST_F(NodeDBTest, TestSelectHopExcluding)
+{
+  const auto ids = Fill(8);
+  std::set< RouterID > exclude(ids.begin(), ids.begin() + 7);
+  RouterContact rc;
+  for(size_t idx = 0; idx < 100; ++idx)
+  {
+    ASSERT_TRUE(db.select_random_hop_excluding(rc, exclude));
+    ASSERT_EQ(RouterID(rc.pubkey), ids[7]);
+  }
+  exclude.insert(ids[7]);
+  ASSERT_FALSE(db.select_random_hop_excluding(rc, exclude));
+}
+
+TEST_F(NodeDBTest, TestSelectHopCoversAll)
+{
+  const auto ids = Fill(16);
+  std::set< RouterID > seen;
+  RouterContact rc;
+  for(size_t idx = 0; idx < 1000; ++idx)
+  {
+    ASSERT_TRUE(db.select_random_hop_excluding(rc, {}));
+    seen.emplace(rc.pubkey);
+  }
+  ASSERT_EQ(seen.size(), ids.size());
+}
+
+TEST_F(NodeDBTest, TestSelectHopSkipsNoAddrs)
+{
+  Fill(4);
+  RouterContact noaddrs = MakeRC();
+  noaddrs.addrs.clear();
+  db.Put(noaddrs);
+  RouterContact rc;
+  for(size_t idx = 0; idx < 200; ++idx)
+  {
+    ASSERT_TRUE(db.select_random_hop_excluding(rc, {}));
+    ASSERT_NE(rc.pubkey, noaddrs.pubkey);
+  }
+}
+
+TEST_F(NodeDBTest, TestSelectHopWeighted)
+{
+  const auto ids = Fill(8);
+  const RouterID favoured = ids[3];
+  const auto weight       = [&](const RouterID &r) -> double {
+    return r == favoured ? 1.0 : 0.0;
+  };
+  RouterContact rc;
+  for(size_t idx = 0; idx < 100; ++idx)
+  {
+    ASSERT_TRUE(db.select_random_hop_excluding(rc, {}, weight));
+    ASSERT_EQ(RouterID(rc.pubkey), favoured);
+  }
+}
+
+TEST_F(NodeDBTest, TestIndexFollowsRemoveAndReplace)
+{
+  auto ids = Fill(8);
+  // replacing an rc must not leave a stale index entry behind
+  RouterContact replaced = MakeRC();
+  std::copy(ids[0].begin(), ids[0].end(), replaced.pubkey.begin());
+  db.Put(replaced);
+  ASSERT_EQ(db.num_loaded(), 8u);
+  ASSERT_EQ(db.hops.size(), 8u);
+
+  ASSERT_TRUE(db.Remove(ids[1]));
+  ASSERT_TRUE(db.Remove(ids[5]));
+  ASSERT_EQ(db.hops.size(), 6u);
+  RouterContact rc;
+  for(size_t idx = 0; idx < 200; ++idx)
+  {
+    ASSERT_TRUE(db.select_random_hop_excluding(rc, {}));
+    ASSERT_NE(RouterID(rc.pubkey), ids[1]);
+    ASSERT_NE(RouterID(rc.pubkey), ids[5]);
+  }
+  db.Clear();
+  ASSERT_FALSE(db.select_random_hop_excluding(rc, {}));
+}
+
+TEST_F(NodeDBTest, TestSelectExit)
+{
+  Fill(8);
+  RouterContact rc;
+  ASSERT_FALSE(db.select_random_exit(rc));
+  const RouterContact exit = MakeRC(true);
+  db.Put(exit);
+  for(size_t idx = 0; idx < 50; ++idx)
+  {
+    ASSERT_TRUE(db.select_random_exit(rc));
+    ASSERT_EQ(rc.pubkey, exit.pubkey);
+  }
+}
+
+struct NodeDBLoadTest : public test::LlarpTest< sodium::CryptoLibSodium >
+{
+  std::shared_ptr< thread::ThreadPool > disk =
+      std::make_shared< thread::ThreadPool >(1, 1024, "disk");
+  llarp_nodedb db{disk};
+  fs::path dir;
+
+  void
+  SetUp() override
+  {
+    RouterID r;
+    r.Randomize();
+    dir = fs::temp_directory_path() / ("nodedb-" + r.ToHex());
+    ASSERT_TRUE(llarp_nodedb::ensure_dir(dir.string().c_str()));
+    db.set_dir(dir.string().c_str());
+  }
+
+  void
+  TearDown() override
+  {
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+  }
+
+  /// write n signed rcs to disk, returns their ids
+  std::vector< RouterID >
+  WriteRCs(size_t n)
+  {
+    std::vector< RouterID > ids;
+    SecretKey sk;
+    for(size_t idx = 0; idx < n; ++idx)
+    {
+      m_crypto.identity_keygen(sk);
+      RouterContact rc;
+      rc.enckey.Randomize();
+      EXPECT_TRUE(rc.Sign(sk));
+      EXPECT_TRUE(rc.Write(db.getRCFilePath(rc.pubkey).c_str()));
+      ids.emplace_back(rc.pubkey);
+    }
+    return ids;
+  }
+};
+
+TEST_F(NodeDBLoadTest, TestLoadVerifies)
+{
+  const auto ids = WriteRCs(200);
+  // break the signature of one
+  {
+    RouterContact rc;
+    const auto path = db.getRCFilePath(ids[42]);
+    ASSERT_TRUE(rc.Read(path.c_str()));
+    rc.signature.Randomize();
+    ASSERT_TRUE(rc.Write(path.c_str()));
+  }
+  ASSERT_EQ(db.Load(dir), 199);
+  ASSERT_EQ(db.num_loaded(), 199u);
+  ASSERT_FALSE(db.Has(ids[42]));
+  for(size_t idx = 0; idx < ids.size(); ++idx)
+  {
+    if(idx != 42)
+    {
+      ASSERT_TRUE(db.Has(ids[idx]));
+    }
+  }
+}
+
+TEST_F(NodeDBLoadTest, TestLoadMissingDir)
+{
+  ASSERT_EQ(db.Load(dir / "nope"), -1);
+}
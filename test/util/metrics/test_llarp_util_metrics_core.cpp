@@ -1,7 +1,9 @@
 #include <util/metrics/core.hpp>
 
 #include <array>
+#include <atomic>
 #include <thread>
+#include <vector>
 
 #include <test_util.hpp>
 
@@ -97,12 +99,150 @@ TYPED_TEST_P(CollectorTest, Collector)
   ASSERT_THAT(record1.data, IsEmpty());
 }
 
-REGISTER_TYPED_TEST_SUITE_P(CollectorTest, Collector);
+TYPED_TEST_P(CollectorTest, CollectorInterned)
+{
+  constexpr size_t NUM_THREADS = 4;
+  constexpr size_t NUM_TICKS   = 1000;
+  // more tag sets than a shard has slots, so some take the locked path
+  constexpr size_t NUM_TAGS = 100;
+
+  TypeParam collector(METRIC_A);
+
+  std::vector< TagsId > ids;
+  for(size_t i = 0; i < NUM_TAGS; ++i)
+  {
+    ids.push_back(TagTable::intern(packToTags("tag", std::to_string(i))));
+  }
+
+  std::vector< std::thread > threads;
+  for(size_t t = 0; t < NUM_THREADS; ++t)
+  {
+    threads.emplace_back([&, t]() {
+      for(size_t i = 0; i < NUM_TICKS; ++i)
+      {
+        collector.tickInterned(static_cast< int >(t + 1), ids[i % NUM_TAGS]);
+      }
+    });
+  }
+  for(auto &thread : threads)
+  {
+    thread.join();
+  }
+
+  auto record = collector.load();
+  ASSERT_THAT(record.data, SizeIs(NUM_TAGS));
+  const Tags tags = packToTags("tag", std::string("0"));
+  ASSERT_THAT(record.data, Contains(Key(tags)));
+  ASSERT_EQ(NUM_THREADS * NUM_TICKS / NUM_TAGS, record.data.at(tags).count());
+  ASSERT_EQ(100, record.data.at(tags).total());
+  ASSERT_EQ(1, record.data.at(tags).min());
+  ASSERT_EQ(4, record.data.at(tags).max());
+
+  // interned and plain ticks of the same tags end up in one record
+  collector.tick(10, "tag", std::string("0"));
+  record = collector.loadAndClear();
+  ASSERT_EQ(NUM_THREADS * NUM_TICKS / NUM_TAGS + 1,
+            record.data.at(tags).count());
+  ASSERT_EQ(110, record.data.at(tags).total());
+  ASSERT_EQ(10, record.data.at(tags).max());
+
+  record = collector.load();
+  ASSERT_THAT(record.data, IsEmpty());
+
+  // set overwrites what the shards hold
+  collector.tickInterned(5, ids[0]);
+  collector.set(1, 2, 2, 2, "tag", std::string("0"));
+  record = collector.load();
+  ASSERT_EQ(1u, record.data.at(tags).count());
+  ASSERT_EQ(2, record.data.at(tags).total());
+}
+
+REGISTER_TYPED_TEST_SUITE_P(CollectorTest, Collector, CollectorInterned);
 
 using CollectorTestTypes = ::testing::Types< DoubleCollector, IntCollector >;
 
 INSTANTIATE_TYPED_TEST_SUITE_P(MetricsCore, CollectorTest, CollectorTestTypes);
 
+TEST(MetricsCore, ShardSlotsRecycle)
+{
+  using Shards            = CollectorShards< int >;
+  constexpr size_t PERIODS = 4;
+
+  Shards shards;
+  for(size_t period = 0; period < PERIODS; ++period)
+  {
+    // a full shard worth of tag sets we never tick again
+    for(size_t i = 0; i < Shards::NUM_SLOTS; ++i)
+    {
+      const TagsId id = TagTable::intern(packToTags(
+          "recycle", std::to_string(period * Shards::NUM_SLOTS + i)));
+      ASSERT_TRUE(shards.tick(id, 1)) << period << " " << i;
+    }
+    TaggedRecords< int > records(METRIC_A);
+    shards.merge(records, true);
+    ASSERT_THAT(records.data, SizeIs(Shards::NUM_SLOTS));
+    // idle for a whole period, so their slots go back
+    TaggedRecords< int > idle(METRIC_A);
+    shards.merge(idle, true);
+    ASSERT_THAT(idle.data, IsEmpty());
+  }
+}
+
+TEST(MetricsCore, ShardSlotReleaseRacesTick)
+{
+  using Shards              = CollectorShards< int >;
+  constexpr size_t THREADS = 4;
+  constexpr size_t TICKS   = 2000;
+
+  Shards shards;
+  std::array< TagsId, THREADS > ids;
+  for(size_t i = 0; i < THREADS; ++i)
+  {
+    ids[i] = TagTable::intern(packToTags("race", std::to_string(i)));
+  }
+
+  // tickers go idle often so merges keep handing their slots back while
+  // ticks are landing in them
+  std::atomic< size_t > running{THREADS};
+  std::vector< std::thread > threads;
+  for(size_t i = 0; i < THREADS; ++i)
+  {
+    threads.emplace_back([&, i]() {
+      for(size_t n = 0; n < TICKS; ++n)
+      {
+        while(!shards.tick(ids[i], 1))
+        {
+          std::this_thread::yield();
+        }
+        for(size_t idle = 0; idle < (n + i) % 4; ++idle)
+        {
+          std::this_thread::yield();
+        }
+      }
+      --running;
+    });
+  }
+
+  TaggedRecords< int > records(METRIC_A);
+  while(running.load() != 0)
+  {
+    shards.merge(records, true);
+    std::this_thread::yield();
+  }
+  for(auto &thread : threads)
+  {
+    thread.join();
+  }
+  shards.merge(records, true);
+
+  for(const TagsId id : ids)
+  {
+    const Record< int > &rec = records.data.at(TagTable::lookup(id));
+    ASSERT_EQ(rec.count(), TICKS);
+    ASSERT_EQ(rec.total(), int(TICKS));
+  }
+}
+
 TEST(MetricsCore, Registry)
 {
   Registry registry;
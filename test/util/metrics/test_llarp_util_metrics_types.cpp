@@ -139,6 +139,24 @@ TEST(MetricsTypes, Record)
   ASSERT_GT(r.min(), r.max());
 }
 
+TEST(MetricsTypes, TagTable)
+{
+  ASSERT_EQ(TagTable::UNTAGGED, TagTable::intern(Tags()));
+  ASSERT_THAT(TagTable::lookup(TagTable::UNTAGGED), IsEmpty());
+
+  Tags tags{{"id", std::string("abc")}, {"n", std::int64_t(1)}};
+  const size_t size = TagTable::size();
+  const TagsId id   = TagTable::intern(tags);
+  ASSERT_NE(TagTable::UNTAGGED, id);
+  ASSERT_EQ(id, TagTable::intern(tags));
+  ASSERT_EQ(tags, TagTable::lookup(id));
+  ASSERT_EQ(size + 1, TagTable::size());
+
+  Tags other{{"id", std::string("abd")}};
+  ASSERT_NE(id, TagTable::intern(other));
+  ASSERT_EQ(other, TagTable::lookup(TagTable::intern(other)));
+}
+
 TEST(MetricsTypes, Sample)
 {
   metrics::Category myCategory("MyCategory");
@@ -0,0 +1,170 @@
+#include <util/codel.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace llarp;
+
+namespace
+{
+  struct Item
+  {
+    Item() = default;
+
+    Item(size_t _from, size_t _seq) : from(_from), seq(_seq)
+    {
+    }
+
+    llarp_time_t timestamp = 0;
+    size_t from            = 0;
+    size_t seq             = 0;
+  };
+
+  /// time the tests move by hand
+  std::atomic< llarp_time_t > testNow{0};
+
+  struct GetTime
+  {
+    llarp_time_t
+    operator()(const Item& item) const
+    {
+      return item.timestamp;
+    }
+  };
+
+  struct PutTime
+  {
+    void
+    operator()(Item& item) const
+    {
+      item.timestamp = testNow.load();
+    }
+  };
+
+  struct GetNow
+  {
+    llarp_time_t
+    operator()() const
+    {
+      return testNow.load();
+    }
+  };
+
+  using Ring_t = util::CoDelRing< Item, GetTime, PutTime, GetNow >;
+  using SmallRing_t =
+      util::CoDelRing< Item, GetTime, PutTime, GetNow, 5, 100, 8 >;
+
+  std::vector< Item >
+  Drain(Ring_t& ring)
+  {
+    std::vector< Item > items;
+    ring.Process([&](Item& item) { items.emplace_back(item); });
+    return items;
+  }
+}  // namespace
+
+struct CoDelRingTest : public ::testing::Test
+{
+  void
+  SetUp() override
+  {
+    testNow.store(1000);
+  }
+};
+
+TEST_F(CoDelRingTest, TestInOrder)
+{
+  Ring_t ring("test", PutTime{}, GetNow{});
+  for(size_t idx = 0; idx < 100; ++idx)
+    ring.Emplace(0, idx);
+  ASSERT_EQ(ring.Size(), 100u);
+
+  const auto items = Drain(ring);
+  ASSERT_EQ(items.size(), 100u);
+  for(size_t idx = 0; idx < items.size(); ++idx)
+    ASSERT_EQ(items[idx].seq, idx);
+  ASSERT_EQ(ring.Size(), 0u);
+  ASSERT_EQ(ring.Dropped(), 0u);
+}
+
+TEST_F(CoDelRingTest, TestFullAndPredicate)
+{
+  SmallRing_t ring("test", PutTime{}, GetNow{});
+  ASSERT_FALSE(ring.EmplaceIf([](Item&) { return false; }, 0, 0));
+  for(size_t idx = 0; idx < 8; ++idx)
+    ASSERT_TRUE(ring.EmplaceIf([](Item&) { return true; }, 0, idx));
+  ASSERT_FALSE(ring.EmplaceIf([](Item&) { return true; }, 0, 8));
+
+  size_t seen = 0;
+  ring.Process([&](Item&) { ++seen; });
+  ASSERT_EQ(seen, 8u);
+  // buffers come back to the producer
+  for(size_t idx = 0; idx < 8; ++idx)
+    ASSERT_TRUE(ring.EmplaceIf([](Item&) { return true; }, 0, idx));
+}
+
+TEST_F(CoDelRingTest, TestDropsStandingQueue)
+{
+  Ring_t ring("test", PutTime{}, GetNow{});
+  // waited past target, start the interval
+  ring.Emplace(0, 0);
+  testNow += 50;
+  ASSERT_EQ(Drain(ring).size(), 1u);
+
+  // still above target a whole interval later, drop the first one only
+  ring.Emplace(0, 1);
+  ring.Emplace(0, 2);
+  testNow += 150;
+  auto items = Drain(ring);
+  ASSERT_EQ(items.size(), 1u);
+  ASSERT_EQ(items[0].seq, 2u);
+  ASSERT_EQ(ring.Dropped(), 1u);
+
+  // below target again, nothing dropped
+  ring.Emplace(0, 3);
+  items = Drain(ring);
+  ASSERT_EQ(items.size(), 1u);
+  ASSERT_EQ(ring.Dropped(), 1u);
+}
+
+TEST_F(CoDelRingTest, TestManyProducers)
+{
+  // more producers than shards so some share the last one
+  constexpr size_t Producers = 6;
+  constexpr size_t PerThread = 5000;
+  Ring_t ring("test", PutTime{}, GetNow{});
+
+  std::vector< size_t > next(Producers, 0);
+  size_t seen = 0;
+  std::atomic< size_t > done{0};
+  std::vector< std::thread > threads;
+  for(size_t t = 0; t < Producers; ++t)
+  {
+    threads.emplace_back([&, t]() {
+      for(size_t idx = 0; idx < PerThread;)
+      {
+        if(ring.EmplaceIf([](Item&) { return true; }, t, idx))
+          ++idx;
+        else
+          std::this_thread::yield();
+      }
+      ++done;
+    });
+  }
+
+  const auto visit = [&](Item& item) {
+    ASSERT_EQ(item.seq, next[item.from]++);
+    ++seen;
+  };
+  while(done.load() < Producers)
+    ring.Process(visit);
+  for(auto& thread : threads)
+    thread.join();
+  ring.Process(visit);
+
+  ASSERT_EQ(seen, Producers * PerThread);
+  ASSERT_EQ(ring.Dropped(), 0u);
+}
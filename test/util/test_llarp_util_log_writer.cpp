@@ -0,0 +1,205 @@
+#include <util/logging/log_writer.hpp>
+#include <util/logging/logger.hpp>
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace llarp;
+
+namespace
+{
+  /// keeps what it is handed, optionally holding up the caller
+  struct CaptureLogStream : public ILogStream
+  {
+    struct Line
+    {
+      LogLevel lvl;
+      std::string msg;
+      std::string thread;
+    };
+
+    std::mutex access;
+    std::condition_variable cond;
+    bool blocked = false;
+    std::vector< Line > lines;
+
+    void
+    PreLog(std::stringstream&, LogLevel, const char*, int,
+           const std::string&) const override
+    {
+    }
+
+    void
+    Print(LogLevel, const char*, const std::string&) override
+    {
+    }
+
+    void
+    PostLog(std::stringstream&) const override
+    {
+    }
+
+    void
+    AppendLog(LogLevel lvl, const char*, int, const std::string&,
+              const std::string msg) override
+    {
+      std::unique_lock< std::mutex > lock(access);
+      cond.wait(lock, [&]() { return !blocked; });
+      lines.emplace_back(Line{lvl, msg, thread_id_string()});
+    }
+
+    void
+    Tick(llarp_time_t) override
+    {
+    }
+
+    void
+    SetBlocked(bool block)
+    {
+      std::lock_guard< std::mutex > lock(access);
+      blocked = block;
+      cond.notify_all();
+    }
+  };
+
+  /// logs a line of its own while it is printed
+  struct LogsWhenPrinted
+  {
+  };
+
+  std::ostream&
+  operator<<(std::ostream& out, const LogsWhenPrinted&)
+  {
+    LogInfo("inner");
+    return out << "printed";
+  }
+}  // namespace
+
+TEST(LogWriterTest, TestPrintsInOrderPerThread)
+{
+  constexpr size_t Threads   = 4;
+  constexpr size_t PerThread = 200;
+  CaptureLogStream stream;
+  LogWriter writer;
+  writer.Start(&stream, "test");
+
+  std::map< std::string, size_t > threadOf;
+  std::vector< std::thread > threads;
+  std::mutex idAccess;
+  for(size_t t = 0; t < Threads; ++t)
+  {
+    threads.emplace_back([&, t]() {
+      {
+        std::lock_guard< std::mutex > lock(idAccess);
+        threadOf[thread_id_string()] = t;
+      }
+      for(size_t idx = 0; idx < PerThread; ++idx)
+      {
+        ASSERT_TRUE(writer.Push(eLogInfo, "test", __LINE__,
+                                std::to_string(t) + ":" + std::to_string(idx)));
+      }
+    });
+  }
+  for(auto& thread : threads)
+    thread.join();
+  writer.Stop();
+
+  ASSERT_EQ(stream.lines.size(), Threads * PerThread);
+  ASSERT_EQ(writer.Dropped(), 0u);
+  std::vector< size_t > next(Threads, 0);
+  for(const auto& line : stream.lines)
+  {
+    const auto sep = line.msg.find(':');
+    const size_t t = std::stoul(line.msg.substr(0, sep));
+    ASSERT_EQ(std::stoul(line.msg.substr(sep + 1)), next[t]++);
+    // printed with the id of the thread that logged it
+    if(threadOf.size() == Threads)
+    {
+      ASSERT_EQ(threadOf[line.thread], t);
+    }
+  }
+}
+
+TEST(LogWriterTest, TestDropsWhenFull)
+{
+  CaptureLogStream stream;
+  stream.SetBlocked(true);
+  LogWriter writer;
+  writer.Start(&stream, "test");
+  const size_t pushed = LogWriter::RingSize * 2;
+  for(size_t idx = 0; idx < pushed; ++idx)
+    writer.Push(eLogInfo, "test", __LINE__, "line");
+  ASSERT_GT(writer.Dropped(), 0u);
+  stream.SetBlocked(false);
+  writer.Stop();
+
+  size_t printed = 0;
+  bool reported  = false;
+  for(const auto& line : stream.lines)
+  {
+    if(line.msg == "line")
+      ++printed;
+    else if(line.lvl == eLogWarn)
+      reported = true;
+  }
+  ASSERT_TRUE(reported);
+  ASSERT_EQ(printed + writer.Dropped(), pushed);
+}
+
+TEST(LogWriterTest, TestLogContextSyncAndAsync)
+{
+  auto& ctx    = LogContext::Instance();
+  auto* stream = new CaptureLogStream();
+  ILogStream_ptr old(stream);
+  std::swap(old, ctx.logStream);
+  const auto oldLevel = ctx.minLevel;
+  SetLogLevel(eLogInfo);
+
+  LogInfo("sync ", 1);
+  LogDebug("too low");
+  ASSERT_EQ(stream->lines.size(), 1u);
+  ASSERT_EQ(stream->lines[0].msg, "sync 1");
+
+  // manipulators do not leak into the next line
+  LogInfo(std::hex, 255);
+  LogInfo(255);
+  ASSERT_EQ(stream->lines[1].msg, "ff");
+  ASSERT_EQ(stream->lines[2].msg, "255");
+
+  ctx.StartWriter();
+  LogWarn("async ", 2);
+  ctx.StopWriter();
+  ASSERT_EQ(stream->lines.size(), 4u);
+  ASSERT_EQ(stream->lines[3].msg, "async 2");
+  ASSERT_EQ(stream->lines[3].lvl, eLogWarn);
+
+  SetLogLevel(oldLevel);
+  std::swap(old, ctx.logStream);
+}
+
+TEST(LogWriterTest, TestLogWhileFormatting)
+{
+  auto& ctx    = LogContext::Instance();
+  auto* stream = new CaptureLogStream();
+  ILogStream_ptr old(stream);
+  std::swap(old, ctx.logStream);
+  const auto oldLevel = ctx.minLevel;
+  SetLogLevel(eLogInfo);
+
+  LogInfo("outer ", LogsWhenPrinted{}, " done");
+  ASSERT_EQ(stream->lines.size(), 2u);
+  ASSERT_EQ(stream->lines[0].msg, "inner");
+  ASSERT_EQ(stream->lines[1].msg, "outer printed done");
+
+  // the next line gets the per thread buffer again
+  LogInfo("after");
+  ASSERT_EQ(stream->lines[2].msg, "after");
+
+  SetLogLevel(oldLevel);
+  std::swap(old, ctx.logStream);
+}
@@ -0,0 +1,164 @@
+#include <util/thread/task_queue.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace llarp;
+using namespace llarp::thread;
+
+TEST(TaskTest, TestInlineAndHeap)
+{
+  int calls = 0;
+  Task small([&calls]() { ++calls; });
+  ASSERT_TRUE(bool(small));
+  small();
+
+  std::array< uint64_t, 16 > big{};
+  big[15] = 2;
+  Task large([&calls, big]() { calls += int(big[15]); });
+  large();
+  ASSERT_EQ(calls, 3);
+
+  ASSERT_TRUE(Task::IsInline< std::function< void() > >());
+  ASSERT_FALSE(Task::IsInline< decltype(big) >());
+}
+
+TEST(TaskTest, TestMoveOnly)
+{
+  auto value = std::make_unique< int >(42);
+  int got    = 0;
+  Task task([&got, v = std::move(value)]() { got = *v; });
+  Task moved(std::move(task));
+  ASSERT_FALSE(bool(task));
+  moved();
+  ASSERT_EQ(got, 42);
+
+  Task assigned;
+  assigned = std::move(moved);
+  ASSERT_FALSE(bool(moved));
+  ASSERT_TRUE(bool(assigned));
+}
+
+TEST(TaskTest, TestDestroysCaptures)
+{
+  auto counted = std::make_shared< int >(0);
+  std::array< uint64_t, 16 > big{};
+  {
+    Task small([counted]() {});
+    Task large([counted, big]() {});
+    Task moved(std::move(large));
+    ASSERT_EQ(counted.use_count(), 3);
+  }
+  ASSERT_EQ(counted.use_count(), 1);
+}
+
+/// pop everything currently queued
+static size_t
+Drain(TaskQueue& queue)
+{
+  std::array< Task, 64 > batch;
+  size_t total = 0;
+  size_t n;
+  while((n = queue.PopBatch(batch.data(), batch.size())))
+  {
+    for(size_t idx = 0; idx < n; ++idx)
+      batch[idx]();
+    total += n;
+  }
+  return total;
+}
+
+TEST(TaskQueueTest, TestOrderAcrossSegments)
+{
+  TaskQueue queue;
+  ASSERT_TRUE(queue.Empty());
+  const size_t count = TaskQueue::SegmentSize * 3 + 7;
+  std::vector< size_t > order;
+  for(size_t idx = 0; idx < count; ++idx)
+    queue.Push([&order, idx]() { order.push_back(idx); });
+  ASSERT_FALSE(queue.Empty());
+
+  std::array< Task, 10 > batch;
+  ASSERT_EQ(queue.PopBatch(batch.data(), batch.size()), batch.size());
+  for(auto& task : batch)
+    task();
+  ASSERT_EQ(Drain(queue), count - batch.size());
+  ASSERT_TRUE(queue.Empty());
+  ASSERT_EQ(order.size(), count);
+  for(size_t idx = 0; idx < count; ++idx)
+    ASSERT_EQ(order[idx], idx);
+}
+
+TEST(TaskQueueTest, TestRecyclesSegments)
+{
+  TaskQueue queue;
+  size_t calls = 0;
+  for(size_t round = 0; round < 100; ++round)
+  {
+    for(size_t idx = 0; idx < TaskQueue::SegmentSize; ++idx)
+      queue.Push([&calls]() { ++calls; });
+    ASSERT_EQ(Drain(queue), TaskQueue::SegmentSize);
+  }
+  ASSERT_EQ(calls, 100 * TaskQueue::SegmentSize);
+  // steady state needs the head segment and the one being filled
+  ASSERT_LE(queue.SegmentsAllocated(), 3u);
+}
+
+TEST(TaskQueueTest, TestDestroysPending)
+{
+  auto counted = std::make_shared< int >(0);
+  {
+    TaskQueue queue;
+    for(size_t idx = 0; idx < TaskQueue::SegmentSize + 1; ++idx)
+      queue.Push([counted]() {});
+    ASSERT_EQ(counted.use_count(), long(TaskQueue::SegmentSize + 2));
+  }
+  ASSERT_EQ(counted.use_count(), 1);
+}
+
+TEST(TaskQueueTest, TestManyProducers)
+{
+  constexpr size_t Producers   = 4;
+  constexpr size_t PerProducer = 5000;
+  TaskQueue queue;
+  // only the consumer touches these
+  std::array< size_t, Producers > next{};
+  bool ordered = true;
+
+  std::vector< std::thread > threads;
+  for(size_t producer = 0; producer < Producers; ++producer)
+  {
+    threads.emplace_back([&, producer]() {
+      for(size_t seq = 0; seq < PerProducer; ++seq)
+      {
+        queue.Push([&, producer, seq]() {
+          ordered &= next[producer] == seq;
+          ++next[producer];
+        });
+      }
+    });
+  }
+  size_t got          = 0;
+  const auto deadline = std::chrono::steady_clock::now()
+      + std::chrono::seconds(30);
+  while(got < Producers * PerProducer
+        && std::chrono::steady_clock::now() < deadline)
+  {
+    const size_t n = Drain(queue);
+    if(n == 0)
+      std::this_thread::yield();
+    got += n;
+  }
+  for(auto& thread : threads)
+    thread.join();
+  ASSERT_EQ(got, Producers * PerProducer);
+  ASSERT_TRUE(ordered);
+  ASSERT_TRUE(queue.Empty());
+}
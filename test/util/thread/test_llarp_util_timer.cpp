@@ -0,0 +1,124 @@
+#include <util/thread/timer.hpp>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+struct TimerTest : public ::testing::Test
+{
+  llarp_timer_context* ctx = nullptr;
+  llarp_time_t now         = 1000000;
+  std::vector< uint64_t > fired;
+  std::vector< uint64_t > cancelled;
+
+  void
+  SetUp() override
+  {
+    ctx = llarp_init_timer();
+    llarp_timer_set_time(ctx, now);
+  }
+
+  void
+  TearDown() override
+  {
+    llarp_free_timer(&ctx);
+  }
+
+  uint32_t
+  CallLater(uint64_t timeout)
+  {
+    llarp_timeout_job job;
+    job.timeout = timeout;
+    job.user    = this;
+    job.handler = [](void* user, uint64_t orig, uint64_t left) {
+      auto self = static_cast< TimerTest* >(user);
+      if(left)
+        self->cancelled.push_back(orig);
+      else
+        self->fired.push_back(orig);
+    };
+    return llarp_timer_call_later(ctx, job);
+  }
+
+  void
+  AdvanceTo(llarp_time_t t)
+  {
+    now = t;
+    llarp_timer_set_time(ctx, now);
+    llarp_timer_tick_all(ctx);
+  }
+};
+
+TEST_F(TimerTest, FiresInExpiryOrder)
+{
+  CallLater(5000);
+  CallLater(10);
+  CallLater(300);
+  CallLater(70000);
+  AdvanceTo(now + 9);
+  ASSERT_TRUE(fired.empty());
+  AdvanceTo(now + 1);
+  ASSERT_EQ(fired, std::vector< uint64_t >({10}));
+  AdvanceTo(now + 100000);
+  ASSERT_EQ(fired, std::vector< uint64_t >({10, 300, 5000, 70000}));
+}
+
+TEST_F(TimerTest, FiresOnExactDeadlineAcrossLevels)
+{
+  const llarp_time_t start = now;
+  for(uint64_t timeout : {63, 64, 65, 4095, 4096, 4097, 262144})
+  {
+    CallLater(timeout);
+  }
+  for(uint64_t timeout : {63, 64, 65, 4095, 4096, 4097, 262144})
+  {
+    AdvanceTo(start + timeout - 1);
+    ASSERT_EQ(fired.size(), 0u) << timeout;
+    AdvanceTo(start + timeout);
+    ASSERT_EQ(fired, std::vector< uint64_t >({timeout}));
+    fired.clear();
+  }
+}
+
+TEST_F(TimerTest, CancelCallsWithTimeLeft)
+{
+  const auto id = CallLater(1000);
+  AdvanceTo(now + 10);
+  llarp_timer_cancel_job(ctx, id);
+  AdvanceTo(now + 1);
+  ASSERT_TRUE(fired.empty());
+  ASSERT_EQ(cancelled, std::vector< uint64_t >({1000}));
+  AdvanceTo(now + 2000);
+  ASSERT_TRUE(fired.empty());
+}
+
+TEST_F(TimerTest, RemoveNeverCalls)
+{
+  const auto id = CallLater(1000);
+  llarp_timer_remove_job(ctx, id);
+  AdvanceTo(now + 2000);
+  ASSERT_TRUE(fired.empty());
+  ASSERT_TRUE(cancelled.empty());
+}
+
+TEST_F(TimerTest, CallFuncLater)
+{
+  int calls = 0;
+  llarp_timer_call_func_later(ctx, 50, [&calls]() { ++calls; });
+  AdvanceTo(now + 49);
+  ASSERT_EQ(calls, 0);
+  AdvanceTo(now + 1);
+  ASSERT_EQ(calls, 1);
+  AdvanceTo(now + 1000);
+  ASSERT_EQ(calls, 1);
+}
+
+TEST_F(TimerTest, ClockGoingBackwards)
+{
+  CallLater(100);
+  AdvanceTo(now - 50000);
+  ASSERT_TRUE(fired.empty());
+  CallLater(10);
+  AdvanceTo(now + 10);
+  ASSERT_EQ(fired, std::vector< uint64_t >({10}));
+}